@@ -0,0 +1,93 @@
+#include "Common/BenchmarkReport.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef PLATFORM_LINUX
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+void BenchmarkReport::Add(const BenchmarkResult& _result)
+{
+  std::fprintf(stderr, "%-18s %-24s %3u threads %12.2f ns/op",
+               _result.m_suite.c_str(), _result.m_implementation.c_str(),
+               _result.m_threads, _result.m_nsPerOperation);
+  for(const auto& [name, value] : _result.m_metrics)
+    std::fprintf(stderr, "  %s=%.2f", name.c_str(), value);
+  std::fprintf(stderr, "\n");
+
+  m_results.push_back(_result);
+}
+
+void BenchmarkReport::WriteJson(std::ostream& _stream) const
+{
+  _stream << "{\n"
+          << "  \"engine_version\": \"" << PSGE_VERSION << "\",\n"
+          << "  \"benchmarks\": [";
+
+  for(std::size_t i = 0; i < m_results.size(); ++i){
+    const BenchmarkResult& result = m_results[i];
+    _stream << (i == 0 ? "\n" : ",\n")
+            << "    {\"suite\": \"" << result.m_suite << "\""
+            << ", \"implementation\": \"" << result.m_implementation << "\""
+            << ", \"threads\": " << result.m_threads
+            << ", \"operations\": " << result.m_operations
+            << ", \"ns_per_op\": " << result.m_nsPerOperation;
+    for(const auto& [name, value] : result.m_metrics)
+      _stream << ", \"" << name << "\": " << value;
+    _stream << "}";
+  }
+
+  _stream << "\n  ]\n}\n";
+}
+
+CacheMissCounter::CacheMissCounter()
+  : m_fd(-1)
+{
+#ifdef PLATFORM_LINUX
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.type           = PERF_TYPE_HARDWARE;
+  attributes.size           = sizeof(attributes);
+  attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+  attributes.disabled       = 1;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv     = 1;
+
+  m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+#ifdef PLATFORM_LINUX
+  if(m_fd >= 0)
+    close(m_fd);
+#endif
+}
+
+void CacheMissCounter::Start()
+{
+#ifdef PLATFORM_LINUX
+  if(m_fd >= 0){
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+F64 CacheMissCounter::Stop()
+{
+#ifdef PLATFORM_LINUX
+  if(m_fd >= 0){
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    U64 misses = 0;
+    if(read(m_fd, &misses, sizeof(misses)) == sizeof(misses))
+      return static_cast<F64>(misses);
+  }
+#endif
+  return -1.0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file BenchmarkReport.hpp
+ * @brief Results and JSON report shared by the benchmark executables
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BenchmarkReport
+ * @see CacheMissCounter
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct BenchmarkResult
+ * @brief One measurement, written out as one JSON object
+ */
+struct BenchmarkResult
+{
+  /// Suite that took the measurement, e.g. "throughput"
+  std::string m_suite;
+
+  /// Implementation measured, e.g. "malloc" or "flat_hash_map"
+  std::string m_implementation;
+
+  /// Number of threads running
+  U32 m_threads = 1;
+
+  /// Number of operations timed
+  U64 m_operations = 0;
+
+  /// Time per operation
+  F64 m_nsPerOperation = 0.0;
+
+  /// Suite-specific metrics
+  std::vector<std::pair<std::string, F64>> m_metrics;
+};
+
+/**
+ * @class BenchmarkReport
+ * @brief Collects the results of all the suites and writes them as JSON
+ */
+class BenchmarkReport
+{
+public:
+  /// Adds a result, and prints a line about it to stderr
+  void Add(const BenchmarkResult& _result);
+
+  /**
+   * @brief Writes every result as a JSON document
+   * @param _stream stream to write to
+   */
+  void WriteJson(std::ostream& _stream) const;
+
+private:
+  /// Results in the order they were added
+  std::vector<BenchmarkResult> m_results;
+};
+
+/**
+ * @class CacheMissCounter
+ * @brief Counts the hardware cache misses of the calling thread
+ *
+ * Uses perf_event_open on Linux. Where the counter is unavailable, e.g. in
+ * containers or with a strict perf_event_paranoid, IsAvailable() is false
+ * and the suites report the misses as -1.
+ */
+class CacheMissCounter
+{
+public:
+  CacheMissCounter();
+  ~CacheMissCounter();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(CacheMissCounter);
+
+  /// Returns true if the counter could be opened
+  B8 IsAvailable() const { return m_fd >= 0; };
+
+  /// Resets the counter and starts counting
+  void Start();
+
+  /// Stops counting and returns the misses since Start(), -1 if unavailable
+  F64 Stop();
+
+private:
+  /// File descriptor of the perf event, -1 if unavailable
+  int m_fd;
+};
+
+/// Clock every suite times with
+using BenchmarkClock = std::chrono::steady_clock;
+
+/// Returns the nanoseconds elapsed since _start
+inline F64 ElapsedNs(BenchmarkClock::time_point _start)
+{
+  return std::chrono::duration<F64, std::nano>(BenchmarkClock::now() - _start).count();
+}
@@ -0,0 +1,142 @@
+/**
+ * @file Stress.hpp
+ * @brief Shared pieces of the psge_concurrency_stress suites
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see StressOptions
+ * @see StressTracker
+ */
+#pragma once
+
+#include "defines.h"
+#include "Common/BenchmarkReport.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @struct StressOptions
+ * @brief Command line settings shared by every suite
+ */
+struct StressOptions
+{
+  /// Threads pushing items; a deque has a single owner regardless
+  U32 m_producers = 4;
+
+  /// Threads popping items, or stealing them from a deque
+  U32 m_consumers = 4;
+
+  /// Items each producer pushes
+  U64 m_items = 200000;
+
+  /// Capacity of the bounded containers, small to keep them full or empty
+  /// most of the time
+  U32 m_capacity = 64;
+
+  /// Seed of the batch sizes and run lengths each thread picks
+  U32 m_seed = 1234;
+};
+
+/**
+ * @class StressTracker
+ * @brief Checks the items of one run and measures their latency
+ *
+ * Items are (producer, sequence) pairs packed into a U64. Producers stamp an
+ * item right before pushing it and consumers record it right after popping
+ * it; the container orders the two, so the stamps need no atomics. At the
+ * end every item has to have been popped exactly once, and with order
+ * checks on, each consumer has to have seen each producer's items in the
+ * order they were pushed.
+ */
+class StressTracker
+{
+public:
+  /// What one consumer saw, kept by the consumer's thread
+  struct Consumer
+  {
+    /// Last sequence popped from each producer
+    std::vector<I64> m_last;
+
+    /// Push-to-pop latencies
+    std::vector<U32> m_latenciesNs;
+  };
+
+  /**
+   * @brief Creates the tracker
+   * @param _producers number of producers
+   * @param _items items each producer pushes
+   */
+  StressTracker(U32 _producers, U64 _items);
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(StressTracker);
+
+  /// Packs a producer and sequence into an item
+  static U64 MakeItem(U32 _producer, U64 _sequence) { return (U64(_producer) << 40) | _sequence; };
+
+  /// Stamps the push time of an item, right before it is pushed
+  void Stamp(U64 _item);
+
+  /// Returns the state for a new consumer
+  Consumer MakeConsumer() const;
+
+  /**
+   * @brief Records a popped item
+   * @param _item the item
+   * @param _consumer state of the consumer that popped it
+   * @param _checkOrder true to check the producer's items arrive in order
+   */
+  void Record(U64 _item, Consumer& _consumer, B8 _checkOrder = true);
+
+  /// Number of items recorded so far, by every consumer
+  U64 GetRecorded() const { return m_recorded.load(std::memory_order_relaxed); };
+
+  /// Number of items in the run
+  U64 GetTotal() const { return m_total; };
+
+  /**
+   * @brief Checks the run and reports it
+   * @param _implementation name of the container
+   * @param _threads number of threads that ran
+   * @param _elapsedNs duration of the run
+   * @param _consumers states of every consumer
+   * @return True if no item was lost, duplicated or reordered
+   */
+  B8 Finish(const char* _implementation,
+            U32 _threads,
+            F64 _elapsedNs,
+            std::vector<Consumer>& _consumers,
+            BenchmarkReport& _report);
+
+private:
+  /// Index of an item in m_stamps and m_seen
+  std::size_t IndexOf(U64 _item) const;
+
+  const U32 m_producers;
+  const U64 m_items;
+  const U64 m_total;
+
+  /// Push time of every item, in ns of BenchmarkClock
+  std::unique_ptr<I64[]> m_stamps;
+
+  /// Times every item was popped
+  std::unique_ptr<std::atomic<U8>[]> m_seen;
+
+  /// Items popped so far
+  std::atomic<U64> m_recorded;
+
+  /// Items popped before an earlier item of the same producer
+  std::atomic<U64> m_reordered;
+
+  /// Items that don't belong to any producer
+  std::atomic<U64> m_invalid;
+};
+
+/// @name Suites, each returning false if an invariant broke
+/// @{
+B8 RunQueues(const StressOptions& _options, BenchmarkReport& _report);
+B8 RunSPSCRing(const StressOptions& _options, BenchmarkReport& _report);
+B8 RunWorkStealingDeque(const StressOptions& _options, BenchmarkReport& _report);
+/// @}
@@ -0,0 +1,73 @@
+/**
+ * @file deque.cpp
+ * @brief Stress run of the work-stealing deque
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * The owner pushes and pops in runs of random length while the consumers
+ * steal. The owner takes its items newest first, so only the thieves are
+ * held to push order.
+ */
+#include "Stress.hpp"
+#include "Core/DataStructures/WorkStealingDeque.hpp"
+
+#include <random>
+#include <thread>
+
+B8 RunWorkStealingDeque(const StressOptions& _options, BenchmarkReport& _report)
+{
+  // Starts tiny so it grows while being stolen from
+  psl::WorkStealingDeque<U64> deque(2);
+  const U64 items = U64(_options.m_producers) * _options.m_items;
+  StressTracker tracker(1, items);
+  std::vector<StressTracker::Consumer> consumers(_options.m_consumers + 1);
+  std::atomic<U32> ready{0};
+  std::atomic<B8> go{false};
+
+  std::vector<std::thread> thieves;
+  for(U32 t = 0; t < _options.m_consumers; ++t){
+    thieves.emplace_back([&, t](){
+      StressTracker::Consumer consumer = tracker.MakeConsumer();
+      ready.fetch_add(1);
+      while(!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+      U64 item;
+      while(tracker.GetRecorded() < tracker.GetTotal()){
+        if(deque.TrySteal(item))
+          tracker.Record(item, consumer);
+        else
+          std::this_thread::yield();
+      }
+      consumers[t] = std::move(consumer);
+    });
+  }
+
+  while(ready.load() < _options.m_consumers)
+    std::this_thread::yield();
+  auto start = BenchmarkClock::now();
+  go.store(true, std::memory_order_release);
+
+  std::mt19937 random(_options.m_seed);
+  StressTracker::Consumer& owner = consumers.back();
+  owner = tracker.MakeConsumer();
+  U64 sequence = 0;
+  U64 item;
+  while(tracker.GetRecorded() < tracker.GetTotal()){
+    U32 pushes = sequence < items ? random() % 32 : 0;
+    for(U32 i = 0; i < pushes && sequence < items; ++i){
+      item = StressTracker::MakeItem(0, sequence++);
+      tracker.Stamp(item);
+      deque.Push(item);
+    }
+
+    U32 pops = random() % 24;
+    for(U32 i = 0; i < pops && deque.TryPop(item); ++i)
+      tracker.Record(item, owner, false);
+  }
+
+  for(std::thread& thread : thieves)
+    thread.join();
+
+  return tracker.Finish("work_stealing_deque", _options.m_consumers + 1, ElapsedNs(start), consumers, _report);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file main.cpp
+ * @brief Entry point of psge_concurrency_stress
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Drives every concurrent container with the given numbers of producers and
+ * consumers, checks that no item was lost, duplicated or reordered, and
+ * writes throughput and latency percentiles as JSON, to stdout or to the
+ * file given with --json. Exits with 1 if any check failed, so it can run
+ * as a test; configure with -DPSGE_SANITIZER=thread or address to run it
+ * under a sanitizer.
+ *
+ * Usage:
+ * @code
+ *   psge_concurrency_stress [--json file] [--producers n] [--consumers n]
+ *                           [--items n] [--capacity n] [--seed n]
+ *                           [--rounds n]
+ * @endcode
+ */
+#include "Stress.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int _argc, char** _argv)
+{
+  StressOptions options;
+  U32 rounds = 1;
+  std::string jsonPath;
+
+  for(int i = 1; i < _argc; ++i){
+    const char* argument = _argv[i];
+    const char* value = i + 1 < _argc ? _argv[i + 1] : nullptr;
+    if(value == nullptr){
+      std::fprintf(stderr, "Missing value for %s\n", argument);
+      return 1;
+    }
+
+    if(std::strcmp(argument, "--json") == 0)
+      jsonPath = value;
+    else if(std::strcmp(argument, "--producers") == 0)
+      options.m_producers = std::max(1ul, std::strtoul(value, nullptr, 10));
+    else if(std::strcmp(argument, "--consumers") == 0)
+      options.m_consumers = std::max(1ul, std::strtoul(value, nullptr, 10));
+    else if(std::strcmp(argument, "--items") == 0)
+      options.m_items = std::max(1ull, std::strtoull(value, nullptr, 10));
+    else if(std::strcmp(argument, "--capacity") == 0)
+      options.m_capacity = std::max(2ul, std::strtoul(value, nullptr, 10));
+    else if(std::strcmp(argument, "--seed") == 0)
+      options.m_seed = std::strtoul(value, nullptr, 10);
+    else if(std::strcmp(argument, "--rounds") == 0)
+      rounds = std::max(1ul, std::strtoul(value, nullptr, 10));
+    else{
+      std::fprintf(stderr, "Unknown option %s\n", argument);
+      return 1;
+    }
+    ++i;
+  }
+
+  // Each round runs every container again with the next seed
+  BenchmarkReport report;
+  B8 passed = true;
+  for(U32 round = 0; round < rounds; ++round){
+    passed = RunQueues(options, report) && passed;
+    passed = RunSPSCRing(options, report) && passed;
+    passed = RunWorkStealingDeque(options, report) && passed;
+    ++options.m_seed;
+  }
+
+  if(jsonPath.empty()){
+    report.WriteJson(std::cout);
+  }
+  else{
+    std::ofstream file(jsonPath);
+    if(!file.is_open()){
+      std::fprintf(stderr, "Failed to open %s\n", jsonPath.c_str());
+      return 1;
+    }
+    report.WriteJson(file);
+  }
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file queues.cpp
+ * @brief Stress runs of the multi-producer/multi-consumer queues and the
+ *        single-producer/single-consumer ring
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Producers push their items singly or in batches and consumers pop them
+ * singly or in batches, each thread picking at random from its own seed.
+ */
+#include "Stress.hpp"
+#include "Core/DataStructures/MPMCQueue.hpp"
+#include "Core/DataStructures/Queue.hpp"
+#include "Core/DataStructures/SPSCRing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+/// Most items pushed or popped at once
+static constexpr std::size_t s_batch = 16;
+
+/// psl::Queue, which never fills up
+struct MutexQueue
+{
+  static const char* Name() { return "queue"; };
+
+  explicit MutexQueue(std::size_t) {};
+
+  std::size_t Push(const U64* _items, std::size_t _count)
+  {
+    if(_count == 1)
+      m_queue.Push(_items[0]);
+    else
+      m_queue.PushRange(_items, _items + _count);
+    return _count;
+  }
+
+  std::size_t Pop(U64* _items, std::size_t _count)
+  {
+    if(_count == 1)
+      return m_queue.TryPop(_items[0]) ? 1 : 0;
+
+    // Exercise the timed pop as well, it has no batch version
+    return m_queue.TryPopFor(_items[0], std::chrono::microseconds(50)) ? 1 : 0;
+  }
+
+  psl::Queue<U64> m_queue;
+};
+
+/// psl::MPMCQueue, through its single and batch calls
+struct RingQueue
+{
+  static const char* Name() { return "mpmc_queue"; };
+
+  explicit RingQueue(std::size_t _capacity) : m_queue(_capacity) {};
+
+  std::size_t Push(const U64* _items, std::size_t _count)
+  {
+    if(_count == 1)
+      return m_queue.TryPush(_items[0]) ? 1 : 0;
+    return m_queue.TryPushBatch(_items, _count);
+  }
+
+  std::size_t Pop(U64* _items, std::size_t _count)
+  {
+    if(_count == 1)
+      return m_queue.TryPop(_items[0]) ? 1 : 0;
+    return m_queue.TryPopBatch(_items, _count);
+  }
+
+  psl::MPMCQueue<U64> m_queue;
+};
+
+/// Runs the producers and consumers over one queue
+template <typename Queue>
+static B8 StressQueue(const StressOptions& _options, BenchmarkReport& _report)
+{
+  Queue queue(_options.m_capacity);
+  StressTracker tracker(_options.m_producers, _options.m_items);
+  std::vector<StressTracker::Consumer> consumers(_options.m_consumers);
+  const U32 threadCount = _options.m_producers + _options.m_consumers;
+  std::atomic<U32> ready{0};
+  std::atomic<B8> go{false};
+
+  auto waitForStart = [&](){
+    ready.fetch_add(1);
+    while(!go.load(std::memory_order_acquire))
+      std::this_thread::yield();
+  };
+
+  std::vector<std::thread> threads;
+  for(U32 p = 0; p < _options.m_producers; ++p){
+    threads.emplace_back([&, p](){
+      std::mt19937 random(_options.m_seed + p);
+      U64 items[s_batch];
+      waitForStart();
+
+      U64 sequence = 0;
+      while(sequence < _options.m_items){
+        std::size_t count = std::min<U64>(1 + random() % s_batch, _options.m_items - sequence);
+        if(random() % 2 == 0)
+          count = 1;
+        for(std::size_t i = 0; i < count; ++i){
+          items[i] = StressTracker::MakeItem(p, sequence + i);
+          tracker.Stamp(items[i]);
+        }
+
+        std::size_t pushed = queue.Push(items, count);
+        sequence += pushed;
+        if(pushed == 0)
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  for(U32 c = 0; c < _options.m_consumers; ++c){
+    threads.emplace_back([&, c](){
+      std::mt19937 random(_options.m_seed + _options.m_producers + c);
+      StressTracker::Consumer consumer = tracker.MakeConsumer();
+      U64 items[s_batch];
+      waitForStart();
+
+      while(tracker.GetRecorded() < tracker.GetTotal()){
+        std::size_t count = random() % 2 == 0 ? 1 : 1 + random() % s_batch;
+        std::size_t popped = queue.Pop(items, count);
+        for(std::size_t i = 0; i < popped; ++i)
+          tracker.Record(items[i], consumer);
+        if(popped == 0)
+          std::this_thread::yield();
+      }
+      consumers[c] = std::move(consumer);
+    });
+  }
+
+  while(ready.load() < threadCount)
+    std::this_thread::yield();
+  auto start = BenchmarkClock::now();
+  go.store(true, std::memory_order_release);
+  for(std::thread& thread : threads)
+    thread.join();
+
+  return tracker.Finish(Queue::Name(), threadCount, ElapsedNs(start), consumers, _report);
+}
+
+B8 RunQueues(const StressOptions& _options, BenchmarkReport& _report)
+{
+  B8 passed = StressQueue<MutexQueue>(_options, _report);
+  passed = StressQueue<RingQueue>(_options, _report) && passed;
+  return passed;
+}
+
+B8 RunSPSCRing(const StressOptions& _options, BenchmarkReport& _report)
+{
+  // Records of 8 to 64 bytes: the item, then bytes derived from it that the
+  // consumer checks, to catch torn or overwritten records
+  constexpr std::size_t maxRecord = 64;
+  psl::SPSCRing ring(std::size_t(_options.m_capacity) * maxRecord);
+  StressTracker tracker(1, _options.m_items);
+  std::vector<StressTracker::Consumer> consumers(1);
+  std::atomic<U64> corrupted{0};
+
+  auto fill = [](U64 _item, U8* _bytes, std::size_t _size){
+    for(std::size_t i = sizeof(U64); i < _size; ++i)
+      _bytes[i] = U8(_item * 31 + i);
+  };
+
+  auto start = BenchmarkClock::now();
+
+  std::thread producer([&](){
+    std::mt19937 random(_options.m_seed);
+    U8 record[maxRecord];
+    for(U64 sequence = 0; sequence < _options.m_items;){
+      U64 item = StressTracker::MakeItem(0, sequence);
+      std::size_t size = sizeof(U64) + random() % (maxRecord - sizeof(U64) + 1);
+      std::memcpy(record, &item, sizeof(U64));
+      fill(item, record, size);
+      tracker.Stamp(item);
+      if(ring.TryWrite(record, size))
+        ++sequence;
+      else
+        std::this_thread::yield();
+    }
+  });
+
+  std::thread consumer([&](){
+    StressTracker::Consumer state = tracker.MakeConsumer();
+    U8 expected[maxRecord];
+    while(tracker.GetRecorded() < tracker.GetTotal()){
+      B8 read = ring.TryRead([&](const void* _data, std::size_t _size){
+        U64 item;
+        std::memcpy(&item, _data, sizeof(U64));
+        fill(item, expected, _size);
+        if(_size < sizeof(U64) || std::memcmp(expected + sizeof(U64), static_cast<const U8*>(_data) + sizeof(U64), _size - sizeof(U64)) != 0)
+          corrupted.fetch_add(1, std::memory_order_relaxed);
+        tracker.Record(item, state);
+      });
+      if(!read)
+        std::this_thread::yield();
+    }
+    consumers[0] = std::move(state);
+  });
+
+  producer.join();
+  consumer.join();
+
+  B8 passed = tracker.Finish("spsc_ring", 2, ElapsedNs(start), consumers, _report);
+  if(corrupted.load() != 0){
+    std::fprintf(stderr, "spsc_ring FAILED: %llu corrupted records\n", corrupted.load());
+    passed = false;
+  }
+  return passed;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file tracker.cpp
+ * @brief Item checks and latency percentiles of the stress runs
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ */
+#include "Stress.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+/// Nanoseconds of BenchmarkClock since its epoch
+static I64 NowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchmarkClock::now().time_since_epoch()).count();
+}
+
+StressTracker::StressTracker(U32 _producers, U64 _items)
+  : m_producers(_producers),
+    m_items(_items),
+    m_total(U64(_producers) * _items),
+    m_stamps(new I64[m_total]),
+    m_seen(new std::atomic<U8>[m_total]),
+    m_recorded(0),
+    m_reordered(0),
+    m_invalid(0)
+{
+  for(U64 i = 0; i < m_total; ++i)
+    m_seen[i].store(0, std::memory_order_relaxed);
+}
+
+std::size_t StressTracker::IndexOf(U64 _item) const
+{
+  U64 producer = _item >> 40;
+  U64 sequence = _item & ((U64(1) << 40) - 1);
+  if(producer >= m_producers || sequence >= m_items)
+    return std::numeric_limits<std::size_t>::max();
+  return producer * m_items + sequence;
+}
+
+void StressTracker::Stamp(U64 _item)
+{
+  m_stamps[IndexOf(_item)] = NowNs();
+}
+
+StressTracker::Consumer StressTracker::MakeConsumer() const
+{
+  Consumer consumer;
+  consumer.m_last.assign(m_producers, -1);
+  consumer.m_latenciesNs.reserve(m_total / 4);
+  return consumer;
+}
+
+void StressTracker::Record(U64 _item, Consumer& _consumer, B8 _checkOrder)
+{
+  I64 now = NowNs();
+  m_recorded.fetch_add(1, std::memory_order_relaxed);
+
+  std::size_t index = IndexOf(_item);
+  if(index == std::numeric_limits<std::size_t>::max()){
+    m_invalid.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  m_seen[index].fetch_add(1, std::memory_order_relaxed);
+  _consumer.m_latenciesNs.push_back(U32(std::min<I64>(now - m_stamps[index], std::numeric_limits<U32>::max())));
+
+  I64 sequence = I64(index % m_items);
+  I64& last = _consumer.m_last[index / m_items];
+  if(_checkOrder && sequence <= last)
+    m_reordered.fetch_add(1, std::memory_order_relaxed);
+  last = std::max(last, sequence);
+}
+
+B8 StressTracker::Finish(const char* _implementation,
+                         U32 _threads,
+                         F64 _elapsedNs,
+                         std::vector<Consumer>& _consumers,
+                         BenchmarkReport& _report)
+{
+  U64 lost = 0, duplicated = 0;
+  for(U64 i = 0; i < m_total; ++i){
+    U8 seen = m_seen[i].load(std::memory_order_relaxed);
+    lost += seen == 0;
+    duplicated += seen > 1;
+  }
+
+  std::vector<U32> latencies;
+  for(Consumer& consumer : _consumers)
+    latencies.insert(latencies.end(), consumer.m_latenciesNs.begin(), consumer.m_latenciesNs.end());
+  auto percentile = [&](F64 _fraction) -> F64 {
+    if(latencies.empty())
+      return 0.0;
+    auto nth = latencies.begin() + std::size_t(_fraction * (latencies.size() - 1));
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    return *nth;
+  };
+
+  BenchmarkResult result;
+  result.m_suite          = "stress";
+  result.m_implementation = _implementation;
+  result.m_threads        = _threads;
+  result.m_operations     = m_total;
+  result.m_nsPerOperation = _elapsedNs / m_total;
+  result.m_metrics.push_back({"mops_per_s", m_total / _elapsedNs * 1e3});
+  result.m_metrics.push_back({"latency_p50_ns", percentile(0.5)});
+  result.m_metrics.push_back({"latency_p99_ns", percentile(0.99)});
+  result.m_metrics.push_back({"latency_p999_ns", percentile(0.999)});
+  result.m_metrics.push_back({"latency_max_ns", percentile(1.0)});
+  result.m_metrics.push_back({"lost", F64(lost)});
+  result.m_metrics.push_back({"duplicated", F64(duplicated)});
+  result.m_metrics.push_back({"reordered", F64(m_reordered.load())});
+  result.m_metrics.push_back({"invalid", F64(m_invalid.load())});
+  _report.Add(result);
+
+  B8 passed = lost == 0 && duplicated == 0 && m_reordered.load() == 0 && m_invalid.load() == 0;
+  if(!passed)
+    std::fprintf(stderr, "%s FAILED: %llu lost, %llu duplicated, %llu reordered, %llu invalid\n",
+                 _implementation, lost, duplicated, m_reordered.load(), m_invalid.load());
+  return passed;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file Benchmark.hpp
+ * @brief Shared pieces of the psge_datastructures_bench suites
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BenchmarkOptions
+ */
+#pragma once
+
+#include "defines.h"
+#include "Common/BenchmarkReport.hpp"
+
+/**
+ * @struct BenchmarkOptions
+ * @brief Command line settings shared by every suite
+ */
+struct BenchmarkOptions
+{
+  /// Operations per measurement, e.g. lookups into a filled map
+  U64 m_operations = 1000000;
+
+  /// Entries the containers are filled with
+  U64 m_entries = 100000;
+
+  /// Most threads the multi-threaded suites go up to
+  U32 m_maxThreads = 4;
+
+  /// Seed of the random keys and access patterns
+  U32 m_seed = 1234;
+};
+
+/// @name Suites, each in its own file
+/// @{
+void RunHashMap(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunDeque(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunBitset(const BenchmarkOptions& _options, BenchmarkReport& _report);
+/// @}
@@ -0,0 +1,167 @@
+/**
+ * @file bitset.cpp
+ * @brief Bitset bulk operations and signature matching against std::bitset
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Matches a query against one signature per entry the way an ECS query
+ * would, and times AND, popcount and set-bit iteration over a large mask.
+ * Bandwidth is reported next to the time, to compare with the machine's
+ * memory bandwidth. Build with PSGE_ENABLE_AVX2 to measure the AVX2 paths.
+ */
+#include "Benchmark.hpp"
+#include "Core/DataStructures/Bitset.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <random>
+#include <vector>
+
+/// Bits in the masks of the bulk suite
+static constexpr std::size_t s_maskBits = 1 << 22;
+
+/// Times matching every signature against a query, reported per signature
+template <std::size_t BITS>
+static void MeasureMatch(const char* _suite, const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  std::mt19937 random(_options.m_seed);
+  const std::size_t count = _options.m_entries;
+
+  // Each entity has a handful of components, the query asks for two
+  std::vector<FixedBitset<BITS>> signatures(count);
+  std::vector<std::bitset<BITS>> reference(count);
+  for(std::size_t i = 0; i < count; ++i){
+    for(int component = 0; component < 6; ++component){
+      std::size_t bit = random() % BITS;
+      signatures[i].Set(bit);
+      reference[i].set(bit);
+    }
+  }
+  FixedBitset<BITS> query;
+  std::bitset<BITS> referenceQuery;
+  for(std::size_t bit : {std::size_t(1), BITS - 2}){
+    query.Set(bit);
+    referenceQuery.set(bit);
+  }
+
+  std::vector<U32> matches(count);
+  U64 passes = std::max<U64>(1, _options.m_operations / count);
+  volatile std::size_t sink = 0;
+
+  auto report = [&](const char* _implementation, F64 _elapsed){
+    BenchmarkResult result;
+    result.m_suite          = _suite;
+    result.m_implementation = _implementation;
+    result.m_operations     = passes * count;
+    result.m_nsPerOperation = _elapsed / result.m_operations;
+    result.m_metrics.push_back({"gb_per_s", F64(sizeof(FixedBitset<BITS>)) * result.m_operations / _elapsed});
+    result.m_metrics.push_back({"entries", F64(count)});
+    _report.Add(result);
+  };
+
+  auto start = BenchmarkClock::now();
+  for(U64 pass = 0; pass < passes; ++pass){
+    std::size_t found = 0;
+    for(std::size_t i = 0; i < count; ++i){
+      if((reference[i] & referenceQuery) == referenceQuery)
+        matches[found++] = U32(i);
+    }
+    sink = sink + found;
+  }
+  report("std_bitset", ElapsedNs(start));
+
+  start = BenchmarkClock::now();
+  for(U64 pass = 0; pass < passes; ++pass)
+    sink = sink + MatchSignatures(signatures.data(), count, query, matches.data());
+  report("match_signatures", ElapsedNs(start));
+}
+
+/// Same calls over std::bitset
+struct StdMask
+{
+  static const char* Name() { return "std_bitset"; };
+
+  void Set(std::size_t _bit) { m_bits->set(_bit); };
+  void And(const StdMask& _other) { *m_bits &= *_other.m_bits; };
+  std::size_t Count() const { return m_bits->count(); };
+
+  template <typename Function>
+  void ForEachSetBit(Function&& _function) const
+  {
+    for(std::size_t bit = 0; bit < s_maskBits; ++bit){
+      if(m_bits->test(bit))
+        _function(bit);
+    }
+  }
+
+  std::unique_ptr<std::bitset<s_maskBits>> m_bits = std::make_unique<std::bitset<s_maskBits>>();
+};
+
+/// Same calls over Bitset
+struct EngineMask
+{
+  static const char* Name() { return "bitset"; };
+
+  void Set(std::size_t _bit) { m_bits.Set(_bit); };
+  void And(const EngineMask& _other) { m_bits &= _other.m_bits; };
+  std::size_t Count() const { return m_bits.Count(); };
+
+  template <typename Function>
+  void ForEachSetBit(Function&& _function) const { m_bits.ForEachSetBit(_function); };
+
+  Bitset m_bits{s_maskBits};
+};
+
+/// Times AND, popcount and iteration over masks with one bit in 64 set
+template <typename Mask>
+static void MeasureBulk(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  std::mt19937 random(_options.m_seed);
+  Mask first, second;
+  for(std::size_t i = 0; i < s_maskBits / 64; ++i){
+    first.Set(random() % s_maskBits);
+    second.Set(random() % s_maskBits);
+  }
+
+  constexpr int passes = 20;
+  constexpr F64 bytes = s_maskBits / 8;
+  volatile std::size_t sink = 0;
+
+  auto start = BenchmarkClock::now();
+  for(int pass = 0; pass < passes; ++pass)
+    first.And(second);
+  F64 andNs = ElapsedNs(start) / passes;
+
+  start = BenchmarkClock::now();
+  for(int pass = 0; pass < passes; ++pass)
+    sink = sink + second.Count();
+  F64 countNs = ElapsedNs(start) / passes;
+
+  start = BenchmarkClock::now();
+  for(int pass = 0; pass < passes; ++pass){
+    std::size_t sum = 0;
+    second.ForEachSetBit([&](std::size_t _bit) { sum += _bit; });
+    sink = sink + sum;
+  }
+  F64 iterateNs = ElapsedNs(start) / passes;
+
+  BenchmarkResult result;
+  result.m_suite          = "bitset_bulk";
+  result.m_implementation = Mask::Name();
+  result.m_operations     = s_maskBits / 64;
+  result.m_nsPerOperation = andNs / result.m_operations;
+  result.m_metrics.push_back({"and_gb_per_s", 2 * bytes / andNs});
+  result.m_metrics.push_back({"count_gb_per_s", bytes / countNs});
+  result.m_metrics.push_back({"iterate_gb_per_s", bytes / iterateNs});
+  _report.Add(result);
+}
+
+void RunBitset(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  MeasureMatch<64>("bitset_match_64", _options, _report);
+  MeasureMatch<256>("bitset_match_256", _options, _report);
+
+  MeasureBulk<StdMask>(_options, _report);
+  MeasureBulk<EngineMask>(_options, _report);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file deque.cpp
+ * @brief WorkStealingDeque against a mutex-guarded std::deque
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Times the owner working on its own deque alone, then the owner handing out
+ * work the way a task scheduler does while 1 to N-1 thieves steal from it.
+ */
+#include "Benchmark.hpp"
+#include "Core/DataStructures/WorkStealingDeque.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Items the owner pushes before popping them back
+static constexpr U32 s_batch = 64;
+
+/// Same calls over a std::deque behind one mutex
+struct MutexDeque
+{
+  static const char* Name() { return "mutex_deque"; };
+
+  void Push(U32 _item)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_items.push_back(_item);
+  }
+
+  B8 TryPop(U32& _item)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_items.empty())
+      return false;
+    _item = m_items.back();
+    m_items.pop_back();
+    return true;
+  }
+
+  B8 TrySteal(U32& _item)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_items.empty())
+      return false;
+    _item = m_items.front();
+    m_items.pop_front();
+    return true;
+  }
+
+  std::mutex m_mutex;
+  std::deque<U32> m_items;
+};
+
+/// Same calls over WorkStealingDeque
+struct ChaseLevDeque
+{
+  static const char* Name() { return "work_stealing_deque"; };
+
+  void Push(U32 _item) { m_deque.Push(_item); };
+  B8 TryPop(U32& _item) { return m_deque.TryPop(_item); };
+  B8 TrySteal(U32& _item) { return m_deque.TrySteal(_item); };
+
+  psl::WorkStealingDeque<U32> m_deque;
+};
+
+/// Times the owner pushing and popping batches with nobody stealing
+template <typename Deque>
+static void MeasureOwner(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  Deque deque;
+  U64 rounds = _options.m_operations / s_batch;
+  volatile U64 sink = 0;
+  U64 sum = 0;
+
+  auto start = BenchmarkClock::now();
+  for(U64 round = 0; round < rounds; ++round){
+    for(U32 i = 0; i < s_batch; ++i)
+      deque.Push(i);
+    U32 item;
+    while(deque.TryPop(item))
+      sum += item;
+  }
+  F64 elapsed = ElapsedNs(start);
+  sink = sink + sum;
+
+  BenchmarkResult result;
+  result.m_suite          = "deque_owner";
+  result.m_implementation = Deque::Name();
+  result.m_operations     = rounds * s_batch * 2;
+  result.m_nsPerOperation = elapsed / result.m_operations;
+  result.m_metrics.push_back({"mops_per_s", result.m_operations / elapsed * 1e3});
+  _report.Add(result);
+}
+
+/**
+ * @brief Times handing out items while thieves steal them
+ *
+ * The owner pushes a batch and pops half of it, leaving the rest to the
+ * thieves, then helps them finish once everything is pushed.
+ *
+ * @param _threads owner plus thieves
+ */
+template <typename Deque>
+static void MeasureStealing(U32 _threads, const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  Deque deque;
+  U64 items = _options.m_operations / s_batch * s_batch;
+  std::atomic<U64> taken{0};
+  std::atomic<U64> stolen{0};
+  std::atomic<U32> ready{0};
+  std::atomic<B8> go{false};
+
+  auto thief = [&](){
+    ready.fetch_add(1);
+    while(!go.load(std::memory_order_acquire))
+      std::this_thread::yield();
+
+    U64 count = 0;
+    U32 item;
+    while(taken.load(std::memory_order_relaxed) < items){
+      if(deque.TrySteal(item)){
+        taken.fetch_add(1, std::memory_order_relaxed);
+        ++count;
+      }
+    }
+    stolen.fetch_add(count);
+  };
+
+  std::vector<std::thread> thieves;
+  for(U32 i = 1; i < _threads; ++i)
+    thieves.emplace_back(thief);
+  while(ready.load() < _threads - 1)
+    std::this_thread::yield();
+
+  auto start = BenchmarkClock::now();
+  go.store(true, std::memory_order_release);
+  for(U64 pushed = 0; pushed < items; pushed += s_batch){
+    for(U32 i = 0; i < s_batch; ++i)
+      deque.Push(i);
+    // Keep half for itself, leaving the rest to the thieves
+    U32 item;
+    U64 popped = 0;
+    while(popped < s_batch / 2 && deque.TryPop(item))
+      ++popped;
+    taken.fetch_add(popped, std::memory_order_relaxed);
+  }
+
+  // Help with whatever is left
+  U32 item;
+  while(taken.load(std::memory_order_relaxed) < items){
+    if(deque.TryPop(item))
+      taken.fetch_add(1, std::memory_order_relaxed);
+  }
+  F64 elapsed = ElapsedNs(start);
+  for(std::thread& thread : thieves)
+    thread.join();
+
+  BenchmarkResult result;
+  result.m_suite          = "deque_steal";
+  result.m_implementation = Deque::Name();
+  result.m_threads        = _threads;
+  result.m_operations     = items;
+  result.m_nsPerOperation = elapsed / items;
+  result.m_metrics.push_back({"mops_per_s", items / elapsed * 1e3});
+  result.m_metrics.push_back({"stolen_fraction", F64(stolen.load()) / items});
+  _report.Add(result);
+}
+
+void RunDeque(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  MeasureOwner<MutexDeque>(_options, _report);
+  MeasureOwner<ChaseLevDeque>(_options, _report);
+
+  for(U32 threads = 2; threads <= std::max(2u, _options.m_maxThreads); threads *= 2){
+    MeasureStealing<MutexDeque>(threads, _options, _report);
+    MeasureStealing<ChaseLevDeque>(threads, _options, _report);
+  }
+}
@@ -0,0 +1,227 @@
+/**
+ * @file hashmap.cpp
+ * @brief FlatHashMap against std::unordered_map
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Fills both maps with the same keys and times inserting, looking up keys
+ * that are there and keys that aren't, iterating and erasing. Runs with
+ * integer keys, StringId keys and String<32> keys; string keys are also
+ * looked up by const char*, which the FlatHashMap does without building a
+ * String.
+ */
+#include "Benchmark.hpp"
+#include "Core/DataStructures/FlatHashMap.hpp"
+#include "Core/String/StringID.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// Same calls over std::unordered_map
+template <typename K>
+struct StdMap
+{
+  static const char* Name() { return "std_unordered_map"; };
+
+  void Insert(const K& _key, U32 _value) { m_map.emplace(_key, _value); };
+
+  template <typename Key>
+  const U32* Find(const Key& _key) const
+  {
+    // std::unordered_map needs a K, built for every lookup by C string
+    auto entry = m_map.end();
+    if constexpr (std::is_same_v<Key, K>)
+      entry = m_map.find(_key);
+    else
+      entry = m_map.find(static_cast<K>(_key));
+    return entry == m_map.end() ? nullptr : &entry->second;
+  }
+
+  void Erase(const K& _key) { m_map.erase(_key); };
+
+  U64 Sum() const
+  {
+    U64 sum = 0;
+    for(const auto& entry : m_map)
+      sum += entry.second;
+    return sum;
+  }
+
+  std::unordered_map<K, U32> m_map;
+};
+
+/// Same calls over FlatHashMap
+template <typename K>
+struct FlatMap
+{
+  static const char* Name() { return "flat_hash_map"; };
+
+  void Insert(const K& _key, U32 _value) { m_map.TryEmplace(_key, _value); };
+
+  template <typename Key>
+  const U32* Find(const Key& _key) const { return m_map.Get(_key); };
+
+  void Erase(const K& _key) { m_map.Erase(_key); };
+
+  U64 Sum() const
+  {
+    U64 sum = 0;
+    for(const auto& entry : m_map)
+      sum += entry.second;
+    return sum;
+  }
+
+  FlatHashMap<K, U32> m_map;
+};
+
+/**
+ * @brief Times looking up keys, cycling through them
+ * @return Nanoseconds per lookup
+ */
+template <typename Map, typename Key>
+static F64 TimeLookups(const Map& _map, const std::vector<Key>& _keys, U64 _operations)
+{
+  volatile U64 sink = 0;
+  U64 found = 0;
+
+  auto start = BenchmarkClock::now();
+  for(U64 i = 0, index = 0; i < _operations; ++i){
+    const U32* value = _map.Find(_keys[index]);
+    found += value ? *value : 1;
+    if(++index == _keys.size())
+      index = 0;
+  }
+  F64 elapsed = ElapsedNs(start);
+
+  sink = sink + found;
+  return elapsed / _operations;
+}
+
+/**
+ * @brief Runs every measurement on one map and reports it
+ * @param _suite name of the suite, e.g. "hashmap_int"
+ * @param _keys keys to insert, in insertion order
+ * @param _lookups the same keys, shuffled
+ * @param _misses keys that aren't inserted
+ * @param _names the inserted keys as C strings, only used for string keys
+ */
+template <typename Map, typename K>
+static void MeasureMap(const char* _suite,
+                       const std::vector<K>& _keys,
+                       const std::vector<K>& _lookups,
+                       const std::vector<K>& _misses,
+                       const std::vector<const char*>& _names,
+                       const BenchmarkOptions& _options,
+                       BenchmarkReport& _report)
+{
+  Map map;
+
+  auto start = BenchmarkClock::now();
+  for(std::size_t i = 0; i < _keys.size(); ++i)
+    map.Insert(_keys[i], U32(i));
+  F64 insertNs = ElapsedNs(start) / _keys.size();
+
+  F64 hitNs  = TimeLookups(map, _lookups, _options.m_operations);
+  F64 missNs = TimeLookups(map, _misses, _options.m_operations);
+  F64 nameNs = 0.0;
+  if constexpr (std::is_constructible_v<K, const char*>)
+    nameNs = TimeLookups(map, _names, _options.m_operations);
+
+  volatile U64 sink = 0;
+  constexpr int passes = 10;
+  start = BenchmarkClock::now();
+  for(int pass = 0; pass < passes; ++pass)
+    sink = sink + map.Sum();
+  F64 iterateNs = ElapsedNs(start) / (F64(passes) * _keys.size());
+
+  start = BenchmarkClock::now();
+  for(const K& key : _lookups)
+    map.Erase(key);
+  F64 eraseNs = ElapsedNs(start) / _lookups.size();
+
+  BenchmarkResult result;
+  result.m_suite          = _suite;
+  result.m_implementation = Map::Name();
+  result.m_operations     = _options.m_operations;
+  result.m_nsPerOperation = hitNs;
+  result.m_metrics.push_back({"insert_ns", insertNs});
+  result.m_metrics.push_back({"find_hit_ns", hitNs});
+  result.m_metrics.push_back({"find_miss_ns", missNs});
+  if constexpr (std::is_constructible_v<K, const char*>)
+    result.m_metrics.push_back({"find_cstr_ns", nameNs});
+  result.m_metrics.push_back({"iterate_ns", iterateNs});
+  result.m_metrics.push_back({"erase_ns", eraseNs});
+  result.m_metrics.push_back({"entries", F64(_keys.size())});
+  _report.Add(result);
+}
+
+/// Runs both maps over the same keys
+template <typename K>
+static void MeasureBoth(const char* _suite,
+                        std::vector<K> _keys,
+                        std::vector<K> _misses,
+                        const std::vector<const char*>& _names,
+                        const BenchmarkOptions& _options,
+                        BenchmarkReport& _report)
+{
+  std::vector<K> lookups = _keys;
+  std::mt19937 random(_options.m_seed);
+  std::shuffle(lookups.begin(), lookups.end(), random);
+
+  MeasureMap<StdMap<K>>(_suite, _keys, lookups, _misses, _names, _options, _report);
+  MeasureMap<FlatMap<K>>(_suite, _keys, lookups, _misses, _names, _options, _report);
+}
+
+void RunHashMap(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  const U32 entries = U32(_options.m_entries);
+
+  // Integers spread over the whole range, the misses from a disjoint set
+  {
+    std::vector<U32> keys, misses;
+    for(U32 i = 0; i < entries; ++i){
+      keys.push_back((i * 2654435761u) ^ _options.m_seed);
+      misses.push_back(((i + entries) * 2654435761u) ^ _options.m_seed);
+    }
+    MeasureBoth<U32>("hashmap_int", keys, misses, {}, _options, _report);
+  }
+
+  // Strings, and the StringIds they intern to
+  std::vector<S32> strings, missStrings;
+  for(U32 i = 0; i < 2 * entries; ++i){
+    char name[32];
+    std::snprintf(name, sizeof(name), "entity_%u_%u", i, _options.m_seed);
+    (i < entries ? strings : missStrings).push_back(S32(name));
+  }
+
+  {
+    std::unordered_set<StringId> seen;
+    std::vector<StringId> keys, misses;
+    for(const S32& string : strings){
+      StringId id = HashCrc34(string);
+      if(seen.insert(id).second)
+        keys.push_back(id);
+    }
+    for(const S32& string : missStrings){
+      StringId id = HashCrc34(string);
+      if(seen.insert(id).second)
+        misses.push_back(id);
+    }
+    MeasureBoth<StringId>("hashmap_string_id", keys, misses, {}, _options, _report);
+  }
+
+  {
+    std::vector<const char*> names;
+    for(const S32& string : strings)
+      names.push_back(string.Data());
+    std::mt19937 random(_options.m_seed + 1);
+    std::shuffle(names.begin(), names.end(), random);
+
+    MeasureBoth<S32>("hashmap_string32", strings, missStrings, names, _options, _report);
+  }
+}
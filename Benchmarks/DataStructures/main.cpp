@@ -0,0 +1,77 @@
+/**
+ * @file main.cpp
+ * @brief Entry point of psge_datastructures_bench
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Runs every data structure suite and writes the results as JSON, to stdout
+ * or to the file given with --json. A readable line per result goes to
+ * stderr.
+ *
+ * Usage:
+ * @code
+ *   psge_datastructures_bench [--json file] [--operations n] [--entries n]
+ *                             [--threads n] [--seed n]
+ * @endcode
+ */
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int _argc, char** _argv)
+{
+  BenchmarkOptions options;
+  options.m_maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::string jsonPath;
+
+  for(int i = 1; i < _argc; ++i){
+    const char* argument = _argv[i];
+    const char* value = i + 1 < _argc ? _argv[i + 1] : nullptr;
+    if(value == nullptr){
+      std::fprintf(stderr, "Missing value for %s\n", argument);
+      return 1;
+    }
+
+    if(std::strcmp(argument, "--json") == 0)
+      jsonPath = value;
+    else if(std::strcmp(argument, "--operations") == 0)
+      options.m_operations = std::strtoull(value, nullptr, 10);
+    else if(std::strcmp(argument, "--entries") == 0)
+      options.m_entries = std::max(1ull, std::strtoull(value, nullptr, 10));
+    else if(std::strcmp(argument, "--threads") == 0)
+      options.m_maxThreads = std::max(1ul, std::strtoul(value, nullptr, 10));
+    else if(std::strcmp(argument, "--seed") == 0)
+      options.m_seed = std::strtoul(value, nullptr, 10);
+    else{
+      std::fprintf(stderr, "Unknown option %s\n", argument);
+      return 1;
+    }
+    ++i;
+  }
+
+  BenchmarkReport report;
+  RunHashMap(options, report);
+  RunDeque(options, report);
+  RunBitset(options, report);
+
+  if(jsonPath.empty()){
+    report.WriteJson(std::cout);
+  }
+  else{
+    std::ofstream file(jsonPath);
+    if(!file.is_open()){
+      std::fprintf(stderr, "Failed to open %s\n", jsonPath.c_str());
+      return 1;
+    }
+    report.WriteJson(file);
+  }
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file Benchmark.hpp
+ * @brief Shared pieces of the psge_memory_bench suites
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BenchmarkOptions
+ * @see ForEachBackend
+ */
+#pragma once
+
+#include "defines.h"
+#include "Common/BenchmarkReport.hpp"
+#include "Core/Memory/Allocator.hpp"
+
+#include <cstdlib>
+#include <memory_resource>
+
+/**
+ * @struct BenchmarkOptions
+ * @brief Command line settings shared by every suite
+ */
+struct BenchmarkOptions
+{
+  /// Allocations per thread in the throughput and contention suites
+  U64 m_operations = 1000000;
+
+  /// Live objects in the fragmentation and iteration suites
+  U64 m_objects = 100000;
+
+  /// Most threads the contention suite goes up to
+  U32 m_maxThreads = 4;
+
+  /// Seed of the random free patterns
+  U32 m_seed = 1234;
+};
+
+/// Object the suites allocate, a typical component's size
+struct BenchObject
+{
+  U64 m_value;
+  U8  m_payload[56];
+};
+
+/**
+ * @brief The allocators under test, with the same Allocate/Deallocate calls
+ *
+ * Each backend is created once per thread, so the ones that aren't
+ * thread-safe, like std::pmr::unsynchronized_pool_resource, get one instance
+ * per thread as they would in real use.
+ */
+struct MallocBackend
+{
+  static const char* Name() { return "malloc"; };
+  void* Allocate() { return std::malloc(sizeof(BenchObject)); };
+  void Deallocate(void* _block) { std::free(_block); };
+};
+
+struct NewBackend
+{
+  static const char* Name() { return "new"; };
+  void* Allocate() { return ::operator new(sizeof(BenchObject)); };
+  void Deallocate(void* _block) { ::operator delete(_block); };
+};
+
+struct PmrPoolBackend
+{
+  static const char* Name() { return "pmr_unsynchronized_pool"; };
+  void* Allocate() { return m_resource.allocate(sizeof(BenchObject), alignof(BenchObject)); };
+  void Deallocate(void* _block) { m_resource.deallocate(_block, sizeof(BenchObject), alignof(BenchObject)); };
+
+  std::pmr::unsynchronized_pool_resource m_resource;
+};
+
+struct PoolBackend
+{
+  static const char* Name() { return "pool_allocator"; };
+  void* Allocate() { return GetPool().Allocate(); };
+  void Deallocate(void* _block) { GetPool().Deallocate(static_cast<BenchObject*>(_block)); };
+
+  /// One pool shared by every thread
+  static PoolAllocator<BenchObject>& GetPool()
+  {
+    static PoolAllocator<BenchObject> pool;
+    return pool;
+  }
+};
+
+struct MemoryManagerBackend
+{
+  static const char* Name() { return "memory_manager"; };
+  void* Allocate() { return MEMALLOC().Allocate<BenchObject>(); };
+  void Deallocate(void* _block) { MEMALLOC().Deallocate(static_cast<BenchObject*>(_block)); };
+};
+
+struct SmallObjectBackend
+{
+  static const char* Name() { return "small_object_resource"; };
+  void* Allocate() { return m_resource.allocate(sizeof(BenchObject), alignof(BenchObject)); };
+  void Deallocate(void* _block) { m_resource.deallocate(_block, sizeof(BenchObject), alignof(BenchObject)); };
+
+  std::pmr::memory_resource& m_resource = SmallObjectMemoryResource::GetInstance();
+};
+
+/**
+ * @brief Calls _function once for every backend type
+ * @param _function generic callable taking a backend by value, e.g. a
+ *        lambda with an auto parameter
+ */
+template <typename Function>
+void ForEachBackend(Function&& _function)
+{
+  _function(MallocBackend());
+  _function(NewBackend());
+  _function(PmrPoolBackend());
+  _function(PoolBackend());
+  _function(MemoryManagerBackend());
+  _function(SmallObjectBackend());
+}
+
+/// @name Suites, each in its own file
+/// @{
+void RunThroughput(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunContention(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunFragmentation(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunIteration(const BenchmarkOptions& _options, BenchmarkReport& _report);
+void RunContainers(const BenchmarkOptions& _options, BenchmarkReport& _report);
+/// @}
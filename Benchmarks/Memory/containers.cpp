@@ -0,0 +1,142 @@
+/**
+ * @file containers.cpp
+ * @brief Heap allocations per frame of the engine's containers, with and
+ *        without the std::pmr engine allocators
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Simulates the container traffic of a frame: entities and components added
+ * and removed, tasks queued and drained, a few handlers subscribed. Each
+ * frame is run once with the containers on the global heap and once with
+ * them on SmallObjectMemoryResource, counting the calls to the global
+ * operator new.
+ */
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+/// Calls to the global operator new so far, per thread so that counting
+/// doesn't add contention to the other suites
+static thread_local U64 g_heapAllocations = 0;
+
+void* operator new(std::size_t _size)
+{
+  ++g_heapAllocations;
+  if(void* block = std::malloc(_size ? _size : 1))
+    return block;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* _block) noexcept
+{
+  std::free(_block);
+}
+
+void operator delete(void* _block, std::size_t) noexcept
+{
+  std::free(_block);
+}
+
+void* operator new(std::size_t _size, std::align_val_t _alignment)
+{
+  ++g_heapAllocations;
+  std::size_t alignment = static_cast<std::size_t>(_alignment);
+  std::size_t size = (_size + alignment - 1) / alignment * alignment;
+  if(void* block = std::aligned_alloc(alignment, size ? size : alignment))
+    return block;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* _block, std::align_val_t) noexcept
+{
+  std::free(_block);
+}
+
+void operator delete(void* _block, std::size_t, std::align_val_t) noexcept
+{
+  std::free(_block);
+}
+
+/// Number of simulated frames
+static constexpr int s_frames = 200;
+
+/// Entities created and destroyed every frame
+static constexpr U32 s_entitiesPerFrame = 256;
+
+/// Tasks queued every frame
+static constexpr int s_tasksPerFrame = 64;
+
+struct ComponentA {};
+struct ComponentB {};
+
+/**
+ * @brief Runs the frames over containers allocating from _resource
+ * @param _resource resource for the containers
+ * @param _name label of the run
+ * @param _report report to add the result to, nullptr for a warm-up
+ */
+static void RunFrames(std::pmr::memory_resource* _resource, const char* _name, BenchmarkReport* _report)
+{
+  std::pmr::vector<U32> entities(_resource);
+  std::pmr::unordered_map<std::type_index, std::pmr::unordered_map<U32, void*>> components(_resource);
+  std::pmr::list<void*> tasks(_resource);
+  std::pmr::map<int, std::pmr::vector<std::function<void()>>> handlers(_resource);
+
+  U64 heapBefore = g_heapAllocations;
+  auto start = BenchmarkClock::now();
+
+  U32 nextId = 0;
+  for(int frame = 0; frame < s_frames; ++frame){
+    for(U32 i = 0; i < s_entitiesPerFrame; ++i){
+      U32 id = nextId++;
+      entities.push_back(id);
+      components[typeid(ComponentA)][id] = nullptr;
+      if(id % 2 == 0)
+        components[typeid(ComponentB)][id] = nullptr;
+    }
+
+    for(int i = 0; i < s_tasksPerFrame; ++i)
+      tasks.push_back(nullptr);
+    while(!tasks.empty())
+      tasks.pop_front();
+
+    handlers[frame % 8].push_back([](){});
+
+    // Destroy last frame's entities
+    for(U32 id : entities){
+      for(auto& componentArray : components)
+        componentArray.second.erase(id);
+    }
+    entities.clear();
+  }
+
+  F64 elapsed = ElapsedNs(start);
+  U64 heapAllocations = g_heapAllocations - heapBefore;
+  if(_report == nullptr)
+    return;
+
+  BenchmarkResult result;
+  result.m_suite          = "containers";
+  result.m_implementation = _name;
+  result.m_operations     = s_frames;
+  result.m_nsPerOperation = elapsed / s_frames;
+  result.m_metrics.push_back({"heap_allocations_per_frame", F64(heapAllocations) / s_frames});
+  _report->Add(result);
+}
+
+void RunContainers(const BenchmarkOptions&, BenchmarkReport& _report)
+{
+  // Warm the pools up, so the runs only measure steady-state frames
+  RunFrames(&SmallObjectMemoryResource::GetInstance(), "small_object_resource", nullptr);
+
+  RunFrames(std::pmr::new_delete_resource(), "new", &_report);
+  RunFrames(&SmallObjectMemoryResource::GetInstance(), "small_object_resource", &_report);
+}
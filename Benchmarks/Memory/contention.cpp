@@ -0,0 +1,63 @@
+/**
+ * @file contention.cpp
+ * @brief Allocate/free throughput of each allocator with 1 to N threads
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ */
+#include "Benchmark.hpp"
+
+#include <atomic>
+#include <thread>
+
+/// Objects each thread allocates before freeing them all again
+static constexpr std::size_t s_batch = 64;
+
+void RunContention(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  for(U32 threads = 1; threads <= _options.m_maxThreads; threads *= 2){
+    ForEachBackend([&](auto _backend){
+      using Backend = decltype(_backend);
+
+      U64 rounds = _options.m_operations / s_batch;
+      std::atomic<U32> ready{0};
+      std::atomic<B8> go{false};
+
+      auto worker = [&](){
+        Backend backend;
+        void* blocks[s_batch];
+
+        ready.fetch_add(1);
+        while(!go.load(std::memory_order_acquire))
+          std::this_thread::yield();
+
+        for(U64 round = 0; round < rounds; ++round){
+          for(std::size_t i = 0; i < s_batch; ++i)
+            blocks[i] = backend.Allocate();
+          for(std::size_t i = s_batch; i-- > 0;)
+            backend.Deallocate(blocks[i]);
+        }
+      };
+
+      std::vector<std::thread> workers;
+      for(U32 i = 0; i < threads; ++i)
+        workers.emplace_back(worker);
+      while(ready.load() < threads)
+        std::this_thread::yield();
+
+      auto start = BenchmarkClock::now();
+      go.store(true, std::memory_order_release);
+      for(auto& thread : workers)
+        thread.join();
+      F64 elapsed = ElapsedNs(start);
+
+      BenchmarkResult result;
+      result.m_suite          = "contention";
+      result.m_implementation = Backend::Name();
+      result.m_threads        = threads;
+      result.m_operations     = rounds * s_batch * threads;
+      result.m_nsPerOperation = elapsed / result.m_operations;
+      result.m_metrics.push_back({"mops_per_s", result.m_operations / elapsed * 1e3});
+      _report.Add(result);
+    });
+  }
+}
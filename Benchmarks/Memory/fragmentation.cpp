@@ -0,0 +1,125 @@
+/**
+ * @file fragmentation.cpp
+ * @brief How scattered each allocator leaves its objects after random frees
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Allocates a population of objects, kept in a vector that is walked in
+ * order, then churns it: a few rounds of freeing a random half and
+ * allocating the half back into the same places. Finally a random half is
+ * freed for good. Reported:
+ *  - same_page_before/after: share of neighbours in walk order that sit on
+ *    the same 4 KiB page, before and after the churn. Churn through a LIFO
+ *    free list scatters the walk, which this shows.
+ *  - median_gap_lines_before/after: median distance between neighbours in
+ *    walk order, in cache lines. The median so that the odd jump between
+ *    separate chunks doesn't swamp it.
+ *  - live_pages_ratio: pages the remaining half touches over the pages it
+ *    would fill if packed, so the memory held by holes.
+ */
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+/// Size of the pages the locality is measured in
+static constexpr std::uintptr_t FRAGMENTATION_PAGE_SIZE = 4096;
+
+/// Rounds of freeing a random half and allocating it back
+static constexpr int FRAGMENTATION_CHURN_ROUNDS = 4;
+
+static std::uintptr_t Address(const void* _block)
+{
+  return reinterpret_cast<std::uintptr_t>(_block);
+}
+
+/// Returns the share of neighbours in walk order that share a page
+static F64 SamePageRatio(const std::vector<void*>& _blocks)
+{
+  std::size_t same = 0;
+  for(std::size_t i = 1; i < _blocks.size(); ++i)
+    same += Address(_blocks[i]) / FRAGMENTATION_PAGE_SIZE == Address(_blocks[i - 1]) / FRAGMENTATION_PAGE_SIZE;
+  return F64(same) / F64(_blocks.size() - 1);
+}
+
+/// Returns the median distance between neighbours in walk order, in lines
+static F64 MedianGapLines(const std::vector<void*>& _blocks)
+{
+  std::vector<std::uintptr_t> gaps;
+  gaps.reserve(_blocks.size() - 1);
+  for(std::size_t i = 1; i < _blocks.size(); ++i){
+    std::uintptr_t a = Address(_blocks[i - 1]);
+    std::uintptr_t b = Address(_blocks[i]);
+    gaps.push_back(a > b ? a - b : b - a);
+  }
+  std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+  return F64(gaps[gaps.size() / 2]) / 64.0;
+}
+
+/// Returns the pages the blocks touch over the pages they'd fill if packed
+static F64 LivePagesRatio(const std::vector<void*>& _blocks)
+{
+  std::unordered_set<std::uintptr_t> pages;
+  for(void* block : _blocks){
+    pages.insert(Address(block) / FRAGMENTATION_PAGE_SIZE);
+    pages.insert((Address(block) + sizeof(BenchObject) - 1) / FRAGMENTATION_PAGE_SIZE);
+  }
+  F64 packed = F64(_blocks.size() * sizeof(BenchObject)) / FRAGMENTATION_PAGE_SIZE;
+  return F64(pages.size()) / std::max(packed, 1.0);
+}
+
+void RunFragmentation(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  ForEachBackend([&](auto _backend){
+    std::mt19937 random(_options.m_seed);
+
+    std::vector<void*> blocks(_options.m_objects);
+    for(void*& block : blocks)
+      block = _backend.Allocate();
+    F64 samePageBefore = SamePageRatio(blocks);
+    F64 gapBefore = MedianGapLines(blocks);
+
+    // Free a random half and allocate it back into the same places
+    std::vector<std::size_t> order(blocks.size());
+    for(std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::size_t half = blocks.size() / 2;
+
+    auto start = BenchmarkClock::now();
+    for(int round = 0; round < FRAGMENTATION_CHURN_ROUNDS; ++round){
+      std::shuffle(order.begin(), order.end(), random);
+      for(std::size_t i = 0; i < half; ++i)
+        _backend.Deallocate(blocks[order[i]]);
+      for(std::size_t i = 0; i < half; ++i)
+        blocks[order[i]] = _backend.Allocate();
+    }
+    F64 elapsed = ElapsedNs(start);
+
+    F64 samePageAfter = SamePageRatio(blocks);
+    F64 gapAfter = MedianGapLines(blocks);
+
+    // Free a random half for good, the rest keeps its pages alive
+    std::shuffle(blocks.begin(), blocks.end(), random);
+    for(std::size_t i = 0; i < half; ++i)
+      _backend.Deallocate(blocks[i]);
+    blocks.erase(blocks.begin(), blocks.begin() + half);
+
+    BenchmarkResult result;
+    result.m_suite          = "fragmentation";
+    result.m_implementation = _backend.Name();
+    result.m_operations     = half * 2 * FRAGMENTATION_CHURN_ROUNDS;
+    result.m_nsPerOperation = elapsed / result.m_operations;
+    result.m_metrics.push_back({"same_page_before", samePageBefore});
+    result.m_metrics.push_back({"same_page_after", samePageAfter});
+    result.m_metrics.push_back({"median_gap_lines_before", gapBefore});
+    result.m_metrics.push_back({"median_gap_lines_after", gapAfter});
+    result.m_metrics.push_back({"live_pages_ratio", LivePagesRatio(blocks)});
+    _report.Add(result);
+
+    for(void* block : blocks)
+      _backend.Deallocate(block);
+  });
+}
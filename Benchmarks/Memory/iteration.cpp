@@ -0,0 +1,103 @@
+/**
+ * @file iteration.cpp
+ * @brief Cost of walking objects allocated by each allocator
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Walks a population of objects the way a system walks its components,
+ * once fresh and once after a random half was freed and allocated back.
+ * A HandlePool that was compacted after the churn is measured too.
+ */
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <random>
+
+/// Walks over the objects this many times per measurement
+static constexpr int s_passes = 10;
+
+/**
+ * @brief Times walking the objects and reports it
+ * @param _objects objects to walk, in the order a system would
+ * @param _layout "fresh" or "churned"
+ * @param _allocator name of the allocator
+ */
+static void MeasureWalk(const std::vector<BenchObject*>& _objects,
+                        const char* _layout,
+                        const char* _allocator,
+                        BenchmarkReport& _report)
+{
+  CacheMissCounter misses;
+  volatile U64 sink = 0;
+
+  misses.Start();
+  auto start = BenchmarkClock::now();
+  for(int pass = 0; pass < s_passes; ++pass){
+    U64 sum = 0;
+    for(BenchObject* object : _objects)
+      sum += object->m_value;
+    sink = sink + sum;
+  }
+  F64 elapsed = ElapsedNs(start);
+  F64 missCount = misses.Stop();
+
+  U64 visits = _objects.size() * s_passes;
+  BenchmarkResult result;
+  result.m_suite          = std::string("iteration_") + _layout;
+  result.m_implementation = _allocator;
+  result.m_operations     = visits;
+  result.m_nsPerOperation = elapsed / visits;
+  result.m_metrics.push_back({"cache_misses_per_object", missCount < 0 ? -1.0 : missCount / visits});
+  _report.Add(result);
+}
+
+void RunIteration(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  ForEachBackend([&](auto _backend){
+    std::mt19937 random(_options.m_seed);
+
+    std::vector<BenchObject*> objects(_options.m_objects);
+    for(std::size_t i = 0; i < objects.size(); ++i){
+      objects[i] = static_cast<BenchObject*>(_backend.Allocate());
+      objects[i]->m_value = i;
+    }
+    MeasureWalk(objects, "fresh", _backend.Name(), _report);
+
+    // Replace a random half, the walk order stays the same
+    std::vector<std::size_t> order(objects.size());
+    for(std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    std::shuffle(order.begin(), order.end(), random);
+    std::size_t half = order.size() / 2;
+    for(std::size_t i = 0; i < half; ++i)
+      _backend.Deallocate(objects[order[i]]);
+    for(std::size_t i = 0; i < half; ++i){
+      objects[order[i]] = static_cast<BenchObject*>(_backend.Allocate());
+      objects[order[i]]->m_value = order[i];
+    }
+    MeasureWalk(objects, "churned", _backend.Name(), _report);
+
+    for(BenchObject* object : objects)
+      _backend.Deallocate(object);
+  });
+
+  // Same churn on a HandlePool, compacted before the walk
+  std::mt19937 random(_options.m_seed);
+  HandlePool<BenchObject> pool(_options.m_objects);
+  std::vector<Handle<BenchObject>> handles(_options.m_objects);
+  for(std::size_t i = 0; i < handles.size(); ++i)
+    handles[i] = pool.Create(BenchObject{i, {}});
+
+  std::shuffle(handles.begin(), handles.end(), random);
+  std::size_t half = handles.size() / 2;
+  for(std::size_t i = 0; i < half; ++i)
+    pool.Destroy(handles[i]);
+  for(std::size_t i = 0; i < half; ++i)
+    handles[i] = pool.Create(BenchObject{i, {}});
+  pool.Compact();
+
+  std::vector<BenchObject*> objects(pool.GetCount());
+  for(std::size_t i = 0; i < objects.size(); ++i)
+    objects[i] = pool.GetData() + i;
+  MeasureWalk(objects, "churned", "handle_pool_compacted", _report);
+}
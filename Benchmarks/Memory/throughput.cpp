@@ -0,0 +1,58 @@
+/**
+ * @file throughput.cpp
+ * @brief Single-threaded allocate/free throughput of each allocator
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ */
+#include "Benchmark.hpp"
+
+/// Objects allocated before they are all freed again
+static constexpr std::size_t s_batch = 64;
+
+void RunThroughput(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  ForEachBackend([&](auto _backend){
+    void* blocks[s_batch];
+    U64 rounds = _options.m_operations / s_batch;
+
+    // One round untimed, so pools are already set up
+    for(std::size_t i = 0; i < s_batch; ++i)
+      blocks[i] = _backend.Allocate();
+    for(std::size_t i = 0; i < s_batch; ++i)
+      _backend.Deallocate(blocks[i]);
+
+    auto start = BenchmarkClock::now();
+    for(U64 round = 0; round < rounds; ++round){
+      for(std::size_t i = 0; i < s_batch; ++i)
+        blocks[i] = _backend.Allocate();
+      for(std::size_t i = s_batch; i-- > 0;)
+        _backend.Deallocate(blocks[i]);
+    }
+    F64 elapsed = ElapsedNs(start);
+
+    BenchmarkResult result;
+    result.m_suite          = "throughput";
+    result.m_implementation = _backend.Name();
+    result.m_operations     = rounds * s_batch;
+    result.m_nsPerOperation = elapsed / result.m_operations;
+    _report.Add(result);
+  });
+
+  // Frame arena for reference, it never frees
+  FRAMEALLOC().NextFrame();
+  U64 operations = _options.m_operations;
+  auto start = BenchmarkClock::now();
+  for(U64 i = 0; i < operations; ++i){
+    if(i % 16384 == 0)
+      FRAMEALLOC().NextFrame();
+    FRAMEALLOC().Allocate<BenchObject>();
+  }
+  F64 elapsed = ElapsedNs(start);
+
+  BenchmarkResult result;
+  result.m_suite          = "throughput";
+  result.m_implementation = "frame_allocator";
+  result.m_operations     = operations;
+  result.m_nsPerOperation = elapsed / operations;
+  _report.Add(result);
+}
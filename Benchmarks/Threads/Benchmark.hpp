@@ -0,0 +1,35 @@
+/**
+ * @file Benchmark.hpp
+ * @brief Shared pieces of the psge_task_bench suites
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BenchmarkOptions
+ */
+#pragma once
+
+#include "defines.h"
+#include "Common/BenchmarkReport.hpp"
+
+/**
+ * @struct BenchmarkOptions
+ * @brief Command line settings shared by every suite
+ */
+struct BenchmarkOptions
+{
+  /// Worker threads of the task manager, what task_manager_threads sets in
+  /// the engine's config. The manager is a singleton, so one run measures
+  /// one count.
+  U32 m_threads = 4;
+
+  /// Tasks per measurement
+  U64 m_tasks = 100000;
+
+  /// Bursts in the burst suite, and frames in the graph suite
+  U32 m_rounds = 200;
+};
+
+/// @name Suites, each in its own file
+/// @{
+void RunDispatch(const BenchmarkOptions& _options, BenchmarkReport& _report);
+/// @}
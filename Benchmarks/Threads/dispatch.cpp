@@ -0,0 +1,149 @@
+/**
+ * @file dispatch.cpp
+ * @brief Task dispatch throughput of the task manager
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Times near-empty tasks, so what is left is the cost of getting them to a
+ * worker and noticing they ran:
+ *  - submit: a thread outside the pool submits every task, through the
+ *    injection queue.
+ *  - fan_out: one task submits every task from a worker, onto its own deque,
+ *    and the other workers steal them.
+ *  - burst: small fan-outs after the workers have fallen asleep, so each
+ *    one pays for waking them.
+ *  - graph: a registered root, a wide middle and a join, run per Update().
+ * Task creation is kept out of the timings.
+ */
+#include "Benchmark.hpp"
+
+#include "Core/Threads/TaskManager.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace psge;
+
+/// Tasks per burst in the burst suite
+static constexpr U32 DISPATCH_BURST_TASKS = 64;
+
+/// Time given to the workers to fall asleep between bursts
+static constexpr auto DISPATCH_BURST_PAUSE = std::chrono::milliseconds(2);
+
+/// Tasks in the middle of the graph suite's graph
+static constexpr U32 DISPATCH_GRAPH_WIDTH = 64;
+
+/// Counts the runs, so the tasks aren't entirely empty
+static std::atomic<U64> s_runs{0};
+
+static TaskPtr MakeTask()
+{
+  return std::make_shared<Task>([](){ s_runs.fetch_add(1, std::memory_order_relaxed); });
+}
+
+static std::vector<TaskPtr> MakeTasks(U64 _count)
+{
+  std::vector<TaskPtr> tasks;
+  tasks.reserve(_count);
+  for(U64 i = 0; i < _count; ++i)
+    tasks.push_back(MakeTask());
+  return tasks;
+}
+
+/// Lets go of the submitted tasks, which the manager keeps until an Update()
+static void ReleaseSubmitted(TaskManager& _manager)
+{
+  _manager.Update(0.0f);
+  _manager.Wait();
+}
+
+static void AddResult(const BenchmarkOptions& _options,
+                      BenchmarkReport& _report,
+                      const char* _suite,
+                      U64 _tasks,
+                      F64 _elapsedNs)
+{
+  BenchmarkResult result;
+  result.m_suite          = _suite;
+  result.m_implementation = "task_manager";
+  result.m_threads        = _options.m_threads;
+  result.m_operations     = _tasks;
+  result.m_nsPerOperation = _elapsedNs / F64(_tasks);
+  result.m_metrics.push_back({"tasks_per_second", 1e9 * F64(_tasks) / _elapsedNs});
+  _report.Add(result);
+}
+
+void RunDispatch(const BenchmarkOptions& _options, BenchmarkReport& _report)
+{
+  TaskManager& manager = TaskManager::GetInstance();
+  manager.Initialize(U8(_options.m_threads));
+
+  // Submitted from outside the pool
+  {
+    std::vector<TaskPtr> tasks = MakeTasks(_options.m_tasks);
+    auto start = BenchmarkClock::now();
+    for(TaskPtr& task : tasks)
+      manager.Submit(std::move(task));
+    manager.Wait();
+    AddResult(_options, _report, "submit", _options.m_tasks, ElapsedNs(start));
+    ReleaseSubmitted(manager);
+  }
+
+  // Submitted from a worker, so they land on its deque
+  {
+    std::vector<TaskPtr> tasks = MakeTasks(_options.m_tasks);
+    auto parent = std::make_shared<Task>([&](){
+      for(TaskPtr& task : tasks)
+        manager.Submit(std::move(task));
+    });
+    auto start = BenchmarkClock::now();
+    manager.Submit(parent);
+    manager.Wait();
+    AddResult(_options, _report, "fan_out", _options.m_tasks, ElapsedNs(start));
+    ReleaseSubmitted(manager);
+  }
+
+  // Fan-outs into sleeping workers
+  {
+    F64 elapsed = 0.0;
+    for(U32 round = 0; round < _options.m_rounds; ++round){
+      std::vector<TaskPtr> tasks = MakeTasks(DISPATCH_BURST_TASKS);
+      auto parent = std::make_shared<Task>([&](){
+        for(TaskPtr& task : tasks)
+          manager.Submit(std::move(task));
+      });
+      std::this_thread::sleep_for(DISPATCH_BURST_PAUSE);
+
+      auto start = BenchmarkClock::now();
+      manager.Submit(parent);
+      manager.Wait();
+      elapsed += ElapsedNs(start);
+      ReleaseSubmitted(manager);
+    }
+    AddResult(_options, _report, "burst", U64(_options.m_rounds) * DISPATCH_BURST_TASKS, elapsed);
+  }
+
+  // Registered graph, the way systems run every frame. Registered tasks stay
+  // with the manager, so this goes last.
+  {
+    TaskPtr root = MakeTask();
+    TaskPtr join = MakeTask();
+    for(U32 i = 0; i < DISPATCH_GRAPH_WIDTH; ++i){
+      TaskPtr middle = MakeTask();
+      middle->AddDependency(root);
+      join->AddDependency(middle);
+      manager.RegisterTask(middle);
+    }
+    manager.RegisterTask(root);
+    manager.RegisterTask(join);
+
+    auto start = BenchmarkClock::now();
+    for(U32 frame = 0; frame < _options.m_rounds; ++frame)
+      manager.Update(0.016f);
+    manager.Wait();
+    AddResult(_options, _report, "graph", U64(_options.m_rounds) * (DISPATCH_GRAPH_WIDTH + 2), ElapsedNs(start));
+  }
+}
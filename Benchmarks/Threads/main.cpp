@@ -0,0 +1,72 @@
+/**
+ * @file main.cpp
+ * @brief Entry point of psge_task_bench
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * Measures how fast the task manager dispatches tasks with the given number
+ * of workers, and writes the results as JSON, to stdout or to the file
+ * given with --json. A readable line per result goes to stderr. The task
+ * manager is a singleton, so sweeping the worker count takes one run per
+ * count; the TaskDispatch tests do that for 1, 2, 4 and 8 workers.
+ *
+ * Usage:
+ * @code
+ *   psge_task_bench [--json file] [--threads n] [--tasks n] [--rounds n]
+ * @endcode
+ */
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int _argc, char** _argv)
+{
+  BenchmarkOptions options;
+  std::string jsonPath;
+
+  for(int i = 1; i < _argc; ++i){
+    const char* argument = _argv[i];
+    const char* value = i + 1 < _argc ? _argv[i + 1] : nullptr;
+    if(value == nullptr){
+      std::fprintf(stderr, "Missing value for %s\n", argument);
+      return 1;
+    }
+
+    if(std::strcmp(argument, "--json") == 0)
+      jsonPath = value;
+    else if(std::strcmp(argument, "--threads") == 0)
+      options.m_threads = std::clamp(std::strtoul(value, nullptr, 10), 1ul, 255ul);
+    else if(std::strcmp(argument, "--tasks") == 0)
+      options.m_tasks = std::max(1ull, std::strtoull(value, nullptr, 10));
+    else if(std::strcmp(argument, "--rounds") == 0)
+      options.m_rounds = std::max(1ul, std::strtoul(value, nullptr, 10));
+    else{
+      std::fprintf(stderr, "Unknown option %s\n", argument);
+      return 1;
+    }
+    ++i;
+  }
+
+  BenchmarkReport report;
+  RunDispatch(options, report);
+
+  if(jsonPath.empty()){
+    report.WriteJson(std::cout);
+  }
+  else{
+    std::ofstream file(jsonPath);
+    if(!file.is_open()){
+      std::fprintf(stderr, "Failed to open %s\n", jsonPath.c_str());
+      return 1;
+    }
+    report.WriteJson(file);
+  }
+
+  return 0;
+}
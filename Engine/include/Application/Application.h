@@ -69,6 +69,9 @@ public:
   /** 
    * @brief User-defined to update game sim at every step. To-overwrite
    *
+   * Scratch memory that is only needed for this frame can be taken from
+   * FRAMEALLOC() instead of the heap.
+   *
    * @param _delta time step from the last frame for simulation
    *
    * @todo TODO: Use a timestep class instead of F64!
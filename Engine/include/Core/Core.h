@@ -10,6 +10,7 @@
 #include "Core/Config/ConfigParser.h"
 
 #include "Core/DataStructures/Queue.hpp"
+#include "Core/DataStructures/EpochReclaimer.hpp"
 
 #include "Core/String/String.hpp"
 
@@ -0,0 +1,466 @@
+/**
+ * @file Bitset.hpp
+ * @brief Fixed-size and dynamic bitsets with SIMD bulk operations
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BitOps
+ * @see FixedBitset
+ * @see Bitset
+ * @see MatchSignatures
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define BITSET_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define BITSET_SSE2 1
+#endif
+
+/**
+ * @struct BitOps
+ * @brief Operations over runs of 64-bit words, four words at a time with
+ *        AVX2, two with SSE2, one otherwise
+ *
+ * The words don't need any particular alignment.
+ */
+struct BitOps
+{
+  /// _dst &= _src
+  static void And(U64* _dst, const U64* _src, std::size_t _count) { Apply(_dst, _src, _count, AndOp{}); };
+
+  /// _dst |= _src
+  static void Or(U64* _dst, const U64* _src, std::size_t _count) { Apply(_dst, _src, _count, OrOp{}); };
+
+  /// _dst &= ~_src
+  static void AndNot(U64* _dst, const U64* _src, std::size_t _count) { Apply(_dst, _src, _count, AndNotOp{}); };
+
+  /// Number of set bits
+  static std::size_t Count(const U64* _words, std::size_t _count)
+  {
+    std::size_t total = 0;
+    std::size_t i = 0;
+#if BITSET_AVX2
+    // Mula's nibble lookup: popcount of each byte by two shuffles, summed
+    // into 64-bit lanes with a sum of absolute differences
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i sums = _mm256_setzero_si256();
+    for(; i + 4 <= _count; i += 4){
+      __m256i words = Load256(_words + i);
+      __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(words, nibble));
+      __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(words, 4), nibble));
+      sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    alignas(32) U64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif BITSET_SSE2
+    // Without a popcount instruction: the usual bit tricks down to a count
+    // per byte, two words at a time, summed with a sum of absolute differences
+    const __m128i ones = _mm_set1_epi8(0x55);
+    const __m128i twos = _mm_set1_epi8(0x33);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i sums = _mm_setzero_si128();
+    for(; i + 2 <= _count; i += 2){
+      __m128i words = Load128(_words + i);
+      words = _mm_sub_epi8(words, _mm_and_si128(_mm_srli_epi64(words, 1), ones));
+      words = _mm_add_epi8(_mm_and_si128(words, twos), _mm_and_si128(_mm_srli_epi64(words, 2), twos));
+      words = _mm_and_si128(_mm_add_epi8(words, _mm_srli_epi64(words, 4)), nibble);
+      sums = _mm_add_epi64(sums, _mm_sad_epu8(words, _mm_setzero_si128()));
+    }
+    alignas(16) U64 lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    total = lanes[0] + lanes[1];
+#endif
+    for(; i < _count; ++i)
+      total += std::popcount(_words[i]);
+    return total;
+  }
+
+  /// True if every bit set in _subset is set in _words too
+  static B8 ContainsAll(const U64* _words, const U64* _subset, std::size_t _count)
+  {
+    std::size_t i = 0;
+#if BITSET_AVX2
+    for(; i + 4 <= _count; i += 4){
+      if(!_mm256_testc_si256(Load256(_words + i), Load256(_subset + i)))
+        return false;
+    }
+#elif BITSET_SSE2
+    for(; i + 2 <= _count; i += 2){
+      __m128i missing = _mm_andnot_si128(Load128(_words + i), Load128(_subset + i));
+      if(_mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) != 0xffff)
+        return false;
+    }
+#endif
+    for(; i < _count; ++i){
+      if((_subset[i] & ~_words[i]) != 0)
+        return false;
+    }
+    return true;
+  }
+
+  /// True if any bit is set in both
+  static B8 Intersects(const U64* _first, const U64* _second, std::size_t _count)
+  {
+    std::size_t i = 0;
+#if BITSET_AVX2
+    for(; i + 4 <= _count; i += 4){
+      if(!_mm256_testz_si256(Load256(_first + i), Load256(_second + i)))
+        return true;
+    }
+#elif BITSET_SSE2
+    for(; i + 2 <= _count; i += 2){
+      __m128i common = _mm_and_si128(Load128(_first + i), Load128(_second + i));
+      if(_mm_movemask_epi8(_mm_cmpeq_epi8(common, _mm_setzero_si128())) != 0xffff)
+        return true;
+    }
+#endif
+    for(; i < _count; ++i){
+      if((_first[i] & _second[i]) != 0)
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Finds the first set bit at or after _bit, skipping runs of empty
+   *        words a vector at a time
+   * @return Index of the bit, _count * 64 if there is none
+   */
+  static std::size_t FindNext(const U64* _words, std::size_t _count, std::size_t _bit)
+  {
+    std::size_t word = _bit / 64;
+    if(word >= _count)
+      return _count * 64;
+
+    U64 bits = _words[word] & (~0ull << (_bit % 64));
+    while(bits == 0){
+      ++word;
+#if BITSET_AVX2
+      while(word + 4 <= _count){
+        __m256i words = Load256(_words + word);
+        if(!_mm256_testz_si256(words, words))
+          break;
+        word += 4;
+      }
+#endif
+      if(word >= _count)
+        return _count * 64;
+      bits = _words[word];
+    }
+    return word * 64 + std::countr_zero(bits);
+  }
+
+private:
+#if BITSET_AVX2
+  static __m256i Load256(const U64* _words) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_words)); };
+#endif
+#if BITSET_SSE2
+  static __m128i Load128(const U64* _words) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(_words)); };
+#endif
+
+  /// Operations for Apply(), one overload per vector width
+  struct AndOp
+  {
+    U64 operator()(U64 _a, U64 _b) const { return _a & _b; };
+#if BITSET_AVX2
+    __m256i operator()(__m256i _a, __m256i _b) const { return _mm256_and_si256(_a, _b); };
+#elif BITSET_SSE2
+    __m128i operator()(__m128i _a, __m128i _b) const { return _mm_and_si128(_a, _b); };
+#endif
+  };
+
+  struct OrOp
+  {
+    U64 operator()(U64 _a, U64 _b) const { return _a | _b; };
+#if BITSET_AVX2
+    __m256i operator()(__m256i _a, __m256i _b) const { return _mm256_or_si256(_a, _b); };
+#elif BITSET_SSE2
+    __m128i operator()(__m128i _a, __m128i _b) const { return _mm_or_si128(_a, _b); };
+#endif
+  };
+
+  struct AndNotOp
+  {
+    U64 operator()(U64 _a, U64 _b) const { return _a & ~_b; };
+#if BITSET_AVX2
+    __m256i operator()(__m256i _a, __m256i _b) const { return _mm256_andnot_si256(_b, _a); };
+#elif BITSET_SSE2
+    __m128i operator()(__m128i _a, __m128i _b) const { return _mm_andnot_si128(_b, _a); };
+#endif
+  };
+
+  /// _dst = _op(_dst, _src), word by word
+  template <typename Op>
+  static void Apply(U64* _dst, const U64* _src, std::size_t _count, Op _op)
+  {
+    std::size_t i = 0;
+#if BITSET_AVX2
+    for(; i < _count / 4 * 4; i += 4)
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(_dst + i), _op(Load256(_dst + i), Load256(_src + i)));
+#elif BITSET_SSE2
+    for(; i < _count / 2 * 2; i += 2)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), _op(Load128(_dst + i), Load128(_src + i)));
+#endif
+    for(; i < _count; ++i)
+      _dst[i] = _op(_dst[i], _src[i]);
+  }
+};
+
+/**
+ * @class BitsetBase
+ * @brief Operations shared by FixedBitset and Bitset
+ *
+ * The derived class provides Words(), WordCount() and Size(), and keeps the
+ * bits past Size() in the last word clear.
+ *
+ * Bitsets of different sizes can be combined: bits past the end of the
+ * other one count as clear, and bits that wouldn't fit in this one are
+ * dropped.
+ *
+ * @tparam Derived the bitset class
+ */
+template <typename Derived>
+class BitsetBase
+{
+public:
+  /// Sets a bit, unchecked
+  void Set(std::size_t _bit) { SETBIT(Self().Words()[_bit / 64], _bit % 64); };
+
+  /// Clears a bit, unchecked
+  void Reset(std::size_t _bit) { CLRBIT(Self().Words()[_bit / 64], _bit % 64); };
+
+  /// Sets a bit to _value, unchecked
+  void Assign(std::size_t _bit, B8 _value)
+  {
+    if(_value)
+      Set(_bit);
+    else
+      Reset(_bit);
+  }
+
+  /// Returns a bit, unchecked
+  B8 Test(std::size_t _bit) const { return TESTBIT(Self().Words()[_bit / 64], _bit % 64); };
+
+  /// Sets every bit
+  void SetAll()
+  {
+    std::fill_n(Self().Words(), Self().WordCount(), ~0ull);
+    ClearUnused();
+  }
+
+  /// Clears every bit
+  void ResetAll() { std::fill_n(Self().Words(), Self().WordCount(), 0ull); };
+
+  /// Number of set bits
+  std::size_t Count() const { return BitOps::Count(Self().Words(), Self().WordCount()); };
+
+  /// True if any bit is set
+  B8 Any() const { return FindNext(0) < Self().Size(); };
+
+  /// True if no bit is set
+  B8 None() const { return !Any(); };
+
+  /// Index of the first set bit at or after _bit, Size() if there is none
+  std::size_t FindNext(std::size_t _bit) const
+  {
+    return std::min(BitOps::FindNext(Self().Words(), Self().WordCount(), _bit), Self().Size());
+  }
+
+  /// Calls _function with the index of every set bit, in order. Runs of
+  /// empty words are skipped with BitOps::FindNext().
+  template <typename Function>
+  void ForEachSetBit(Function&& _function) const
+  {
+    const U64* words = Self().Words();
+    const std::size_t count = Self().WordCount();
+    std::size_t word = BitOps::FindNext(words, count, 0) / 64;
+    while(word < count){
+      for(U64 bits = words[word]; bits != 0; bits &= bits - 1)
+        _function(word * 64 + std::countr_zero(bits));
+      word = BitOps::FindNext(words, count, (word + 1) * 64) / 64;
+    }
+  }
+
+  /// True if every bit set in _subset is set here too
+  B8 ContainsAll(const Derived& _subset) const
+  {
+    std::size_t shared = SharedWords(_subset);
+    return BitOps::ContainsAll(Self().Words(), _subset.Words(), shared) &&
+           BitOps::FindNext(_subset.Words(), _subset.WordCount(), shared * 64) == _subset.WordCount() * 64;
+  }
+
+  /// True if any bit is set in both
+  B8 Intersects(const Derived& _other) const
+  {
+    return BitOps::Intersects(Self().Words(), _other.Words(), SharedWords(_other));
+  }
+
+  /// Clears the bits not set in _other
+  Derived& operator&=(const Derived& _other)
+  {
+    std::size_t shared = SharedWords(_other);
+    BitOps::And(Self().Words(), _other.Words(), shared);
+    std::fill(Self().Words() + shared, Self().Words() + Self().WordCount(), 0ull);
+    return Self();
+  }
+
+  /// Sets the bits set in _other
+  Derived& operator|=(const Derived& _other)
+  {
+    BitOps::Or(Self().Words(), _other.Words(), SharedWords(_other));
+    ClearUnused();
+    return Self();
+  }
+
+  /// Clears the bits set in _other
+  Derived& AndNot(const Derived& _other)
+  {
+    BitOps::AndNot(Self().Words(), _other.Words(), SharedWords(_other));
+    return Self();
+  }
+
+  friend Derived operator&(Derived _first, const Derived& _second) { return _first &= _second; };
+  friend Derived operator|(Derived _first, const Derived& _second) { return _first |= _second; };
+
+  friend B8 operator==(const Derived& _first, const Derived& _second)
+  {
+    return _first.Size() == _second.Size() &&
+           std::memcmp(_first.Words(), _second.Words(), _first.WordCount() * sizeof(U64)) == 0;
+  }
+
+protected:
+  Derived& Self() { return static_cast<Derived&>(*this); };
+  const Derived& Self() const { return static_cast<const Derived&>(*this); };
+
+  std::size_t SharedWords(const Derived& _other) const { return std::min(Self().WordCount(), _other.WordCount()); };
+
+  /// Clears the bits of the last word past Size()
+  void ClearUnused()
+  {
+    std::size_t used = Self().Size() % 64;
+    if(used != 0)
+      Self().Words()[Self().WordCount() - 1] &= BIT(used) - 1;
+  }
+};
+
+/**
+ * @class FixedBitset
+ * @brief Bitset of a size known at compile time, stored inline
+ *
+ * Meant for masks stored per object, like an entity's component signature,
+ * that get scanned in bulk with MatchSignatures(). Sets of four words or
+ * more are aligned to 32 bytes for the AVX2 loads; smaller ones only to
+ * their word, so an array of them stays packed.
+ *
+ * @tparam BITS number of bits
+ */
+template <std::size_t BITS>
+class alignas((BITS + 63) / 64 >= 4 ? 32 : 8) FixedBitset : public BitsetBase<FixedBitset<BITS>>
+{
+  static_assert(BITS > 0, "FixedBitset needs at least one bit");
+
+public:
+  /// Number of 64-bit words
+  static constexpr std::size_t s_words = (BITS + 63) / 64;
+
+  U64* Words() { return m_words; };
+  const U64* Words() const { return m_words; };
+  static constexpr std::size_t WordCount() { return s_words; };
+  static constexpr std::size_t Size() { return BITS; };
+
+private:
+  U64 m_words[s_words] = {};
+};
+
+/**
+ * @class Bitset
+ * @brief Bitset sized at run time, e.g. a mask over every renderable object
+ */
+class Bitset : public BitsetBase<Bitset>
+{
+public:
+  Bitset() = default;
+
+  /// Creates a bitset of _size clear bits
+  explicit Bitset(std::size_t _size)
+    : m_words((_size + 63) / 64, 0ull), m_size(_size)
+  {};
+
+  /// Grows or shrinks the bitset, new bits are clear
+  void Resize(std::size_t _size)
+  {
+    m_words.resize((_size + 63) / 64, 0ull);
+    m_size = _size;
+    ClearUnused();
+  }
+
+  U64* Words() { return m_words.data(); };
+  const U64* Words() const { return m_words.data(); };
+  std::size_t WordCount() const { return m_words.size(); };
+  std::size_t Size() const { return m_size; };
+
+private:
+  /// The bits, bit i in word i / 64
+  std::vector<U64> m_words;
+
+  /// Number of bits
+  std::size_t m_size = 0;
+};
+
+/**
+ * @brief Finds the signatures holding every bit of a query
+ *
+ * The scan an ECS query runs over its entities' component signatures.
+ * Single-word signatures are checked four at a time with AVX2.
+ *
+ * @param _signatures signatures to check
+ * @param _count number of signatures
+ * @param _query bits a signature needs to match
+ * @param _matches receives the indices of the matching signatures, needs
+ *        room for _count of them
+ * @return Number of matches
+ */
+template <std::size_t BITS>
+std::size_t MatchSignatures(const FixedBitset<BITS>* _signatures,
+                            std::size_t _count,
+                            const FixedBitset<BITS>& _query,
+                            U32* _matches)
+{
+  std::size_t matches = 0;
+  std::size_t i = 0;
+
+#if BITSET_AVX2
+  if constexpr (FixedBitset<BITS>::s_words == 1){
+    static_assert(sizeof(FixedBitset<BITS>) == sizeof(U64), "single-word signatures have to be packed");
+    const __m256i query = _mm256_set1_epi64x(static_cast<long long>(_query.Words()[0]));
+    for(; i + 4 <= _count; i += 4){
+      __m256i signatures = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_signatures + i));
+      __m256i matched = _mm256_cmpeq_epi64(_mm256_and_si256(signatures, query), query);
+      for(U32 mask = U32(_mm256_movemask_pd(_mm256_castsi256_pd(matched))); mask != 0; mask &= mask - 1)
+        _matches[matches++] = U32(i + std::countr_zero(mask));
+    }
+  }
+#endif
+
+  for(; i < _count; ++i){
+    if(BitOps::ContainsAll(_signatures[i].Words(), _query.Words(), FixedBitset<BITS>::s_words))
+      _matches[matches++] = U32(i);
+  }
+  return matches;
+}
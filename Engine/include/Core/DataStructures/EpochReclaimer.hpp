@@ -0,0 +1,228 @@
+/**
+ * @file EpochReclaimer.hpp
+ * @brief Epoch-based reclamation of nodes unlinked from lock-free structures
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see EpochReclaimer
+ * @see EpochGuard
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/MemoryManager.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// Most threads that can be registered with the EpochReclaimer at once
+#define EPOCH_MAX_THREADS 256
+
+/// Nodes a thread retires before it tries to advance the epoch and free them
+#define EPOCH_RECLAIM_BATCH 64
+
+/**
+ * @class EpochReclaimer
+ * @brief Frees nodes of lock-free structures once no thread can still see
+ *        them
+ *
+ * A lock-free structure can't free a node the moment it unlinks it, another
+ * thread may have read a pointer to it just before. Instead every access to
+ * the structure happens inside an EpochGuard, which pins the thread to the
+ * current global epoch, and unlinked nodes are handed to Retire(). They wait
+ * in the retiring thread's limbo list, tagged with the epoch they were
+ * retired in, and are freed once the global epoch has moved on twice: by
+ * then every thread that was pinned when the node was unlinked has left its
+ * guard.
+ *
+ * The epoch only advances when every pinned thread has seen the current one,
+ * which each thread checks after every EPOCH_RECLAIM_BATCH retired nodes, so
+ * freeing happens in batches and costs nothing on the read path but two
+ * stores and a fence per guard.
+ *
+ * Retire<T>() destroys the node through MEMALLOC(), so nodes made with
+ * MEMALLOC().Create<T>() go back to their pool to be reused:
+ * @code
+ *   {
+ *     EpochGuard guard;
+ *     Node* head = m_head.load(std::memory_order_acquire);
+ *     ...
+ *     if(m_head.compare_exchange_strong(head, head->m_next))
+ *       EPOCH().Retire(head);
+ *   }
+ * @endcode
+ *
+ * Threads are registered on their first guard and unregistered when they
+ * exit; RegisterThread() and UnregisterThread() do it explicitly, e.g. for
+ * worker threads that outlive a subsystem. Nodes still in the limbo list of
+ * an unregistered thread are freed by whichever thread collects next.
+ *
+ * Nodes still retired at exit have to be freed with DrainAll() before the
+ * static pools go; the destructor leaves them to the operating system.
+ */
+class EpochReclaimer
+{
+public:
+  /// Singleton instance getter
+  static EpochReclaimer& GetInstance();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(EpochReclaimer);
+
+  /// Registers the calling thread, does nothing if it is already registered
+  void RegisterThread();
+
+  /// Unregisters the calling thread, handing its limbo list to the others.
+  /// It must not be inside a guard.
+  void UnregisterThread();
+
+  /// Pins the calling thread to the current epoch, guards can nest
+  void Enter();
+
+  /// Unpins the calling thread once its outermost guard is left
+  void Leave();
+
+  /**
+   * @brief Frees a node once no thread can still be reading it
+   * @param _node node already unlinked from its structure
+   * @param _deleter called with _node to free it
+   */
+  void Retire(void* _node, void (*_deleter)(void*));
+
+  /**
+   * @brief Destroys a node made with MEMALLOC().Create<T>() once no thread
+   *        can still be reading it
+   *
+   * T has to be the type the node was created as, since that picks the pool
+   * it goes back to.
+   *
+   * @param _node node already unlinked from its structure
+   */
+  template <typename T>
+  void Retire(T* _node)
+  {
+    Retire(static_cast<void*>(_node), [](void* _ptr) {
+      MEMALLOC().Destroy<T>(static_cast<T*>(_ptr));
+    });
+  }
+
+  /**
+   * @brief Tries to advance the epoch, then frees what is safe to free
+   *
+   * Frees the calling thread's limbo list and the nodes left over by
+   * unregistered threads. Called on its own every EPOCH_RECLAIM_BATCH
+   * retired nodes.
+   *
+   * @return Number of nodes freed
+   */
+  std::size_t Collect();
+
+  /**
+   * @brief Frees every retired node, whatever its epoch
+   *
+   * Only safe once no other thread uses the reclaimer, i.e. at shutdown.
+   * Has to run while the pools the nodes go back to still exist: they are
+   * function-local statics and thread_local caches created after the
+   * reclaimer, so they are gone by the time its destructor runs.
+   *
+   * @return Number of nodes freed
+   */
+  std::size_t DrainAll();
+
+  /// Returns the global epoch
+  U64 GetEpoch() const { return m_epoch.load(std::memory_order_relaxed); };
+
+  /// Returns the number of nodes retired and not freed yet
+  std::size_t GetPendingCount() const { return m_pending.load(std::memory_order_relaxed); };
+
+private:
+  EpochReclaimer();
+  ~EpochReclaimer();
+
+  /// A retired node and how to free it
+  struct RetiredNode
+  {
+    void* m_node;
+    void (*m_deleter)(void*);
+  };
+
+  /// Nodes retired during one epoch
+  struct LimboList
+  {
+    U64 m_epoch = 0;
+    std::vector<RetiredNode> m_nodes;
+  };
+
+  /**
+   * @struct ThreadRecord
+   * @brief Epoch and limbo lists of one registered thread
+   *
+   * Only the owning thread touches the limbo lists, the others only read
+   * m_state. Padded to a cache line so pinning never bounces another
+   * thread's line.
+   */
+  struct alignas(64) ThreadRecord
+  {
+    /// Epoch the thread is pinned to, shifted left by one, with the lowest
+    /// bit set while it is pinned
+    std::atomic<U64> m_state{0};
+
+    /// Set while a thread owns the record
+    std::atomic<B8> m_inUse{false};
+
+    /// Depth of nested guards
+    U32 m_nesting = 0;
+
+    /// Nodes retired since the last collection
+    U32 m_retiredSinceCollect = 0;
+
+    /// Retired nodes of the last three epochs, indexed by epoch % 3
+    LimboList m_limbo[3];
+  };
+
+  /// Returns the calling thread's record, registering it on first use
+  ThreadRecord& GetRecord();
+
+  /// Advances the epoch if every pinned thread has seen the current one
+  void TryAdvance();
+
+  /// Frees a limbo list and empties it
+  std::size_t Free(LimboList& _list);
+
+  /// Global epoch, on a cache line of its own
+  alignas(64) std::atomic<U64> m_epoch{0};
+
+  /// Nodes retired and not freed yet
+  alignas(64) std::atomic<std::size_t> m_pending{0};
+
+  /// Records of the registered threads
+  ThreadRecord m_records[EPOCH_MAX_THREADS];
+
+  /// One past the highest record ever used, so scans stop early
+  std::atomic<U32> m_recordCount{0};
+
+  /// Limbo lists handed over by unregistered threads
+  std::vector<LimboList> m_orphans;
+
+  /// Guards m_orphans
+  std::mutex m_orphanMutex;
+};
+
+/**
+ * @class EpochGuard
+ * @brief Keeps the calling thread pinned to an epoch while it's in scope
+ */
+class EpochGuard
+{
+public:
+  EpochGuard() { EpochReclaimer::GetInstance().Enter(); };
+  ~EpochGuard() { EpochReclaimer::GetInstance().Leave(); };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(EpochGuard);
+};
+
+#define EPOCH() \
+  EpochReclaimer::GetInstance()
@@ -0,0 +1,713 @@
+/**
+ * @file FlatHashMap.hpp
+ * @brief Open-addressing hash map probing sixteen slots at a time
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see FlatHashMap
+ * @see FlatHash
+ * @see FlatEqual
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define FLAT_HASH_MAP_SSE2 1
+#endif
+
+/**
+ * @struct FlatHash
+ * @brief Hash the FlatHashMap uses by default
+ *
+ * Falls back on std::hash. The map mixes the result again, so identity
+ * hashes of integers and pointers are fine.
+ */
+template <typename K>
+struct FlatHash
+{
+  std::size_t operator()(const K& _key) const { return std::hash<K>{}(_key); };
+};
+
+/**
+ * @brief Hashes engine strings by their characters, so they can be looked up
+ *        with a const char* or a std::string_view without building a String
+ */
+template <size_t MAX_LENGTH>
+struct FlatHash<String<MAX_LENGTH>>
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view _key) const { return std::hash<std::string_view>{}(_key); };
+  std::size_t operator()(const char* _key) const { return (*this)(std::string_view(_key)); };
+  std::size_t operator()(const String<MAX_LENGTH>& _key) const
+  {
+    return (*this)(std::string_view(_key.Data(), _key.Length()));
+  };
+};
+
+/// Hashes std::string keys by their characters, see FlatHash<String>
+template <>
+struct FlatHash<std::string>
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view _key) const { return std::hash<std::string_view>{}(_key); };
+};
+
+/**
+ * @struct FlatEqual
+ * @brief Key comparison the FlatHashMap uses by default
+ */
+template <typename K>
+struct FlatEqual : std::equal_to<K>
+{
+};
+
+/// Compares engine strings with each other, const char* or std::string_view
+template <size_t MAX_LENGTH>
+struct FlatEqual<String<MAX_LENGTH>>
+{
+  using is_transparent = void;
+
+  template <typename A, typename B>
+  bool operator()(const A& _lhs, const B& _rhs) const { return View(_lhs) == View(_rhs); };
+
+private:
+  static std::string_view View(const String<MAX_LENGTH>& _key) { return std::string_view(_key.Data(), _key.Length()); };
+  static std::string_view View(std::string_view _key) { return _key; };
+  static std::string_view View(const char* _key) { return std::string_view(_key); };
+};
+
+/// Compares std::string keys with each other, const char* or std::string_view
+template <>
+struct FlatEqual<std::string> : std::equal_to<>
+{
+};
+
+/**
+ * @class FlatHashMap
+ * @brief Hash map storing its entries in one flat array
+ *
+ * Unlike std::unordered_map there is no node per entry: the entries live in
+ * a single power-of-two array next to an array of one control byte per
+ * slot. A control byte holds 7 bits of the key's hash, or marks the slot as
+ * empty or deleted. Lookups read a group of sixteen control bytes at once
+ * and compare them all against the hash with a couple of SSE2 instructions,
+ * so only slots whose 7 bits match have their key compared, and a lookup
+ * rarely touches more than one group. Without SSE2 the group is scanned a
+ * byte at a time.
+ *
+ * The map grows once it is 7/8 full. Growing, like erasing, moves entries
+ * and invalidates pointers and iterators to them.
+ *
+ * When both Hash and Equal declare is_transparent, as the defaults for
+ * String<N> and std::string do, lookups take any key type they accept, e.g.
+ * a const char* for a String<32> key, without building a temporary key.
+ *
+ * @tparam K key type
+ * @tparam V mapped type
+ * @tparam Hash hash of the keys
+ * @tparam Equal equality of the keys
+ */
+template <typename K, typename V, typename Hash = FlatHash<K>, typename Equal = FlatEqual<K>>
+class FlatHashMap
+{
+public:
+  using key_type    = K;
+  using mapped_type = V;
+  using value_type  = std::pair<const K, V>;
+
+  /// Number of control bytes probed at once
+  static constexpr std::size_t GroupWidth = 16;
+
+private:
+  /// Control byte values, full slots hold 7 bits of the hash (0..127)
+  static constexpr I8 s_empty   = -128;
+  static constexpr I8 s_deleted = -2;
+
+  /// Lookup key types allowed next to K
+  template <typename Key>
+  static constexpr B8 IsLookupKey = std::is_same_v<std::decay_t<Key>, K> ||
+                                    (requires { typename Hash::is_transparent; } &&
+                                     requires { typename Equal::is_transparent; });
+
+  /**
+   * @struct Group
+   * @brief Sixteen control bytes, matched all at once
+   */
+  struct Group
+  {
+#ifdef FLAT_HASH_MAP_SSE2
+    explicit Group(const I8* _ctrl)
+      : m_ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(_ctrl)))
+    {};
+
+    /// Bit i is set if control byte i equals _value
+    U32 Match(I8 _value) const
+    {
+      return static_cast<U32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(_value), m_ctrl)));
+    }
+
+    /// Bit i is set if slot i is empty or deleted
+    U32 MatchFree() const
+    {
+      return static_cast<U32>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), m_ctrl)));
+    }
+
+    __m128i m_ctrl;
+#else
+    explicit Group(const I8* _ctrl)
+      : m_ctrl(_ctrl)
+    {};
+
+    U32 Match(I8 _value) const
+    {
+      U32 mask = 0;
+      for(std::size_t i = 0; i < GroupWidth; ++i)
+        mask |= U32(m_ctrl[i] == _value) << i;
+      return mask;
+    }
+
+    U32 MatchFree() const
+    {
+      U32 mask = 0;
+      for(std::size_t i = 0; i < GroupWidth; ++i)
+        mask |= U32(m_ctrl[i] < -1) << i;
+      return mask;
+    }
+
+    const I8* m_ctrl;
+#endif
+
+    /// Bit i is set if slot i is empty
+    U32 MatchEmpty() const { return Match(s_empty); };
+  };
+
+public:
+  /**
+   * @class Iterator
+   * @brief Walks the full slots in storage order
+   */
+  template <B8 IsConst>
+  class Iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = FlatHashMap::value_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = std::conditional_t<IsConst, const value_type*, value_type*>;
+    using reference         = std::conditional_t<IsConst, const value_type&, value_type&>;
+
+    Iterator() = default;
+
+    /// Non-const iterators convert to const ones
+    operator Iterator<true>() const { return Iterator<true>(m_ctrl, m_end, m_slot); };
+
+    reference operator*() const { return *m_slot; };
+    pointer operator->() const { return m_slot; };
+
+    Iterator& operator++()
+    {
+      ++m_ctrl;
+      ++m_slot;
+      SkipFree();
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator previous = *this;
+      ++(*this);
+      return previous;
+    }
+
+    bool operator==(const Iterator& _other) const { return m_ctrl == _other.m_ctrl; };
+    bool operator!=(const Iterator& _other) const { return m_ctrl != _other.m_ctrl; };
+
+  private:
+    friend class FlatHashMap;
+    template <B8> friend class Iterator;
+
+    Iterator(const I8* _ctrl, const I8* _end, pointer _slot)
+      : m_ctrl(_ctrl), m_end(_end), m_slot(_slot)
+    {};
+
+    /// Moves on to the next full slot, or the end
+    void SkipFree()
+    {
+      while(m_ctrl != m_end && *m_ctrl < 0){
+        ++m_ctrl;
+        ++m_slot;
+      }
+    }
+
+    const I8* m_ctrl = nullptr;
+    const I8* m_end  = nullptr;
+    pointer   m_slot = nullptr;
+  };
+
+  using iterator       = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatHashMap() = default;
+
+  /**
+   * @brief Creates a map with room for _count entries
+   * @param _count number of entries to make room for
+   */
+  explicit FlatHashMap(std::size_t _count)
+  {
+    Reserve(_count);
+  };
+
+  FlatHashMap(const FlatHashMap& _other)
+    : m_hash(_other.m_hash), m_equal(_other.m_equal)
+  {
+    Reserve(_other.Size());
+    for(const value_type& entry : _other)
+      InsertUnique(HashOf(entry.first), entry);
+  };
+
+  FlatHashMap(FlatHashMap&& _other) noexcept
+  {
+    Swap(_other);
+  };
+
+  FlatHashMap& operator=(FlatHashMap _other) noexcept
+  {
+    Swap(_other);
+    return *this;
+  };
+
+  ~FlatHashMap()
+  {
+    Clear();
+    Deallocate();
+  };
+
+  /// Swaps the contents of two maps
+  void Swap(FlatHashMap& _other) noexcept
+  {
+    std::swap(m_ctrl, _other.m_ctrl);
+    std::swap(m_slots, _other.m_slots);
+    std::swap(m_capacity, _other.m_capacity);
+    std::swap(m_size, _other.m_size);
+    std::swap(m_deleted, _other.m_deleted);
+    std::swap(m_growthLeft, _other.m_growthLeft);
+    std::swap(m_hash, _other.m_hash);
+    std::swap(m_equal, _other.m_equal);
+  }
+
+  /// @name Iteration, in storage order
+  /// @{
+  iterator begin()
+  {
+    iterator it(m_ctrl, m_ctrl + m_capacity, m_slots);
+    it.SkipFree();
+    return it;
+  }
+
+  iterator end() { return iterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_slots + m_capacity); };
+
+  const_iterator begin() const
+  {
+    const_iterator it(m_ctrl, m_ctrl + m_capacity, m_slots);
+    it.SkipFree();
+    return it;
+  }
+
+  const_iterator end() const { return const_iterator(m_ctrl + m_capacity, m_ctrl + m_capacity, m_slots + m_capacity); };
+  /// @}
+
+  /**
+   * @brief Finds the entry of a key
+   * @param _key key, or any type Hash and Equal accept if both are
+   *             transparent. Other types are converted to K first.
+   * @return Iterator to the entry, end() if there is none
+   */
+  template <typename Key>
+  iterator Find(const Key& _key)
+  {
+    std::size_t index = IndexOf(_key);
+    return index == s_notFound ? end() : IteratorAt(index);
+  }
+
+  template <typename Key>
+  const_iterator Find(const Key& _key) const
+  {
+    return const_cast<FlatHashMap*>(this)->Find(_key);
+  }
+
+  /**
+   * @brief Returns the value of a key, nullptr if it isn't in the map
+   * @param _key key, see Find()
+   */
+  template <typename Key>
+  V* Get(const Key& _key)
+  {
+    std::size_t index = IndexOf(_key);
+    return index == s_notFound ? nullptr : &m_slots[index].second;
+  }
+
+  template <typename Key>
+  const V* Get(const Key& _key) const
+  {
+    return const_cast<FlatHashMap*>(this)->Get(_key);
+  }
+
+  /// Returns true if the key is in the map, see Find()
+  template <typename Key>
+  B8 Contains(const Key& _key) const
+  {
+    return IndexOf(_key) != s_notFound;
+  }
+
+  /**
+   * @brief Adds an entry unless the key is already in the map
+   * @param _key the key, see Find(). The stored key is built from it only if
+   *             the entry is added.
+   * @param _args arguments passed to V's constructor
+   * @return Iterator to the entry with the key, and true if it was added
+   */
+  template <typename Key, typename... Args>
+  std::pair<iterator, B8> TryEmplace(Key&& _key, Args&&... _args)
+  {
+    if constexpr (!IsLookupKey<Key>){
+      return TryEmplace(static_cast<K>(std::forward<Key>(_key)), std::forward<Args>(_args)...);
+    }
+    else{
+      std::size_t hash = HashOf(_key);
+      std::size_t index = FindIndex(_key, hash);
+      if(index != s_notFound)
+        return {IteratorAt(index), false};
+
+      index = InsertUnique(hash, std::piecewise_construct,
+                           std::forward_as_tuple(std::forward<Key>(_key)),
+                           std::forward_as_tuple(std::forward<Args>(_args)...));
+      return {IteratorAt(index), true};
+    }
+  }
+
+  /**
+   * @brief Adds an entry, or overwrites the value if the key is there
+   * @return Iterator to the entry, and true if it was added
+   */
+  template <typename Key, typename Value>
+  std::pair<iterator, B8> InsertOrAssign(Key&& _key, Value&& _value)
+  {
+    auto result = TryEmplace(std::forward<Key>(_key), std::forward<Value>(_value));
+    if(!result.second)
+      result.first->second = std::forward<Value>(_value);
+    return result;
+  }
+
+  /// Returns the value of a key, adding a default-constructed one if needed
+  template <typename Key>
+  V& operator[](Key&& _key)
+  {
+    return TryEmplace(std::forward<Key>(_key)).first->second;
+  }
+
+  /**
+   * @brief Removes the entry of a key
+   * @param _key key, see Find()
+   * @return False if the key wasn't in the map
+   */
+  template <typename Key>
+  B8 Erase(const Key& _key)
+  {
+    std::size_t index = IndexOf(_key);
+    if(index == s_notFound)
+      return false;
+
+    EraseAt(index);
+    return true;
+  }
+
+  /**
+   * @brief Removes the entry an iterator points to
+   * @param _position iterator to a full slot
+   * @return Iterator to the next entry
+   */
+  iterator Erase(iterator _position)
+  {
+    std::size_t index = _position.m_ctrl - m_ctrl;
+    EraseAt(index);
+
+    iterator next = IteratorAt(index);
+    next.SkipFree();
+    return next;
+  }
+
+  /// Removes every entry, keeping the memory
+  void Clear()
+  {
+    if(m_size > 0){
+      for(std::size_t i = 0; i < m_capacity; ++i)
+        if(m_ctrl[i] >= 0)
+          m_slots[i].~value_type();
+    }
+
+    std::fill(m_ctrl, m_ctrl + m_capacity, s_empty);
+    m_size = 0;
+    m_deleted = 0;
+    m_growthLeft = MaxLoad(m_capacity);
+  }
+
+  /**
+   * @brief Makes room for _count entries without growing
+   * @param _count number of entries
+   */
+  void Reserve(std::size_t _count)
+  {
+    std::size_t capacity = GroupWidth;
+    while(MaxLoad(capacity) < _count)
+      capacity *= 2;
+
+    if(capacity > m_capacity)
+      Resize(capacity);
+  }
+
+  /// Returns the number of entries
+  std::size_t Size() const { return m_size; };
+
+  /// Returns true if the map has no entries
+  B8 Empty() const { return m_size == 0; };
+
+  /// Returns the number of slots
+  std::size_t Capacity() const { return m_capacity; };
+
+private:
+  /// Index returned when a key isn't found
+  static constexpr std::size_t s_notFound = ~std::size_t(0);
+
+  /// Entries a map of _capacity slots holds before it grows
+  static constexpr std::size_t MaxLoad(std::size_t _capacity) { return _capacity - _capacity / 8; };
+
+  /// Hashes a key and mixes the bits, so weak hashes spread well too
+  template <typename Key>
+  std::size_t HashOf(const Key& _key) const
+  {
+    U64 hash = static_cast<U64>(m_hash(_key));
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return static_cast<std::size_t>(hash);
+  }
+
+  /// Bits of the hash picking the first group
+  static std::size_t H1(std::size_t _hash) { return _hash >> 7; };
+
+  /// Bits of the hash stored in the control byte
+  static I8 H2(std::size_t _hash) { return static_cast<I8>(_hash & 0x7f); };
+
+  /// Returns the slot index of a key, converting it to K if it can't be
+  /// looked up as it is
+  template <typename Key>
+  std::size_t IndexOf(const Key& _key) const
+  {
+    if constexpr (IsLookupKey<Key>)
+      return FindIndex(_key, HashOf(_key));
+    else
+      return IndexOf(static_cast<K>(_key));
+  }
+
+  /// Returns the slot index of a key, or s_notFound
+  template <typename Key>
+  std::size_t FindIndex(const Key& _key, std::size_t _hash) const
+  {
+    if(m_capacity == 0)
+      return s_notFound;
+
+    const I8 h2 = H2(_hash);
+    const std::size_t groupMask = m_capacity / GroupWidth - 1;
+    std::size_t group = H1(_hash) & groupMask;
+
+    // Triangular steps visit every group of a power-of-two table once
+    for(std::size_t step = 1; ; ++step){
+      const std::size_t base = group * GroupWidth;
+      Group ctrl(m_ctrl + base);
+
+      for(U32 match = ctrl.Match(h2); match != 0; match &= match - 1){
+        std::size_t index = base + std::countr_zero(match);
+        if(m_equal(m_slots[index].first, _key))
+          return index;
+      }
+
+      // The key would have gone into this empty slot
+      if(ctrl.MatchEmpty() != 0)
+        return s_notFound;
+
+      group = (group + step) & groupMask;
+    }
+  }
+
+  /// Returns the first empty or deleted slot on a hash's probe sequence
+  std::size_t FindFreeSlot(std::size_t _hash) const
+  {
+    const std::size_t groupMask = m_capacity / GroupWidth - 1;
+    std::size_t group = H1(_hash) & groupMask;
+
+    for(std::size_t step = 1; ; ++step){
+      U32 free = Group(m_ctrl + group * GroupWidth).MatchFree();
+      if(free != 0)
+        return group * GroupWidth + std::countr_zero(free);
+
+      group = (group + step) & groupMask;
+    }
+  }
+
+  /**
+   * @brief Constructs an entry for a key known not to be in the map
+   * @return Slot index of the entry
+   */
+  template <typename... Args>
+  std::size_t InsertUnique(std::size_t _hash, Args&&... _args)
+  {
+    if(m_growthLeft == 0)
+      Grow();
+
+    std::size_t index = FindFreeSlot(_hash);
+    new (m_slots + index) value_type(std::forward<Args>(_args)...);
+
+    if(m_ctrl[index] == s_deleted)
+      --m_deleted;
+    else
+      --m_growthLeft;
+
+    m_ctrl[index] = H2(_hash);
+    ++m_size;
+    return index;
+  }
+
+  /// Destroys the entry in a full slot
+  void EraseAt(std::size_t _index)
+  {
+    m_slots[_index].~value_type();
+    --m_size;
+
+    // Probes stop at the first group with an empty slot, so if this group
+    // has one already no probe can pass through it and the slot can just
+    // be emptied. Otherwise it has to stay a tombstone.
+    if(Group(m_ctrl + (_index & ~(GroupWidth - 1))).MatchEmpty() != 0){
+      m_ctrl[_index] = s_empty;
+      ++m_growthLeft;
+    }
+    else{
+      m_ctrl[_index] = s_deleted;
+      ++m_deleted;
+    }
+  }
+
+  /// Makes room for one more entry: doubles, or just drops the tombstones
+  /// if they take up a good part of the table
+  void Grow()
+  {
+    if(m_capacity == 0)
+      Resize(GroupWidth);
+    else if(m_deleted > m_capacity / 16)
+      Resize(m_capacity);
+    else
+      Resize(m_capacity * 2);
+  }
+
+  /// Moves every entry into a table of _capacity slots
+  void Resize(std::size_t _capacity)
+  {
+    I8* oldCtrl = m_ctrl;
+    value_type* oldSlots = m_slots;
+    std::size_t oldCapacity = m_capacity;
+
+    Allocate(_capacity);
+
+    for(std::size_t i = 0; i < oldCapacity; ++i){
+      if(oldCtrl[i] < 0)
+        continue;
+
+      std::size_t hash = HashOf(oldSlots[i].first);
+      std::size_t index = FindFreeSlot(hash);
+      new (m_slots + index) value_type(std::move(oldSlots[i]));
+      m_ctrl[index] = H2(hash);
+      oldSlots[i].~value_type();
+    }
+    m_growthLeft -= m_size;
+
+    if(oldCtrl != nullptr)
+      ::operator delete(oldCtrl, std::align_val_t(s_alignment));
+  }
+
+  /// Alignment of the table, enough for an SSE2 load of a group
+  static constexpr std::size_t s_alignment = std::max(GroupWidth, alignof(value_type));
+
+  /// Offset of the slots behind the control bytes
+  static constexpr std::size_t SlotOffset(std::size_t _capacity)
+  {
+    return (_capacity + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+  }
+
+  /// Allocates an empty table, control bytes first and slots after them
+  void Allocate(std::size_t _capacity)
+  {
+    std::size_t bytes = SlotOffset(_capacity) + _capacity * sizeof(value_type);
+    U8* memory = static_cast<U8*>(::operator new(bytes, std::align_val_t(s_alignment)));
+
+    m_ctrl = reinterpret_cast<I8*>(memory);
+    m_slots = reinterpret_cast<value_type*>(memory + SlotOffset(_capacity));
+    m_capacity = _capacity;
+    m_deleted = 0;
+    m_growthLeft = MaxLoad(_capacity);
+    std::fill(m_ctrl, m_ctrl + m_capacity, s_empty);
+  }
+
+  /// Frees the table, the entries must be destroyed already
+  void Deallocate()
+  {
+    if(m_ctrl != nullptr)
+      ::operator delete(m_ctrl, std::align_val_t(s_alignment));
+    m_ctrl = nullptr;
+    m_slots = nullptr;
+    m_capacity = 0;
+    m_growthLeft = 0;
+  }
+
+  iterator IteratorAt(std::size_t _index)
+  {
+    return iterator(m_ctrl + _index, m_ctrl + m_capacity, m_slots + _index);
+  }
+
+  /// One control byte per slot: empty, deleted, or 7 bits of the hash
+  I8* m_ctrl = nullptr;
+
+  /// The entries, constructed only in full slots
+  value_type* m_slots = nullptr;
+
+  /// Number of slots, a power of two and a multiple of GroupWidth
+  std::size_t m_capacity = 0;
+
+  /// Number of entries
+  std::size_t m_size = 0;
+
+  /// Number of tombstones left by erased entries
+  std::size_t m_deleted = 0;
+
+  /// Entries that can still be added before the table has to grow
+  std::size_t m_growthLeft = 0;
+
+  Hash  m_hash;
+  Equal m_equal;
+};
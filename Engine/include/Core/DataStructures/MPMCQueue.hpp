@@ -0,0 +1,302 @@
+/**
+ * @file MPMCQueue.hpp
+ * @brief Bounded lock-free multi-producer/multi-consumer ring queue
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see MPMCQueue
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// pint-sized library. Remove this...
+namespace psl
+{
+
+/**
+ * @class MPMCQueue
+ * @brief Bounded lock-free FIFO for any number of producers and consumers
+ *
+ * Dmitry Vyukov's bounded queue: a power-of-two ring of cells, each with a
+ * sequence number telling whose turn it is to use it. A producer claims a
+ * cell by moving the enqueue position on with one compare-and-swap, writes
+ * the item and publishes it by bumping the cell's sequence; consumers mirror
+ * that on the dequeue side. There are no nodes to allocate or free, so
+ * there's no ABA and no use-after-free, and a full or empty queue is reported
+ * instead of waited on.
+ *
+ * Items pushed by one producer are popped in the order they were pushed.
+ *
+ * A claimed cell has to be published, or the consumers behind it stall on it
+ * for good, so nothing between claiming and publishing may throw.
+ *
+ * @tparam T type of the items, has to be nothrow move-assignable and
+ *           nothrow constructible from whatever is pushed
+ */
+template <typename T>
+class MPMCQueue
+{
+  static_assert(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_destructible_v<T>,
+                "MPMCQueue can't publish a cell whose pop threw");
+
+public:
+  /**
+   * @brief Creates the queue
+   * @param _capacity number of items the queue can hold, rounded up to a
+   *                  power of two
+   */
+  explicit MPMCQueue(std::size_t _capacity = 1024)
+    : m_mask(RoundUpToPowerOfTwo(_capacity) - 1),
+      m_cells(new Cell[m_mask + 1])
+  {
+    for(std::size_t i = 0; i <= m_mask; ++i)
+      m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+    m_enqueuePosition.store(0, std::memory_order_relaxed);
+    m_dequeuePosition.store(0, std::memory_order_relaxed);
+  };
+
+  /// Destroys the items still queued
+  ~MPMCQueue()
+  {
+    std::size_t end = m_enqueuePosition.load(std::memory_order_relaxed);
+    for(std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed); position != end; ++position){
+      Cell& cell = m_cells[position & m_mask];
+      if(cell.m_sequence.load(std::memory_order_relaxed) == position + 1)
+        std::launder(reinterpret_cast<T*>(cell.m_storage))->~T();
+    }
+  };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(MPMCQueue);
+
+  /**
+   * @brief Constructs an item at the back of the queue
+   * @param _args arguments passed to T's constructor
+   * @return False if the queue is full
+   */
+  template <typename... Args>
+  B8 TryEmplace(Args&&... _args)
+  {
+    static_assert(std::is_nothrow_constructible_v<T, Args&&...>,
+                  "MPMCQueue can't publish a cell whose construction threw");
+
+    std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true){
+      cell = &m_cells[position & m_mask];
+      std::size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+      if(difference == 0){
+        // The cell is free on this lap, try to claim it
+        if(m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(difference < 0){
+        // The cell still holds the item from the previous lap
+        return false;
+      }
+      else{
+        // Another producer claimed it first
+        position = m_enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    new (cell->m_storage) T(std::forward<Args>(_args)...);
+    cell->m_sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pushes a copy of an item
+   * @param _item the item
+   * @return False if the queue is full
+   */
+  B8 TryPush(const T& _item) { return TryEmplace(_item); };
+
+  /**
+   * @brief Pushes an item
+   * @param _item the item, moved from only if it was pushed
+   * @return False if the queue is full
+   */
+  B8 TryPush(T&& _item) { return TryEmplace(std::move(_item)); };
+
+  /**
+   * @brief Pops the item at the front of the queue
+   * @param _item receives the item
+   * @return False if the queue is empty
+   */
+  B8 TryPop(T& _item)
+  {
+    std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while(true){
+      cell = &m_cells[position & m_mask];
+      std::size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+      if(difference == 0){
+        if(m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(difference < 0){
+        return false;
+      }
+      else{
+        position = m_dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    T* stored = std::launder(reinterpret_cast<T*>(cell->m_storage));
+    _item = std::move(*stored);
+    stored->~T();
+
+    // Hand the cell to the producers of the next lap
+    cell->m_sequence.store(position + m_mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Pushes copies of as many items as there is room for
+   *
+   * Claims all the cells with a single compare-and-swap, so the items stay
+   * together in the queue.
+   *
+   * @param _items items to push
+   * @param _count number of items
+   * @return Number of items pushed, from the start of _items
+   */
+  std::size_t TryPushBatch(const T* _items, std::size_t _count)
+  {
+    static_assert(std::is_nothrow_copy_constructible_v<T>,
+                  "MPMCQueue can't publish a cell whose construction threw");
+
+    std::size_t position;
+    std::size_t claimed = ClaimBatch(m_enqueuePosition, position, _count, 0);
+
+    for(std::size_t i = 0; i < claimed; ++i){
+      Cell& cell = m_cells[(position + i) & m_mask];
+      new (cell.m_storage) T(_items[i]);
+      cell.m_sequence.store(position + i + 1, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  /**
+   * @brief Pops up to _count items with a single compare-and-swap
+   * @param _items receives the items
+   * @param _count most items to pop
+   * @return Number of items popped
+   */
+  std::size_t TryPopBatch(T* _items, std::size_t _count)
+  {
+    std::size_t position;
+    std::size_t claimed = ClaimBatch(m_dequeuePosition, position, _count, 1);
+
+    for(std::size_t i = 0; i < claimed; ++i){
+      Cell& cell = m_cells[(position + i) & m_mask];
+      T* stored = std::launder(reinterpret_cast<T*>(cell.m_storage));
+      _items[i] = std::move(*stored);
+      stored->~T();
+      cell.m_sequence.store(position + i + m_mask + 1, std::memory_order_release);
+    }
+    return claimed;
+  }
+
+  /// Returns the number of queued items, only a hint while others use it
+  std::size_t Size() const
+  {
+    std::size_t dequeue = m_dequeuePosition.load(std::memory_order_relaxed);
+    std::size_t enqueue = m_enqueuePosition.load(std::memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  /// Returns true if nothing is queued, only a hint while others use it
+  B8 Empty() const { return Size() == 0; };
+
+  /// Returns the most items the queue can hold
+  std::size_t Capacity() const { return m_mask + 1; };
+
+private:
+  /// Slot of the ring
+  struct Cell
+  {
+    /// Position the cell is ready for: p when free for the producer of
+    /// position p, p + 1 when holding the item for the consumer of p
+    std::atomic<std::size_t> m_sequence;
+
+    /// Storage of the item
+    alignas(T) unsigned char m_storage[sizeof(T)];
+  };
+
+  /// Rounds up to the next power of two, at least 2
+  static std::size_t RoundUpToPowerOfTwo(std::size_t _value)
+  {
+    std::size_t power = 2;
+    while(power < _value)
+      power *= 2;
+    return power;
+  }
+
+  /**
+   * @brief Claims a run of cells that are all ready for one side
+   * @param _counter enqueue or dequeue position
+   * @param _position receives the first claimed position
+   * @param _count most cells to claim
+   * @param _offset 0 to claim free cells, 1 to claim full ones
+   * @return Number of cells claimed
+   */
+  std::size_t ClaimBatch(std::atomic<std::size_t>& _counter,
+                         std::size_t& _position,
+                         std::size_t _count,
+                         std::size_t _offset)
+  {
+    _position = _counter.load(std::memory_order_relaxed);
+    while(true){
+      // Count the ready cells from the current position
+      std::size_t ready = 0;
+      while(ready < _count && ready <= m_mask){
+        const Cell& cell = m_cells[(_position + ready) & m_mask];
+        if(cell.m_sequence.load(std::memory_order_acquire) != _position + ready + _offset)
+          break;
+        ++ready;
+      }
+
+      if(ready == 0){
+        // Someone may have moved the position on while we looked
+        std::size_t current = _counter.load(std::memory_order_relaxed);
+        if(current == _position)
+          return 0;
+        _position = current;
+        continue;
+      }
+
+      if(_counter.compare_exchange_weak(_position, _position + ready, std::memory_order_relaxed))
+        return ready;
+    }
+  }
+
+  /// Capacity minus one, to wrap positions with a mask
+  const std::size_t m_mask;
+
+  /// The ring
+  std::unique_ptr<Cell[]> m_cells;
+
+  /// Next position to push to, on a cache line of its own
+  alignas(64) std::atomic<std::size_t> m_enqueuePosition;
+
+  /// Next position to pop from, on a cache line of its own
+  alignas(64) std::atomic<std::size_t> m_dequeuePosition;
+
+  /// Keeps whatever follows off the dequeue position's cache line
+  char m_padding[64 - sizeof(std::atomic<std::size_t>)];
+};
+};
@@ -8,9 +8,12 @@
  */
 #pragma once
 
+#include <chrono>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <utility>
+#include <vector>
 
 // pint-sized library. Remove this...
 namespace psl
@@ -22,8 +25,12 @@ namespace psl
  *
  * A very thread-safe overlay over std::queue that uses mutex locks to ensure
  * the safety. Locks are slow, however, so this should be used with it in mind.
- * This will hopefully be deprecated soon with LockFreeQueue (renamed to Queue)
- * that is lock-free but still thread-safe.
+ * Unlike MPMCQueue it is unbounded and Pop() blocks until there is something
+ * to pop; hot paths that can handle a full queue should use MPMCQueue.
+ *
+ * To keep the locking down, PushRange() and PopAll() move any number of
+ * objects under a single lock, and TryPop() checks and pops in one go
+ * instead of an Empty() followed by a Pop().
  */
 template <typename T>
 class Queue
@@ -40,6 +47,34 @@ public:
     m_condition.notify_one();
   }
 
+  /**
+   * @brief Moves an object into the queue, and expands if needed
+   * @param _element templated object to move into the queue
+   */
+  void Push(T&& _element)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue.push(std::move(_element));
+    m_condition.notify_one();
+  }
+
+  /**
+   * @brief Pushes a range of objects under a single lock
+   * @param _first iterator to the first object to push
+   * @param _last iterator past the last object to push
+   */
+  template <typename Iterator>
+  void PushRange(Iterator _first, Iterator _last)
+  {
+    if(_first == _last)
+      return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for(; _first != _last; ++_first)
+      m_queue.push(*_first);
+    m_condition.notify_all();
+  }
+
   /**
    * @brief Pops the templated object from the queue's head
    * @return templated object that we obtain from the queue's head.
@@ -48,11 +83,80 @@ public:
   {
     std::unique_lock<std::mutex> lock(m_mutex);
     m_condition.wait(lock, [this]() -> bool { return !m_queue.empty(); });
-    T element = m_queue.front();
+    T element = std::move(m_queue.front());
     m_queue.pop();
     return element;
   };
 
+  /**
+   * @brief Pops the queue's head if there is one, without blocking
+   * @param _element receives the popped object
+   * @return False if the queue was empty
+   */
+  bool TryPop(T& _element)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_queue.empty())
+      return false;
+
+    _element = std::move(m_queue.front());
+    m_queue.pop();
+    return true;
+  }
+
+  /**
+   * @brief Pops the queue's head, waiting for one up to a timeout
+   * @param _element receives the popped object
+   * @param _timeout longest time to wait for
+   * @return False if the queue stayed empty for the whole timeout
+   */
+  template <typename Rep, typename Period>
+  bool TryPopFor(T& _element, const std::chrono::duration<Rep, Period>& _timeout)
+  {
+    return TryPopUntil(_element, std::chrono::steady_clock::now() + _timeout);
+  }
+
+  /**
+   * @brief Pops the queue's head, waiting for one up to a deadline
+   * @param _element receives the popped object
+   * @param _deadline time point to wait until
+   * @return False if the queue stayed empty until the deadline
+   */
+  template <typename Clock, typename Duration>
+  bool TryPopUntil(T& _element, const std::chrono::time_point<Clock, Duration>& _deadline)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(!m_condition.wait_until(lock, _deadline, [this]() -> bool { return !m_queue.empty(); }))
+      return false;
+
+    _element = std::move(m_queue.front());
+    m_queue.pop();
+    return true;
+  }
+
+  /**
+   * @brief Pops every queued object under a single lock
+   *
+   * The objects are moved straight into _elements, so draining doesn't
+   * allocate as long as _elements has the room, and an empty queue is left
+   * alone entirely.
+   *
+   * @param _elements vector the objects are appended to, in queue order
+   * @return Number of objects popped
+   */
+  size_t PopAll(std::vector<T>& _elements)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = m_queue.size();
+    if(count == 0)
+      return 0;
+
+    _elements.reserve(_elements.size() + count);
+    for(; !m_queue.empty(); m_queue.pop())
+      _elements.push_back(std::move(m_queue.front()));
+    return count;
+  }
+
   /// Returns if the queue is empty
   bool Empty()
   {
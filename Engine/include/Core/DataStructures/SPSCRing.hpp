@@ -0,0 +1,272 @@
+/**
+ * @file SPSCRing.hpp
+ * @brief Wait-free single-producer/single-consumer ring of variable-size
+ *        records
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see SPSCRing
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+// pint-sized library. Remove this...
+namespace psl
+{
+
+/**
+ * @class SPSCRing
+ * @brief Byte ring one thread writes records into and one thread reads from
+ *
+ * Meant for pipelines with exactly one producer and one consumer, e.g. the
+ * game thread feeding the render thread or a logger feeding its writer.
+ * Records are written in place: the producer asks for room with
+ * BeginWrite(), fills it and publishes it with CommitWrite(); the consumer
+ * gets the oldest record with BeginRead() and gives the room back with
+ * EndRead(). Neither side ever waits on the other, every call finishes in a
+ * bounded number of steps.
+ *
+ * The head (written by the producer) and the tail (written by the consumer)
+ * sit on their own cache lines, and each side keeps a cached copy of the
+ * other's index, so the shared line is only read when the cached copy says
+ * the ring looks full or empty.
+ *
+ * A record never wraps around the end of the buffer: if it doesn't fit
+ * before the end, the rest of the buffer is skipped and it starts at the
+ * beginning.
+ *
+ * @code
+ *   psl::SPSCRing ring(1 << 16);
+ *
+ *   // Producer
+ *   if(char* text = static_cast<char*>(ring.BeginWrite(256))){
+ *     int length = std::snprintf(text, 256, "frame %u", frame);
+ *     ring.CommitWrite(length);
+ *   }
+ *
+ *   // Consumer
+ *   ring.TryRead([](const void* _data, std::size_t _size) { ... });
+ * @endcode
+ */
+class SPSCRing
+{
+public:
+  /// Alignment of every record's payload
+  static constexpr std::size_t RecordAlignment = 8;
+
+  /**
+   * @brief Creates the ring
+   * @param _capacity size of the buffer in bytes, rounded up to a power of
+   *                  two. A record takes its size plus 8 bytes, rounded up
+   *                  to 8.
+   */
+  explicit SPSCRing(std::size_t _capacity = 65536)
+    : m_capacity(RoundUpToPowerOfTwo(_capacity)),
+      m_mask(m_capacity - 1),
+      m_buffer(static_cast<U8*>(::operator new(m_capacity, std::align_val_t(64))))
+  {
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+  };
+
+  ~SPSCRing()
+  {
+    ::operator delete(m_buffer, std::align_val_t(64));
+  };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(SPSCRing);
+
+  /**
+   * @brief Reserves room for a record, producer only
+   * @param _size size of the record in bytes
+   * @return Where to write the record, aligned to RecordAlignment, or nullptr
+   *         if there is no room for it right now
+   */
+  void* BeginWrite(std::size_t _size)
+  {
+    std::size_t total = RecordSize(_size);
+    if(total > m_capacity)
+      return nullptr;
+
+    std::size_t head = m_head.load(std::memory_order_relaxed);
+    std::size_t offset = head & m_mask;
+    std::size_t contiguous = m_capacity - offset;
+    std::size_t skipped = total > contiguous ? contiguous : 0;
+    std::size_t needed = total + skipped;
+
+    if(m_capacity - (head - m_cachedTail) < needed){
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if(m_capacity - (head - m_cachedTail) < needed)
+        return nullptr;
+    }
+
+    if(skipped){
+      // Tell the consumer to jump to the start of the buffer
+      Header(offset)->m_size = SkipMarker;
+      offset = 0;
+    }
+
+    m_writeRecord = head + skipped;
+    m_writeReserved = _size;
+    Header(offset)->m_size = static_cast<U32>(_size);
+    return m_buffer + offset + sizeof(RecordHeader);
+  }
+
+  /**
+   * @brief Publishes the record reserved by the last BeginWrite()
+   * @param _size bytes actually written, at most the reserved size. The rest
+   *              of the reserved room is given back.
+   */
+  void CommitWrite(std::size_t _size)
+  {
+    if(_size > m_writeReserved)
+      _size = m_writeReserved;
+
+    Header(m_writeRecord & m_mask)->m_size = static_cast<U32>(_size);
+    m_head.store(m_writeRecord + RecordSize(_size), std::memory_order_release);
+  }
+
+  /// Publishes the record reserved by the last BeginWrite(), all of it
+  void CommitWrite() { CommitWrite(m_writeReserved); };
+
+  /**
+   * @brief Copies a record into the ring, producer only
+   * @param _data the record
+   * @param _size size of the record in bytes
+   * @return False if there is no room for it right now
+   */
+  B8 TryWrite(const void* _data, std::size_t _size)
+  {
+    void* record = BeginWrite(_size);
+    if(!record)
+      return false;
+
+    std::memcpy(record, _data, _size);
+    CommitWrite(_size);
+    return true;
+  }
+
+  /**
+   * @brief Gets the oldest record, consumer only
+   * @param _size receives the size of the record
+   * @return The record, or nullptr if the ring is empty. It stays valid until
+   *         EndRead().
+   */
+  const void* BeginRead(std::size_t& _size)
+  {
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail == m_cachedHead){
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if(tail == m_cachedHead)
+        return nullptr;
+    }
+
+    std::size_t offset = tail & m_mask;
+    if(Header(offset)->m_size == SkipMarker){
+      // A skip is always published together with the record after it
+      tail += m_capacity - offset;
+      offset = 0;
+    }
+
+    _size = Header(offset)->m_size;
+    m_readEnd = tail + RecordSize(_size);
+    return m_buffer + offset + sizeof(RecordHeader);
+  }
+
+  /// Gives the room of the record from the last BeginRead() back
+  void EndRead()
+  {
+    m_tail.store(m_readEnd, std::memory_order_release);
+  }
+
+  /**
+   * @brief Passes the oldest record to a function, then frees it
+   * @param _function called with (const void* data, std::size_t size)
+   * @return False if the ring was empty
+   */
+  template <typename Function>
+  B8 TryRead(Function&& _function)
+  {
+    std::size_t size;
+    const void* record = BeginRead(size);
+    if(!record)
+      return false;
+
+    _function(record, size);
+    EndRead();
+    return true;
+  }
+
+  /// Returns true if there is nothing to read, only a hint for the producer
+  B8 Empty() const
+  {
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+  }
+
+  /// Returns the size of the buffer in bytes
+  std::size_t Capacity() const { return m_capacity; };
+
+private:
+  /// Precedes every record in the buffer
+  struct RecordHeader
+  {
+    /// Size of the record, or SkipMarker
+    U32 m_size;
+    U32 m_reserved;
+  };
+
+  /// Header size marking the rest of the buffer as unused
+  static constexpr U32 SkipMarker = 0xffffffff;
+
+  /// Bytes a record of _size bytes takes in the buffer
+  static constexpr std::size_t RecordSize(std::size_t _size)
+  {
+    return (sizeof(RecordHeader) + _size + RecordAlignment - 1) & ~(RecordAlignment - 1);
+  }
+
+  /// Rounds up to the next power of two, at least 64
+  static std::size_t RoundUpToPowerOfTwo(std::size_t _value)
+  {
+    std::size_t power = 64;
+    while(power < _value)
+      power *= 2;
+    return power;
+  }
+
+  /// Returns the header at a buffer offset
+  RecordHeader* Header(std::size_t _offset)
+  {
+    return reinterpret_cast<RecordHeader*>(m_buffer + _offset);
+  }
+
+  /// Size of the buffer and the mask to wrap positions with
+  const std::size_t m_capacity;
+  const std::size_t m_mask;
+
+  /// The buffer, positions are byte offsets that only ever grow
+  U8* const m_buffer;
+
+  /// Producer's line: end of the published records, its copy of the tail
+  /// and the record being written
+  alignas(64) std::atomic<std::size_t> m_head;
+  std::size_t m_cachedTail = 0;
+  std::size_t m_writeRecord = 0;
+  std::size_t m_writeReserved = 0;
+
+  /// Consumer's line: start of the unread records, its copy of the head and
+  /// the end of the record being read
+  alignas(64) std::atomic<std::size_t> m_tail;
+  std::size_t m_cachedHead = 0;
+  std::size_t m_readEnd = 0;
+
+  /// Keeps whatever follows off the consumer's cache line
+  char m_padding[64 - 3 * sizeof(std::size_t)];
+};
+};
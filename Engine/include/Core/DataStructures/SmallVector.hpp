@@ -0,0 +1,290 @@
+/**
+ * @file SmallVector.hpp
+ * @brief Vector keeping its first few elements inline
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see SmallVector
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/MemoryResource.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @class SmallVector
+ * @brief Contiguous vector with room for N elements inside the object itself
+ *
+ * Meant for the short lists the engine keeps per object, like the
+ * dependencies of a task or the handlers of an event type: most of them hold
+ * a handful of elements, so they never touch an allocator. Past N the
+ * elements move to a block from SmallObjectMemoryResource, growing by
+ * doubling like std::vector.
+ *
+ * Iterators and references are invalidated whenever the vector grows, and a
+ * moved-from vector is left empty. The spilled block is never given back to
+ * the inline storage, Clear() keeps the capacity.
+ *
+ * @tparam T type of the elements
+ * @tparam N number of elements stored inline
+ */
+template <typename T, std::size_t N>
+class SmallVector
+{
+  static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+public:
+  using value_type      = T;
+  using size_type       = std::size_t;
+  using reference       = T&;
+  using const_reference = const T&;
+  using iterator        = T*;
+  using const_iterator  = const T*;
+
+  SmallVector() = default;
+
+  SmallVector(std::initializer_list<T> _values)
+  {
+    CopyFrom(_values.begin(), _values.size());
+  };
+
+  SmallVector(const SmallVector& _other)
+  {
+    CopyFrom(_other.begin(), _other.m_size);
+  };
+
+  SmallVector(SmallVector&& _other) noexcept(std::is_nothrow_move_constructible_v<T>)
+  {
+    TakeFrom(_other);
+  };
+
+  SmallVector& operator=(const SmallVector& _other)
+  {
+    if(this == &_other)
+      return *this;
+
+    Clear();
+    CopyFrom(_other.begin(), _other.m_size);
+    return *this;
+  };
+
+  SmallVector& operator=(SmallVector&& _other) noexcept(std::is_nothrow_move_constructible_v<T>)
+  {
+    if(this == &_other)
+      return *this;
+
+    Clear();
+    Release();
+    TakeFrom(_other);
+    return *this;
+  };
+
+  ~SmallVector()
+  {
+    Clear();
+    Release();
+  };
+
+  /**
+   * @brief Constructs an element at the back
+   * @param _args arguments forwarded to the constructor of T, may refer to an
+   *        element of this vector
+   * @return Reference to the new element
+   */
+  template <typename... Args>
+  T& EmplaceBack(Args&&... _args)
+  {
+    if(m_size < m_capacity){
+      T* element = ::new (static_cast<void*>(m_data + m_size)) T(std::forward<Args>(_args)...);
+      ++m_size;
+      return *element;
+    }
+
+    // Build the new element before moving the old ones, the arguments could
+    // still point into them
+    size_type capacity = m_capacity * 2;
+    T* data = Allocate(capacity);
+    T* element = nullptr;
+    try {
+      element = ::new (static_cast<void*>(data + m_size)) T(std::forward<Args>(_args)...);
+    }
+    catch(...){
+      Deallocate(data, capacity);
+      throw;
+    }
+
+    MoveTo(data, capacity);
+    ++m_size;
+    return *element;
+  }
+
+  /// Copies an element to the back
+  void PushBack(const T& _value) { EmplaceBack(_value); };
+
+  /// Moves an element to the back
+  void PushBack(T&& _value) { EmplaceBack(std::move(_value)); };
+
+  /// Destroys the last element
+  void PopBack()
+  {
+    --m_size;
+    std::destroy_at(m_data + m_size);
+  }
+
+  /**
+   * @brief Removes an element, moving the ones after it forward
+   * @param _position element to remove
+   * @return Iterator to the element that followed the removed one
+   */
+  iterator Erase(const_iterator _position)
+  {
+    iterator position = m_data + (_position - m_data);
+    std::move(position + 1, end(), position);
+    PopBack();
+    return position;
+  }
+
+  /// Destroys all the elements, keeping the capacity
+  void Clear()
+  {
+    std::destroy(m_data, m_data + m_size);
+    m_size = 0;
+  }
+
+  /**
+   * @brief Makes room for at least _capacity elements
+   * @param _capacity number of elements to make room for
+   */
+  void Reserve(size_type _capacity)
+  {
+    if(_capacity <= m_capacity)
+      return;
+    MoveTo(Allocate(_capacity), _capacity);
+  }
+
+  /// @name Element access, unchecked
+  /// @{
+  T& operator[](size_type _index) { return m_data[_index]; };
+  const T& operator[](size_type _index) const { return m_data[_index]; };
+
+  T& Front() { return m_data[0]; };
+  const T& Front() const { return m_data[0]; };
+
+  T& Back() { return m_data[m_size - 1]; };
+  const T& Back() const { return m_data[m_size - 1]; };
+
+  T* Data() { return m_data; };
+  const T* Data() const { return m_data; };
+  /// @}
+
+  /// @name Iteration
+  /// @{
+  iterator begin() { return m_data; };
+  iterator end() { return m_data + m_size; };
+  const_iterator begin() const { return m_data; };
+  const_iterator end() const { return m_data + m_size; };
+  /// @}
+
+  /// Number of elements
+  size_type Size() const { return m_size; };
+
+  /// True if there are no elements
+  B8 Empty() const { return m_size == 0; };
+
+  /// Number of elements that fit without growing
+  size_type Capacity() const { return m_capacity; };
+
+  /// True while the elements are still stored inside the vector
+  B8 IsInline() const { return m_data == InlineData(); };
+
+  /// Number of elements stored inline
+  static constexpr size_type InlineCapacity() { return N; };
+
+private:
+  T* InlineData() { return reinterpret_cast<T*>(m_inline); };
+  const T* InlineData() const { return reinterpret_cast<const T*>(m_inline); };
+
+  static T* Allocate(size_type _capacity)
+  {
+    return static_cast<T*>(SmallObjectMemoryResource::GetInstance().allocate(_capacity * sizeof(T), alignof(T)));
+  }
+
+  static void Deallocate(T* _data, size_type _capacity)
+  {
+    SmallObjectMemoryResource::GetInstance().deallocate(_data, _capacity * sizeof(T), alignof(T));
+  }
+
+  /// Moves the elements to a new block and frees the old one
+  void MoveTo(T* _data, size_type _capacity)
+  {
+    std::uninitialized_move(m_data, m_data + m_size, _data);
+    std::destroy(m_data, m_data + m_size);
+    Release();
+    m_data = _data;
+    m_capacity = _capacity;
+  }
+
+  /// Frees the spilled block, if any, and goes back to the inline storage
+  void Release()
+  {
+    if(!IsInline())
+      Deallocate(m_data, m_capacity);
+    m_data = InlineData();
+    m_capacity = N;
+  }
+
+  /// Copies _count elements into this empty vector. If a copy throws, the
+  /// vector is left empty and inline.
+  void CopyFrom(const T* _values, size_type _count)
+  {
+    Reserve(_count);
+    try {
+      std::uninitialized_copy(_values, _values + _count, m_data);
+    }
+    catch(...){
+      // A constructor that throws never runs the destructor
+      Release();
+      throw;
+    }
+    m_size = _count;
+  }
+
+  /// Takes over the elements of _other, this vector must be empty and inline
+  void TakeFrom(SmallVector& _other)
+  {
+    if(_other.IsInline()){
+      std::uninitialized_move(_other.begin(), _other.end(), m_data);
+      m_size = _other.m_size;
+      _other.Clear();
+      return;
+    }
+
+    // Steal the spilled block
+    m_data = _other.m_data;
+    m_size = _other.m_size;
+    m_capacity = _other.m_capacity;
+    _other.m_data = _other.InlineData();
+    _other.m_size = 0;
+    _other.m_capacity = N;
+  }
+
+  /// Elements, pointing at m_inline until the vector spills
+  T* m_data = InlineData();
+
+  /// Number of constructed elements
+  size_type m_size = 0;
+
+  /// Number of elements m_data has room for
+  size_type m_capacity = N;
+
+  /// Storage for the first N elements
+  alignas(T) std::byte m_inline[N * sizeof(T)];
+};
@@ -0,0 +1,214 @@
+/**
+ * @file WorkStealingDeque.hpp
+ * @brief Lock-free Chase-Lev deque for one owner and any number of thieves
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see WorkStealingDeque
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// pint-sized library. Remove this...
+namespace psl
+{
+
+/**
+ * @class WorkStealingDeque
+ * @brief Deque the owning thread pushes to and pops from at the bottom,
+ *        while other threads steal from the top
+ *
+ * The Chase-Lev deque, with the C11 memory orderings of Le et al. The owner
+ * works LIFO on its own end without any read-modify-write unless it is down
+ * to the last item; thieves take the oldest item with one compare-and-swap
+ * on the top index. A full ring is copied to one twice the size by the
+ * owner. Thieves may still be reading the old ring, so it is kept until the
+ * deque is destroyed; since every ring is twice the one before, that at most
+ * doubles the memory held.
+ *
+ * Push() and TryPop() may only be called by the owning thread, TrySteal()
+ * by any thread.
+ *
+ * @tparam T type of the items, has to be trivially copyable since thieves
+ *           copy an item before they know whether it is theirs. Pointers or
+ *           indices to the actual work fit.
+ */
+template <typename T>
+class WorkStealingDeque
+{
+  static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque items have to be trivially copyable");
+
+public:
+  /**
+   * @brief Creates the deque
+   * @param _capacity number of items the first ring holds, rounded up to a
+   *                  power of two
+   */
+  explicit WorkStealingDeque(std::size_t _capacity = 256)
+  {
+    m_rings.push_back(std::make_unique<Ring>(RoundUpToPowerOfTwo(_capacity)));
+    m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    m_top.store(0, std::memory_order_relaxed);
+    m_bottom.store(0, std::memory_order_relaxed);
+  };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(WorkStealingDeque);
+
+  /**
+   * @brief Pushes an item at the bottom, growing the ring if it is full.
+   *        Owner only.
+   * @param _item the item
+   */
+  void Push(const T& _item)
+  {
+    I64 bottom = m_bottom.load(std::memory_order_relaxed);
+    I64 top = m_top.load(std::memory_order_acquire);
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+
+    if(bottom - top > ring->m_mask)
+      ring = Grow(ring, top, bottom);
+
+    ring->Put(bottom, _item);
+    // Publishes the item to the thieves reading the bottom. Sequentially
+    // consistent, so a seq_cst load the owner makes next can't be answered
+    // before a thief can see the item, which is what lets a pusher check for
+    // sleeping thieves without a read-modify-write.
+    m_bottom.store(bottom + 1, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Pops the item pushed last. Owner only.
+   * @param _item receives the item
+   * @return False if the deque is empty, or a thief took the last item
+   */
+  B8 TryPop(T& _item)
+  {
+    I64 bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Ring* ring = m_ring.load(std::memory_order_relaxed);
+
+    // Reserve the bottom item before looking at the top. Both have to be
+    // sequentially consistent so a thief can't miss the reservation while
+    // the owner misses the thief's.
+    m_bottom.store(bottom, std::memory_order_seq_cst);
+    I64 top = m_top.load(std::memory_order_seq_cst);
+
+    if(top > bottom){
+      // Empty, undo the reservation
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    T item = ring->Get(bottom);
+    if(top == bottom){
+      // The last item, race the thieves for it
+      B8 won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      if(!won)
+        return false;
+    }
+
+    _item = item;
+    return true;
+  }
+
+  /**
+   * @brief Steals the item pushed first. Any thread.
+   * @param _item receives the item
+   * @return False if the deque is empty, or another thread got the item
+   *         first; either way it's worth trying elsewhere
+   */
+  B8 TrySteal(T& _item)
+  {
+    I64 top = m_top.load(std::memory_order_seq_cst);
+    I64 bottom = m_bottom.load(std::memory_order_seq_cst);
+    if(top >= bottom)
+      return false;
+
+    Ring* ring = m_ring.load(std::memory_order_acquire);
+    T item = ring->Get(top);
+    if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return false;
+
+    _item = item;
+    return true;
+  }
+
+  /// Returns the number of items, only a hint while others use it
+  std::size_t Size() const
+  {
+    I64 bottom = m_bottom.load(std::memory_order_relaxed);
+    I64 top = m_top.load(std::memory_order_relaxed);
+    return bottom > top ? std::size_t(bottom - top) : 0;
+  }
+
+  /// Returns true if there are no items, only a hint while others use it
+  B8 Empty() const { return Size() == 0; };
+
+  /// Returns the number of items the current ring holds
+  std::size_t Capacity() const { return std::size_t(m_ring.load(std::memory_order_acquire)->m_mask + 1); };
+
+private:
+  /// Circular storage, indexed by the ever-growing top and bottom indices
+  struct Ring
+  {
+    explicit Ring(std::size_t _capacity)
+      : m_mask(I64(_capacity) - 1),
+        m_items(new std::atomic<T>[_capacity])
+    {};
+
+    /// Items are atomic since a thief can read a slot the owner is
+    /// overwriting; the thief then loses the compare-and-swap and drops it
+    T Get(I64 _index) const { return m_items[_index & m_mask].load(std::memory_order_relaxed); };
+
+    void Put(I64 _index, const T& _item) { m_items[_index & m_mask].store(_item, std::memory_order_relaxed); };
+
+    /// Capacity minus one, to wrap indices with a mask
+    const I64 m_mask;
+
+    std::unique_ptr<std::atomic<T>[]> m_items;
+  };
+
+  /// Rounds up to the next power of two, at least 2
+  static std::size_t RoundUpToPowerOfTwo(std::size_t _value)
+  {
+    std::size_t power = 2;
+    while(power < _value)
+      power *= 2;
+    return power;
+  }
+
+  /// Copies the items to a ring twice the size and makes it current
+  Ring* Grow(Ring* _ring, I64 _top, I64 _bottom)
+  {
+    m_rings.push_back(std::make_unique<Ring>(std::size_t(_ring->m_mask + 1) * 2));
+    Ring* ring = m_rings.back().get();
+    for(I64 index = _top; index < _bottom; ++index)
+      ring->Put(index, _ring->Get(index));
+    m_ring.store(ring, std::memory_order_release);
+    return ring;
+  }
+
+  /// Every ring the deque has had, the last one current. Owner only.
+  std::vector<std::unique_ptr<Ring>> m_rings;
+
+  /// Ring the items are in
+  std::atomic<Ring*> m_ring;
+
+  /// Index of the oldest item, moved on by thieves and the owner's last pop
+  alignas(64) std::atomic<I64> m_top;
+
+  /// Index one past the newest item, only written by the owner
+  alignas(64) std::atomic<I64> m_bottom;
+
+  /// Keeps whatever follows off the bottom index's cache line
+  char m_padding[64 - sizeof(std::atomic<I64>)];
+};
+};
@@ -12,6 +12,7 @@
 
 #include "defines.h"
 #include "Core/EntityComponentSystem/System.hpp"
+#include "Core/Memory/MemoryStats.hpp"
 
 #include <unordered_map>
 #include <typeinfo>
@@ -28,6 +29,9 @@ class ComponentBase
 {
 public:
   virtual ~ComponentBase() = default;
+
+  /// Components are accounted to the ECS memory budget
+  static constexpr MemoryTag s_memoryTag = MEMORY_TAG_ECS;
 };
 
 /**
@@ -53,6 +57,9 @@ private:
   static unsigned int m_nextId;
 
 public:
+  /// Entities are accounted to the ECS memory budget
+  static constexpr MemoryTag s_memoryTag = MEMORY_TAG_ECS;
+
   /**
    * @brief Default constructor. Should have a unique ID.
    *
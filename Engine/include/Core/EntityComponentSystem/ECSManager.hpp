@@ -12,7 +12,9 @@
 #include "Core/EntityComponentSystem/ECSEntity.hpp"
 #include "Core/Memory/Allocator.hpp"
 
+#include <memory_resource>
 #include <typeinfo>
+#include <unordered_map>
 #include <vector>
 #include <typeindex>
 
@@ -28,13 +30,20 @@
 class ECSManager
 {
 private:
-  /// @brief Vector of entities
+  /// @brief Vector of entities, allocated from the small-object pools
   /// @todo TODO: Implement our own, faster vector?
-  std::vector<Entity*> m_entities;
+  std::pmr::vector<Entity*> m_entities;
 
   /// @brief Map of component types, holding maps of components for each entity.
+  /// Nodes of both levels are allocated from the small-object pools.
   /// @todo TODO: unsigned int -> const Entity&?
-  std::unordered_map<std::type_index, std::unordered_map<U32, ComponentBase*>> m_components;
+  std::pmr::unordered_map<std::type_index, std::pmr::unordered_map<U32, ComponentBase*>> m_components;
+
+  /// @brief Destroys a component as its concrete type, so it goes back to the right pool
+  using ComponentDeleter = void(*)(ComponentBase*);
+
+  /// @brief Deleter for each component type
+  std::unordered_map<std::type_index, ComponentDeleter> m_componentDeleters;
 
   /// @brief Vector of systems operating on entities
   /// @todo TODO: Implement our own, faster vector?
@@ -57,7 +66,7 @@ public:
    * @brief Creates and assigns a component to an entity
    *
    * Creates a new component and assigns it to already-existing Entity
-   * object. It uses our own custom memory allocator.
+   * object. It is constructed in place in our own custom memory allocator.
    * @todo TODO: Test for speed with different memory allocators
    *
    * @tparam C Component's typename 
@@ -12,11 +12,14 @@
 #include "Core/Event/EventTypes.h"
 #include "Core/Event/Event.hpp"
 #include "Core/DataStructures/Queue.hpp"
+#include "Core/DataStructures/SmallVector.hpp"
 #include "Core/Logging/LogManager.hpp"
 
 #include <algorithm>
 #include <functional>
 #include <map>
+#include <memory_resource>
+#include <vector>
 
 using EventFunction = std::function<void(const Event&)>;
 
@@ -61,11 +64,16 @@ private:
    * For now it is empty, and it might stay that way.
    */
   EventSystem();
-  /// Map of event types and vectors of subscribed handlers for each event type
-  std::map<EventType, std::vector<EventFunction>> m_handlers;
+  /// Map of event types and the handlers subscribed to each, allocated from
+  /// the small-object pools. Few handlers subscribe to any one type, so they
+  /// are kept inside the map's nodes.
+  std::pmr::map<EventType, SmallVector<EventFunction, 4>> m_handlers;
 
   /// The event queue
   psl::Queue<Event> m_queue;
+
+  /// Events taken off the queue by Update(), kept to reuse its capacity
+  std::vector<Event> m_dispatchBuffer;
 };
 
 /// Subscribes an object to handle a type of an event with specified function
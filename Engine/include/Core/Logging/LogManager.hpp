@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
 #include <unordered_map>
 #include <format>
 #include <stdarg.h>
@@ -90,13 +91,14 @@ public:
 
 private:
   /// Private songleton constructor 
-  LogManager() {};
+  LogManager();
 
-  /// Map of the loggers, each with different logger name
-  std::unordered_map<std::string, Logger> m_loggers;
+  /// Map of the loggers, each with different logger name. Allocated from the
+  /// small-object pools, like the rest of the maps here.
+  std::pmr::unordered_map<std::string, Logger> m_loggers;
 
   /// Map of the files, different for each logger and each level of each logger
-  std::unordered_map<std::string, std::unordered_map<LogLevel, std::string>> m_logFiles;
+  std::pmr::unordered_map<std::string, std::pmr::unordered_map<LogLevel, std::string>> m_logFiles;
 };
 
 /// Reguisters a new logger
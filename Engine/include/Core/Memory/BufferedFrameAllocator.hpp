@@ -0,0 +1,146 @@
+/**
+ * @file BufferedFrameAllocator.hpp
+ * @brief Multi-slot frame arena for data that must outlive its frame
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see BufferedFrameAllocator
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @class BufferedFrameAllocator
+ * @brief Ring of N bump arenas, one per frame
+ *
+ * Memory allocated in frame F stays valid until frame F + N starts, without a
+ * heap allocation or a shared_ptr. With the default two slots that is data
+ * written in one frame and read in the next: deferred ECS changes, queued
+ * events. Render-side data uses one slot per swapchain frame in flight.
+ *
+ * Allocate() is lock-free and may be called from any thread. NextFrame() must
+ * be called by one thread while nobody allocates. Destructors are never run.
+ */
+class BufferedFrameAllocator
+{
+public:
+  /**
+   * @brief Creates the arena
+   * @param _slotSize size of each frame's slot in bytes
+   * @param _slotCount number of frames the memory survives, at least 1
+   */
+  BufferedFrameAllocator(std::size_t _slotSize, U8 _slotCount = 2);
+
+  ~BufferedFrameAllocator();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(BufferedFrameAllocator);
+
+  /**
+   * @brief The engine-wide double-buffered arena, flipped by Application::Run
+   *
+   * Sized with "buffered_frame_allocator_size" from the engine config.
+   */
+  static BufferedFrameAllocator& GetInstance();
+
+  /**
+   * @brief Sets the slot size of GetInstance(), call before its first use
+   * @param _slotSize size of each frame's slot in bytes
+   */
+  static void InitializeInstance(std::size_t _slotSize);
+
+  /// Flips to the next slot, recycling the memory from N frames ago
+  void NextFrame();
+
+  /**
+   * @brief Allocates memory that stays valid for the next N-1 frames too
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   * @return The block, never nullptr
+   */
+  void* Allocate(std::size_t _size, std::size_t _alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Allocates uninitialised memory for an array of T
+   * @param _count number of objects
+   */
+  template <typename T>
+  T* Allocate(std::size_t _count = 1)
+  {
+    return static_cast<T*>(Allocate(_count * sizeof(T), alignof(T)));
+  }
+
+  /**
+   * @brief Constructs a T in the arena. Its destructor will never run.
+   * @param _args arguments passed to T's constructor
+   */
+  template <typename T, typename... Args>
+  T* New(Args&&... _args)
+  {
+    return new (Allocate<T>()) T(std::forward<Args>(_args)...);
+  }
+
+  /// Returns the number of slots, i.e. frames the memory survives
+  U8 GetSlotCount() const { return static_cast<U8>(m_slots.size()); };
+
+  /// Returns the size of each slot in bytes
+  std::size_t GetSlotSize() const { return m_slotSize; };
+
+  /// Returns the slot allocations currently go to
+  U32 GetCurrentSlot() const { return m_current; };
+
+  /// Returns the most bytes used by a single frame so far
+  std::size_t GetHighWaterMark() const { return m_peak.load(std::memory_order_relaxed); };
+
+private:
+  /// One frame's worth of memory
+  struct Slot
+  {
+    /// Start of the slot's memory
+    U8* m_buffer = nullptr;
+
+    /// Offset of the first free byte, may run past the slot size
+    std::atomic<std::size_t> m_offset{0};
+
+    /// Heap blocks for allocations that didn't fit
+    std::vector<void*> m_overflow;
+
+    /// Guards m_overflow
+    std::mutex m_overflowMutex;
+  };
+
+  /// Frees a slot's heap blocks and rewinds it
+  void Recycle(Slot& _slot);
+
+private:
+  /// Size of each slot in bytes
+  std::size_t m_slotSize;
+
+  /// Memory of all the slots
+  U8* m_memory;
+
+  /// The slots, one per frame
+  std::vector<std::unique_ptr<Slot>> m_slots;
+
+  /// Index of the slot allocations currently go to
+  U32 m_current;
+
+  /// Most bytes used by a single frame
+  std::atomic<std::size_t> m_peak;
+
+  /// Slot size the engine-wide instance gets created with
+  static std::size_t m_instanceSlotSize;
+};
+
+/// Macro that returns the engine-wide double-buffered frame arena
+#define BUFFEREDFRAMEALLOC() \
+  BufferedFrameAllocator::GetInstance()
@@ -0,0 +1,195 @@
+/**
+ * @file FrameAllocator.hpp
+ * @brief Per-frame scratch memory, recycled once per application loop
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see FrameAllocator
+ * @see FrameStdAllocator
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/LinearAllocator.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @class FrameAllocator
+ * @brief Singleton bump allocator whose memory only lives for one frame
+ *
+ * Meant for scratch data such as event payloads, ready-task lists and render
+ * command lists. Every thread allocates from its own region of
+ * "frame_allocator_size" bytes, so threads never contend with each other.
+ * Application::Run calls NextFrame() at the top of every loop iteration, after
+ * which all the memory handed out in the previous frame is reused.
+ *
+ * Destructors are never run, so only put trivially destructible data here, or
+ * data whose destructor doesn't own anything. Running out of a region falls
+ * back to the heap until the end of the frame, and shows up in the high-water
+ * mark.
+ *
+ * A thread's region is handed back when the thread exits and given to the
+ * next new thread, so short-lived threads don't pile up regions. What the
+ * exited thread allocated stays valid until the frame ends, the next owner
+ * only bumps past it.
+ */
+class FrameAllocator
+{
+public:
+  /// Singleton instance getter
+  static FrameAllocator& GetInstance();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(FrameAllocator);
+
+  /**
+   * @brief Sets the size of each thread's region
+   *
+   * Only affects regions created afterwards, so call it before any thread
+   * allocates.
+   *
+   * @param _regionSize size of each thread's region in bytes
+   */
+  void Initialize(std::size_t _regionSize);
+
+  /// Starts a new frame, recycling all the memory of the previous one
+  void NextFrame();
+
+  /**
+   * @brief Allocates memory that stays valid until the next frame starts
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   * @return The block, never nullptr
+   */
+  void* Allocate(std::size_t _size, std::size_t _alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Allocates uninitialised memory for an array of T
+   * @param _count number of objects
+   */
+  template <typename T>
+  T* Allocate(std::size_t _count = 1)
+  {
+    return static_cast<T*>(Allocate(_count * sizeof(T), alignof(T)));
+  }
+
+  /**
+   * @brief Constructs a T in frame memory. Its destructor will never run.
+   * @param _args arguments passed to T's constructor
+   */
+  template <typename T, typename... Args>
+  T* New(Args&&... _args)
+  {
+    return new (Allocate<T>()) T(std::forward<Args>(_args)...);
+  }
+
+  /// Returns the index of the current frame
+  U64 GetFrameIndex() const { return m_frameIndex.load(std::memory_order_relaxed); };
+
+  /// Returns the size of each thread's region in bytes
+  std::size_t GetRegionSize() const { return m_regionSize; };
+
+  /// Returns the most bytes any thread used in a single frame so far
+  std::size_t GetHighWaterMark() const;
+
+  /// Logs the high-water mark against the configured region size
+  void ReportHighWaterMark() const;
+
+private:
+  /// Memory of one thread
+  struct Region
+  {
+    /// Bump allocator over the region's buffer
+    LinearAllocator m_arena;
+
+    /// Frame the region was last recycled in
+    U64 m_frame = 0;
+
+    /// Bytes that didn't fit in this frame and went to the heap
+    std::size_t m_overflowBytes = 0;
+
+    /// Heap blocks to free when the region is next recycled
+    std::vector<void*> m_overflow;
+
+    /// Most bytes used in a single frame, written only by the owning thread
+    std::atomic<std::size_t> m_peak{0};
+
+    /// Set while a thread owns the region, guarded by m_regionsMutex
+    B8 m_inUse = false;
+  };
+
+  /// Hands the calling thread's region back to the allocator when it exits
+  struct RegionOwner
+  {
+    Region* m_region = nullptr;
+
+    ~RegionOwner();
+  };
+
+  FrameAllocator();
+  ~FrameAllocator();
+
+  /// Returns the calling thread's region, recycled if a new frame started
+  Region& GetRegion();
+
+  /// Gives the calling thread a region left by an exited thread, or a new one
+  Region& AcquireRegion();
+
+  /// Makes a region free for the next thread to take
+  void ReleaseRegion(Region& _region);
+
+  /// Frees the heap blocks of a region and rewinds it
+  void Recycle(Region& _region);
+
+private:
+  /// Size of each thread's region in bytes
+  std::size_t m_regionSize;
+
+  /// Index of the current frame
+  std::atomic<U64> m_frameIndex;
+
+  /// Every thread's region, never shrinks so threads can keep pointers
+  std::deque<Region> m_regions;
+
+  /// Guards creating, taking and handing back regions
+  mutable std::mutex m_regionsMutex;
+};
+
+/**
+ * @class FrameStdAllocator
+ * @brief Standard-library allocator handing out frame memory
+ *
+ * Lets std containers used as per-frame scratch avoid the heap. Deallocation
+ * is a no-op, so the container must not outlive the frame.
+ */
+template <typename T>
+class FrameStdAllocator
+{
+public:
+  using value_type = T;
+
+  FrameStdAllocator() = default;
+
+  template <typename U>
+  FrameStdAllocator(const FrameStdAllocator<U>&) {};
+
+  T* allocate(std::size_t _count)
+  {
+    return FrameAllocator::GetInstance().Allocate<T>(_count);
+  }
+
+  void deallocate(T*, std::size_t) {};
+
+  template <typename U>
+  bool operator==(const FrameStdAllocator<U>&) const { return true; };
+};
+
+/// Macro that returns the frame allocator's singleton instance
+#define FRAMEALLOC() \
+  FrameAllocator::GetInstance()
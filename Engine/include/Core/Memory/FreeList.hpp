@@ -0,0 +1,171 @@
+/**
+ * @file FreeList.hpp
+ * @brief Lock-free intrusive free list used by the pool allocators
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see FreeList
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstdint>
+
+/// Keeps ThreadSanitizer out of a function, see FreeList::PeekNext()
+#if defined(__GNUC__) || defined(__clang__)
+  #define FREELIST_NO_TSAN __attribute__((no_sanitize("thread")))
+#else
+  #define FREELIST_NO_TSAN
+#endif
+
+/**
+ * @class FreeList
+ * @brief Lock-free LIFO stack of free memory blocks
+ *
+ * The links live inside the free blocks themselves, so the list needs no
+ * memory of its own. The head is a tagged pointer: the upper bits hold a
+ * counter that changes on every update, which makes the compare-and-swap fail
+ * if the head was popped and pushed back in between (the ABA problem).
+ *
+ * Blocks must stay mapped for as long as the list is in use, since a racing
+ * Pop() can read the link of a block that another thread just took.
+ */
+class FreeList
+{
+public:
+  /// Link stored in the first bytes of every free block
+  struct Node
+  {
+    Node* m_next;
+  };
+
+  FreeList() : m_head(0) {};
+
+  NOCOPY(FreeList);
+
+  /**
+   * @brief Pushes a single free block
+   * @param _node block to push
+   */
+  void Push(Node* _node)
+  {
+    Push(_node, _node);
+  }
+
+  /**
+   * @brief Pushes a chain of blocks already linked from _first to _last
+   * @param _first first block of the chain
+   * @param _last last block of the chain, its link gets overwritten
+   */
+  void Push(Node* _first, Node* _last)
+  {
+    U64 head = m_head.load(std::memory_order_relaxed);
+    do{
+      StoreNext(_last, Pointer(head));
+    } while(!m_head.compare_exchange_weak(head, Pack(_first, Tag(head) + 1),
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief Pops a single free block
+   * @return The block, or nullptr if the list is empty
+   */
+  Node* Pop()
+  {
+    U64 head = m_head.load(std::memory_order_acquire);
+    while(Pointer(head) != nullptr){
+      Node* node = Pointer(head);
+      // May read a block another thread has just popped, but then the tag has
+      // changed and the exchange fails
+      U64 next = Pack(PeekNext(node), Tag(head) + 1);
+      if(m_head.compare_exchange_weak(head, next,
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire))
+        return node;
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Detaches the whole list in one operation
+   * @return First block of the detached chain, or nullptr if empty
+   */
+  Node* PopAll()
+  {
+    U64 head = m_head.load(std::memory_order_acquire);
+    while(Pointer(head) != nullptr){
+      if(m_head.compare_exchange_weak(head, Pack(nullptr, Tag(head) + 1),
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire))
+        return Pointer(head);
+    }
+    return nullptr;
+  }
+
+  /// Returns true if there are no free blocks. Only a hint under contention.
+  B8 Empty() const
+  {
+    return Pointer(m_head.load(std::memory_order_relaxed)) == nullptr;
+  }
+
+  /// Reads a block's link
+  static Node* LoadNext(Node* _node)
+  {
+    return std::atomic_ref<Node*>(_node->m_next).load(std::memory_order_relaxed);
+  }
+
+  /// Writes a block's link
+  static void StoreNext(Node* _node, Node* _next)
+  {
+    std::atomic_ref<Node*>(_node->m_next).store(_next, std::memory_order_relaxed);
+  }
+
+private:
+  /**
+   * @brief Reads the link of a block that may no longer be free
+   *
+   * Pop() reads the link of the head block before its compare-and-swap. If
+   * another thread pops that block first, it may already be constructing an
+   * object over the link with plain stores, which ThreadSanitizer rightly
+   * reports as a race. The value read is then garbage, but the head's tag
+   * has changed by then so the exchange fails and the value is dropped, and
+   * the block stays mapped since pools never unmap chunks in use. The read
+   * is still atomic, only hidden from the sanitizer.
+   */
+  FREELIST_NO_TSAN static Node* PeekNext(Node* _node)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&_node->m_next, __ATOMIC_RELAXED);
+#else
+    return LoadNext(_node);
+#endif
+  }
+
+  /// Bits of the head used by the pointer, the rest hold the tag. User-space
+  /// addresses fit in 48 bits on x86-64 and AArch64.
+  static constexpr U64 PointerBits = sizeof(void*) == 8 ? 48 : 32;
+  static constexpr U64 PointerMask = (U64(1) << PointerBits) - 1;
+
+  static U64 Pack(Node* _node, U64 _tag)
+  {
+    return (static_cast<U64>(reinterpret_cast<std::uintptr_t>(_node)) & PointerMask) |
+           (_tag << PointerBits);
+  }
+
+  static Node* Pointer(U64 _head)
+  {
+    return reinterpret_cast<Node*>(static_cast<std::uintptr_t>(_head & PointerMask));
+  }
+
+  static U64 Tag(U64 _head)
+  {
+    return _head >> PointerBits;
+  }
+
+private:
+  /// Tagged pointer to the first free block
+  std::atomic<U64> m_head;
+};
@@ -0,0 +1,355 @@
+/**
+ * @file HandlePool.hpp
+ * @brief Pool addressed by generational handles, able to compact itself
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see Handle
+ * @see HandlePool
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Logging/LogManager.hpp"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/// Bits of a handle used for the slot index, the rest hold the generation
+#define HANDLE_INDEX_BITS 20
+
+/**
+ * @class Handle
+ * @brief 32-bit reference to an object in a HandlePool
+ *
+ * Holds the index of a slot and the generation the slot had when the object
+ * was created. Destroying the object bumps the slot's generation, so the
+ * handles still pointing at it can be told apart from the handles of
+ * whatever reuses the slot later. A value of zero is the null handle.
+ *
+ * @tparam T type of the referenced object, so handles of different pools
+ *           can't be mixed up
+ */
+template <typename T>
+class Handle
+{
+public:
+  static constexpr U32 IndexMask      = (1u << HANDLE_INDEX_BITS) - 1;
+  static constexpr U32 GenerationMask = (1u << (32 - HANDLE_INDEX_BITS)) - 1;
+
+  /// Creates the null handle
+  Handle() : m_value(0) {};
+
+  /**
+   * @brief Creates a handle of a slot
+   * @param _index index of the slot
+   * @param _generation generation of the slot, never 0
+   */
+  Handle(U32 _index, U32 _generation)
+    : m_value((_generation << HANDLE_INDEX_BITS) | (_index & IndexMask))
+  {};
+
+  /// Returns the index of the slot
+  U32 GetIndex() const { return m_value & IndexMask; };
+
+  /// Returns the generation of the slot the handle was made for
+  U32 GetGeneration() const { return m_value >> HANDLE_INDEX_BITS; };
+
+  /// Returns the packed handle
+  U32 GetValue() const { return m_value; };
+
+  /// Returns true for the null handle
+  B8 IsNull() const { return m_value == 0; };
+
+  B8 operator==(const Handle& _other) const { return m_value == _other.m_value; };
+  B8 operator!=(const Handle& _other) const { return m_value != _other.m_value; };
+
+private:
+  /// Generation in the high bits, index in the low bits
+  U32 m_value;
+};
+
+/**
+ * @class HandlePool
+ * @brief Stores objects in one array and hands out handles rather than pointers
+ *
+ * Handles resolve to pointers in O(1) through a table of slots, and stale
+ * handles, of objects already destroyed, resolve to nullptr. Because nothing
+ * outside holds on to the objects' addresses, the pool is free to move them:
+ * Compact() fills the holes left by destroyed objects with the objects from
+ * the end of the array, so systems iterating over the pool walk one dense
+ * range.
+ *
+ * Pointers returned by Get() stay valid until the next Compact() or the next
+ * Create() that grows the pool, whichever is first. Hold on to the handles,
+ * not the pointers, across frames. Not thread-safe.
+ *
+ * @tparam T type of the pooled objects, has to be move-constructible
+ */
+template <typename T>
+class HandlePool
+{
+public:
+  /**
+   * @brief Creates the pool
+   * @param _capacity number of objects to reserve room for
+   */
+  explicit HandlePool(std::size_t _capacity = 1024)
+    : m_objects(nullptr), m_capacity(0), m_end(0), m_count(0)
+  {
+    Reserve(_capacity);
+  };
+
+  /// Destroys the objects still alive
+  ~HandlePool()
+  {
+    Clear();
+    ::operator delete(m_objects, std::align_val_t(alignof(T)));
+  };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(HandlePool);
+
+  /**
+   * @brief Constructs a new object in the pool
+   * @param _args arguments passed to T's constructor
+   * @return Handle of the object. Throws std::bad_alloc if all the slot
+   *         indices are used.
+   */
+  template <typename... Args>
+  Handle<T> Create(Args&&... _args)
+  {
+    // Reuse a hole left by a destroyed object, or append at the end
+    U32 position;
+    if(!m_freePositions.empty()){
+      position = m_freePositions.back();
+      m_freePositions.pop_back();
+    }
+    else{
+      if(m_end == m_capacity)
+        Reserve(m_capacity > 0 ? m_capacity * 2 : 16);
+      position = m_end++;
+    }
+
+    U32 index;
+    if(!m_freeSlots.empty()){
+      index = m_freeSlots.back();
+      m_freeSlots.pop_back();
+    }
+    else{
+      if(m_slots.size() > Handle<T>::IndexMask){
+        LERROR("Handle pool is out of the %u slot indices", Handle<T>::IndexMask + 1);
+        m_freePositions.push_back(position);
+        throw std::bad_alloc();
+      }
+      index = static_cast<U32>(m_slots.size());
+      m_slots.push_back({s_invalid, 1});
+    }
+
+    try{
+      new (&m_objects[position]) T(std::forward<Args>(_args)...);
+    }
+    catch(...){
+      m_freeSlots.push_back(index);
+      m_freePositions.push_back(position);
+      throw;
+    }
+
+    m_slots[index].m_position = position;
+    m_positionToSlot[position] = index;
+    m_count++;
+
+    return Handle<T>(index, m_slots[index].m_generation);
+  }
+
+  /**
+   * @brief Destroys an object, making every handle to it stale
+   * @param _handle handle of the object
+   * @return False if the handle was null or already stale
+   */
+  B8 Destroy(Handle<T> _handle)
+  {
+    if(!IsValid(_handle))
+      return false;
+
+    Slot& slot = m_slots[_handle.GetIndex()];
+    m_objects[slot.m_position].~T();
+    m_positionToSlot[slot.m_position] = s_invalid;
+    m_freePositions.push_back(slot.m_position);
+
+    // Generation 0 is kept for the null handle
+    slot.m_generation = (slot.m_generation + 1) & Handle<T>::GenerationMask;
+    if(slot.m_generation == 0)
+      slot.m_generation = 1;
+    slot.m_position = s_invalid;
+    m_freeSlots.push_back(_handle.GetIndex());
+    m_count--;
+
+    return true;
+  }
+
+  /// Returns true if the handle refers to a live object
+  B8 IsValid(Handle<T> _handle) const
+  {
+    U32 index = _handle.GetIndex();
+    return !_handle.IsNull() &&
+           index < m_slots.size() &&
+           m_slots[index].m_generation == _handle.GetGeneration() &&
+           m_slots[index].m_position != s_invalid;
+  }
+
+  /**
+   * @brief Resolves a handle
+   * @param _handle handle of the object
+   * @return The object, or nullptr if the handle is null or stale
+   */
+  T* Get(Handle<T> _handle)
+  {
+    return IsValid(_handle) ? &m_objects[m_slots[_handle.GetIndex()].m_position] : nullptr;
+  }
+
+  /// @copydoc Get
+  const T* Get(Handle<T> _handle) const
+  {
+    return IsValid(_handle) ? &m_objects[m_slots[_handle.GetIndex()].m_position] : nullptr;
+  }
+
+  /**
+   * @brief Moves the objects from the end of the array into the holes
+   *
+   * Afterwards the live objects take up positions [0, GetCount()) and
+   * iteration touches no dead memory. Meant to be called between frames.
+   *
+   * @return Number of objects moved
+   */
+  std::size_t Compact()
+  {
+    std::size_t moved = 0;
+    U32 low = 0;
+    U32 high = m_end;
+
+    while(true){
+      while(low < high && m_positionToSlot[low] != s_invalid)
+        ++low;
+      while(high > low && m_positionToSlot[high - 1] == s_invalid)
+        --high;
+      if(low >= high)
+        break;
+
+      // Move the last live object into the first hole
+      U32 from = high - 1;
+      U32 index = m_positionToSlot[from];
+      new (&m_objects[low]) T(std::move(m_objects[from]));
+      m_objects[from].~T();
+
+      m_positionToSlot[low] = index;
+      m_positionToSlot[from] = s_invalid;
+      m_slots[index].m_position = low;
+      ++moved;
+    }
+
+    m_end = static_cast<U32>(m_count);
+    m_freePositions.clear();
+    return moved;
+  }
+
+  /**
+   * @brief Calls a function on every live object, in array order
+   * @param _function callable taking T&
+   */
+  template <typename Function>
+  void ForEach(Function&& _function)
+  {
+    for(U32 position = 0; position < m_end; ++position){
+      if(m_positionToSlot[position] != s_invalid)
+        _function(m_objects[position]);
+    }
+  }
+
+  /// Destroys every object, making all the handles stale
+  void Clear()
+  {
+    for(U32 index = 0; index < m_slots.size(); ++index){
+      if(m_slots[index].m_position != s_invalid)
+        Destroy(Handle<T>(index, m_slots[index].m_generation));
+    }
+    m_end = 0;
+    m_freePositions.clear();
+  }
+
+  /// Returns the number of live objects
+  std::size_t GetCount() const { return m_count; };
+
+  /// Returns the length of the array the live objects are spread over,
+  /// equal to GetCount() right after Compact()
+  std::size_t GetRange() const { return m_end; };
+
+  /// Returns the number of objects the pool has room for without growing
+  std::size_t GetCapacity() const { return m_capacity; };
+
+  /// Returns the objects' array, dense up to GetCount() after Compact()
+  T* GetData() { return m_objects; };
+
+private:
+  /// Marks a slot without an object, or a position without a slot
+  static constexpr U32 s_invalid = ~0u;
+
+  /// Entry of the handle table
+  struct Slot
+  {
+    /// Position of the object in the array, s_invalid if free
+    U32 m_position;
+
+    /// Bumped every time the slot's object is destroyed
+    U32 m_generation;
+  };
+
+  /**
+   * @brief Moves the objects to a bigger array
+   * @param _capacity number of objects to make room for
+   */
+  void Reserve(std::size_t _capacity)
+  {
+    if(_capacity <= m_capacity)
+      return;
+
+    T* objects = static_cast<T*>(::operator new(_capacity * sizeof(T), std::align_val_t(alignof(T))));
+    for(U32 position = 0; position < m_end; ++position){
+      if(m_positionToSlot[position] == s_invalid)
+        continue;
+      new (&objects[position]) T(std::move(m_objects[position]));
+      m_objects[position].~T();
+    }
+
+    ::operator delete(m_objects, std::align_val_t(alignof(T)));
+    m_objects = objects;
+    m_capacity = _capacity;
+    m_positionToSlot.resize(_capacity, s_invalid);
+  }
+
+  /// The objects, with holes where objects were destroyed
+  T* m_objects;
+
+  /// Number of objects m_objects has room for
+  std::size_t m_capacity;
+
+  /// One past the last position ever used since the last Compact()
+  U32 m_end;
+
+  /// Number of live objects
+  std::size_t m_count;
+
+  /// Handle table, indexed by the handles' indices
+  std::vector<Slot> m_slots;
+
+  /// Slot of the object at each position, s_invalid for holes
+  std::vector<U32> m_positionToSlot;
+
+  /// Slots without an object
+  std::vector<U32> m_freeSlots;
+
+  /// Holes below m_end
+  std::vector<U32> m_freePositions;
+};
@@ -0,0 +1,80 @@
+/**
+ * @file LinearAllocator.hpp
+ * @brief Bump-pointer allocator over a fixed buffer
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see LinearAllocator
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class LinearAllocator
+ * @brief Hands out memory by bumping an offset, frees everything at once
+ *
+ * Allocating is an align and an add. Individual allocations can't be freed,
+ * the whole buffer is recycled with Reset(). Not thread-safe, and doesn't own
+ * the buffer it allocates from.
+ */
+class LinearAllocator
+{
+public:
+  LinearAllocator()
+    : m_buffer(nullptr), m_size(0), m_offset(0)
+  {};
+
+  /**
+   * @brief Creates the allocator over a buffer
+   * @param _buffer memory to allocate from
+   * @param _size size of the buffer in bytes
+   */
+  LinearAllocator(void* _buffer, std::size_t _size)
+    : m_buffer(static_cast<U8*>(_buffer)), m_size(_size), m_offset(0)
+  {};
+
+  /**
+   * @brief Allocates a block of memory
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   * @return The block, or nullptr if the buffer is full
+   */
+  void* Allocate(std::size_t _size, std::size_t _alignment = alignof(std::max_align_t))
+  {
+    std::uintptr_t current = reinterpret_cast<std::uintptr_t>(m_buffer) + m_offset;
+    std::uintptr_t aligned = (current + (_alignment - 1)) & ~(std::uintptr_t(_alignment) - 1);
+    std::size_t offset = m_offset + (aligned - current);
+
+    if(offset + _size > m_size)
+      return nullptr;
+
+    m_offset = offset + _size;
+    return m_buffer + offset;
+  }
+
+  /// Recycles the whole buffer
+  void Reset() { m_offset = 0; };
+
+  /// Returns the number of bytes in use, padding included
+  std::size_t GetUsed() const { return m_offset; };
+
+  /// Returns the size of the buffer
+  std::size_t GetSize() const { return m_size; };
+
+  /// Returns the start of the buffer
+  void* GetBuffer() const { return m_buffer; };
+
+private:
+  /// Buffer we allocate from
+  U8* m_buffer;
+
+  /// Size of the buffer in bytes
+  std::size_t m_size;
+
+  /// Offset of the first free byte
+  std::size_t m_offset;
+};
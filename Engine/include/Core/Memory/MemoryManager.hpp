@@ -1,48 +1,406 @@
+/**
+ * @file MemoryManager.hpp
+ * @brief Singleton handing out pooled memory for objects of any type
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see MemoryManager
+ */
 #pragma once
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <new>
-#include <typeindex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Core/Logging/LogManager.hpp"
-#include "Core/DataStructures/Queue.hpp"
 
+#include "Core/Memory/MemoryStats.hpp"
 #include "Core/Memory/PoolAllocator.hpp"
+#include "Core/Memory/SmallObjectAllocator.hpp"
+#include "Core/Memory/ThreadCache.hpp"
 
-
+/**
+ * @class MemoryManager
+ * @brief Hands out memory for objects of any type
+ *
+ * Objects that fit one of the SmallObjectAllocator's size classes share its
+ * pools with every other type of a similar size. Larger or over-aligned types,
+ * and types tuned through PoolTraits, get a PoolAllocator of their own. Either way every thread allocates through
+ * its own ThreadCache, so task workers creating and destroying components
+ * don't all fight over the same free list.
+ *
+ * Every allocated type also gets an index, assigned the first time the type
+ * is allocated, into its AllocationCounters and into every thread's
+ * ThreadAllocationCounters. Keeping the stats costs a few increments on the
+ * calling thread's own cache lines, with no lock, map lookup or line shared
+ * with another thread; the per-thread counts are only summed up by
+ * NextFrame() and the snapshots.
+ *
+ * The allocations are also summed up per MemoryTag, picked for each type by
+ * MemoryTagTraits, so that a subsystem going over its budget is reported at
+ * the end of the frame it happens in.
+ */
 class MemoryManager
 {
 // Private data members
 private:
-  std::unordered_map<std::type_index, std::size_t> m_allocationCounts;
+  /// Counters of every registered type, indexed by GetTypeIndex<T>(), and
+  /// of the types past the limit in the last one
+  AllocationCounters m_counters[MEMORY_MAX_TRACKED_TYPES + 1];
 
-// Public data members
-public:
+  /// Set once a type has had to go to the MEMORY_OTHER_TYPES slot
+  std::atomic<B8> m_otherTypesReported{false};
+
+  /// Number of registered types
+  std::atomic<U32> m_typeCount{0};
+
+  /// Counters of every tag
+  MemoryTagCounters m_tagCounters[MEMORY_TAG_MAX];
+
+  /// Counts of every thread that ever allocated, never shrinks so the
+  /// threads can keep pointers into it
+  std::deque<ThreadAllocationCounters> m_threadCounters;
+
+  /// Guards handing out and summing up m_threadCounters
+  mutable std::mutex m_threadCountersMutex;
+
+  /// Blocks to reserve for each type when it is first allocated, keyed by
+  /// the demangled type name
+  std::unordered_map<std::string, std::size_t> m_initialCapacities;
+
+  /// Guards m_initialCapacities
+  mutable std::mutex m_capacityMutex;
 
 // Public function members
 public:
   static MemoryManager& GetInstance();
 
   template <typename T>
-  T* Allocate();
+  T* Allocate()
+  {
+    ThreadAllocationCounters& counters = GetThreadCounters();
+    ThreadAllocationCounters::Add(counters.m_allocations[GetTypeIndex<T>()], 1);
+    TrackAllocation(counters, MemoryTagTraits<T>::Tag, sizeof(T));
+
+    if constexpr (UsesSizeClass<T>())
+      return static_cast<T*>(SmallObjectAllocator::Allocate<sizeof(T)>());
+    else if constexpr (PoolTraits<T>::ThreadCacheSize > 0)
+      return GetThreadCache<T>().Allocate();
+    else
+      return GetPoolAllocator<T>().Allocate();
+  };
 
   // TODO: Write some test to see if there are any objects in this pool
   template <typename T>
-  void Deallocate(T* ptr);
+  void Deallocate(T* ptr)
+  {
+    ThreadAllocationCounters& counters = GetThreadCounters();
+    ThreadAllocationCounters::Add(counters.m_frees[GetTypeIndex<T>()], 1);
+    TrackDeallocation(counters, MemoryTagTraits<T>::Tag, sizeof(T));
+
+    if constexpr (UsesSizeClass<T>())
+      SmallObjectAllocator::Deallocate<sizeof(T)>(ptr);
+    else if constexpr (PoolTraits<T>::ThreadCacheSize > 0)
+      GetThreadCache<T>().Deallocate(ptr);
+    else
+      GetPoolAllocator<T>().Deallocate(ptr);
+  };
+
+  /**
+   * @brief Allocates and constructs a T in pooled memory
+   *
+   * Forwards the arguments straight to T's constructor with placement-new,
+   * so no temporary is created and copied in.
+   *
+   * @param _args arguments passed to T's constructor
+   * @return The constructed object, to be freed with Destroy<T>()
+   */
+  template <typename T, typename... Args>
+  T* Create(Args&&... _args)
+  {
+    T* ptr = Allocate<T>();
+    try{
+      return new (ptr) T(std::forward<Args>(_args)...);
+    }
+    catch(...){
+      Deallocate<T>(ptr);
+      throw;
+    }
+  };
+
+  /**
+   * @brief Destroys and deallocates an object made with Create<T>()
+   *
+   * T has to be the type the object was created as, since that picks the
+   * pool it goes back to.
+   *
+   * @param _ptr object to destroy, may be nullptr
+   */
+  template <typename T>
+  void Destroy(T* _ptr)
+  {
+    if(_ptr == nullptr)
+      return;
+
+    _ptr->~T();
+    Deallocate<T>(_ptr);
+  };
 
+  /// Returns the number of types allocated so far
   size_t GetAllocatorTypes() const;
 
+  /// Prints the per-tag summary followed by the stats of every type
+  void Print();
+
+  /**
+   * @brief Returns the number of live objects of type T, summed over the
+   *        threads
+   *
+   * For a type registered past MEMORY_MAX_TRACKED_TYPES this is the count of
+   * all the types sharing the MEMORY_OTHER_TYPES slot.
+   */
   template <typename T>
-  size_t GetAllocationCount();
+  size_t GetAllocationCount()
+  {
+    return GetLiveCount(GetTypeIndex<T>());
+  }
+
+  /**
+   * @brief Accounts memory allocated outside of the MemoryManager to a tag
+   *
+   * Lets subsystems with allocators of their own, e.g. the renderer's frame
+   * data, count against their budget.
+   *
+   * @param _tag tag to account the memory to
+   * @param _bytes size of the allocation
+   */
+  void TrackAllocation(MemoryTag _tag, std::size_t _bytes)
+  {
+    TrackAllocation(GetThreadCounters(), _tag, _bytes);
+  }
+
+  /**
+   * @brief Takes memory passed to TrackAllocation() off its tag
+   * @param _tag tag the memory was accounted to
+   * @param _bytes size of the allocation
+   */
+  void TrackDeallocation(MemoryTag _tag, std::size_t _bytes)
+  {
+    TrackDeallocation(GetThreadCounters(), _tag, _bytes);
+  }
+
+  /**
+   * @brief Sets the number of objects of a type to make room for up front
+   *
+   * Applied when the type is first allocated, so it has to be set before
+   * that, e.g. from the "memory" section of the config. Types served by the
+   * size classes reserve the blocks in their size class's shared pool.
+   *
+   * @param _typeName demangled name of the type, e.g. "Entity"
+   * @param _capacity number of objects
+   */
+  void SetInitialCapacity(const std::string& _typeName, std::size_t _capacity);
+
+  /**
+   * @brief Sets the number of bytes a tag is expected to stay under
+   * @param _tag the tag
+   * @param _budget budget in bytes, 0 for none
+   */
+  void SetBudget(MemoryTag _tag, U64 _budget);
+
+  /// Returns the budget of a tag in bytes, 0 for none
+  U64 GetBudget(MemoryTag _tag) const;
+
+  /**
+   * @brief Closes the allocation counts of the current frame
+   *
+   * Called by Application::Run once per frame, so that the snapshots can
+   * report how much each type and tag allocates and frees per frame. Also
+   * samples the peaks, warns about tags that went over their budget and
+   * re-arms the warning of tags that are back under it.
+   */
+  void NextFrame();
+
+  /**
+   * @brief Returns the per-tag summary as of the last NextFrame()
+   *
+   * Bytes are current, peaks as of the end of a frame, and the allocation and
+   * free counts are those of the last complete frame.
+   */
+  std::vector<MemoryTagStats> GetMemoryTagStats() const;
+
+  /**
+   * @brief Returns a snapshot of the counters of every type allocated so far
+   *
+   * Each thread's counters are read on their own while it may be allocating,
+   * so the snapshot is approximate but never blocks them.
+   */
+  std::vector<AllocationStats> GetAllocationStats() const;
+
+  /**
+   * @brief Makes room for _count more objects of T in the pool it lives in
+   * @param _count number of objects
+   */
+  template <typename T>
+  void Reserve(std::size_t _count)
+  {
+    if(_count == 0)
+      return;
+
+    if constexpr (UsesSizeClass<T>())
+      SmallObjectAllocator::GetPool<sizeof(T)>().Reserve(_count);
+    else
+      GetPoolAllocator<T>().Reserve(_count);
+  }
+
+  /**
+   * @brief Gives the empty chunks of the pool T lives in back to the OS
+   * @return Number of chunks released
+   */
+  template <typename T>
+  size_t Trim()
+  {
+    if constexpr (UsesSizeClass<T>())
+      return SmallObjectAllocator::GetPool<sizeof(T)>().Trim();
+    else
+      return GetPoolAllocator<T>().Trim();
+  }
+
+  /**
+   * @brief Returns the calling thread's cached blocks of T to the shared pool
+   */
+  template <typename T>
+  void FlushThreadCache()
+  {
+    if constexpr (UsesSizeClass<T>())
+      SmallObjectAllocator::GetThreadCache<sizeof(T)>().Flush();
+    else if constexpr (PoolTraits<T>::ThreadCacheSize > 0)
+      GetThreadCache<T>().Flush();
+  }
+
+  /**
+   * @brief Returns the cache hit and miss counts of every thread so far
+   */
+  std::vector<ThreadCacheStats> GetThreadCacheStats() const;
+
+  /// Returns true if T is served by the shared size-class pools, which
+  /// can't honour a PoolTraits specialisation
+  template <typename T>
+  static constexpr B8 UsesSizeClass()
+  {
+    return HasDefaultPoolTraits<T>() && SmallObjectAllocator::Fits(sizeof(T), alignof(T));
+  }
 
 // Private functions members
 private:
-  MemoryManager(){};
+  MemoryManager();
   ~MemoryManager(){};
 
+  /**
+   * @brief Returns the index of T's counters, registering T on first use
+   *
+   * The index lives in a static of the function's instantiation for T, so
+   * after the first call it costs a single guard check. Registering also
+   * reserves T's configured initial capacity.
+   */
+  template <typename T>
+  U32 GetTypeIndex()
+  {
+    static const U32 index = [this](){
+      U32 typeIndex = RegisterType(typeid(T).name(), sizeof(T), MemoryTagTraits<T>::Tag);
+      Reserve<T>(GetInitialCapacity(typeid(T).name()));
+      return typeIndex;
+    }();
+    return index;
+  }
+
+  /**
+   * @brief Returns the configured initial capacity of a type, 0 if none
+   * @param _typeName mangled name of the type
+   */
+  std::size_t GetInitialCapacity(const char* _typeName) const;
+
+  /**
+   * @brief Assigns the next free slot of counters to a type
+   *
+   * Past MEMORY_MAX_TRACKED_TYPES it warns once and returns
+   * MEMORY_OTHER_TYPES.
+   *
+   * @param _typeName mangled name of the type
+   * @param _typeSize size of the type in bytes
+   */
+  U32 RegisterType(const char* _typeName, std::size_t _typeSize, MemoryTag _tag);
+
+  /**
+   * @brief Warns that a tag has gone over its budget
+   * @param _tag the tag
+   * @param _bytes bytes currently allocated under it
+   */
+  void ReportOverBudget(MemoryTag _tag, I64 _bytes);
+
+  /// Returns the calling thread's counters, handing it a block on first use
+  ThreadAllocationCounters& GetThreadCounters()
+  {
+    static thread_local ThreadAllocationCounters* counters = nullptr;
+    if(counters == nullptr)
+      counters = &AcquireThreadCounters();
+    return *counters;
+  }
+
+  /// Hands the calling thread a block of counters, reusing one left by an
+  /// exited thread if there is any, and gives it back when the thread exits
+  ThreadAllocationCounters& AcquireThreadCounters();
+
+  /// Counts an allocation of a tag on the calling thread
+  static void TrackAllocation(ThreadAllocationCounters& _counters, MemoryTag _tag, std::size_t _bytes)
+  {
+    ThreadAllocationCounters::Add(_counters.m_tagAllocations[_tag], 1);
+    ThreadAllocationCounters::Add(_counters.m_tagBytesAllocated[_tag], _bytes);
+  }
+
+  /// Counts a free of a tag on the calling thread
+  static void TrackDeallocation(ThreadAllocationCounters& _counters, MemoryTag _tag, std::size_t _bytes)
+  {
+    ThreadAllocationCounters::Add(_counters.m_tagFrees[_tag], 1);
+    ThreadAllocationCounters::Add(_counters.m_tagBytesFreed[_tag], _bytes);
+  }
+
+  /// Totals of one type or tag, summed over every thread's counters
+  struct CountTotals
+  {
+    U64 m_allocations = 0;
+    U64 m_frees = 0;
+    U64 m_bytesAllocated = 0;
+    U64 m_bytesFreed = 0;
+  };
+
+  /// Sums the counts of the type at _index over every thread
+  CountTotals SumTypeCounts(U32 _index) const;
+
+  /// Sums the counts of a tag over every thread
+  CountTotals SumTagCounts(MemoryTag _tag) const;
+
+  /// Returns the number of live objects of the type at _index
+  std::size_t GetLiveCount(U32 _index) const;
+
   template<typename T>
-  PoolAllocator<T>& GetPoolAllocator();
+  PoolAllocator<T>& GetPoolAllocator()
+  {
+    static PoolAllocator<T> poolAllocator;
+    return poolAllocator;
+  }
 
+  template<typename T>
+  ThreadCache<T, PoolTraits<T>::ThreadCacheSize>& GetThreadCache()
+  {
+    static thread_local ThreadCache<T, PoolTraits<T>::ThreadCacheSize> threadCache(GetPoolAllocator<T>());
+    return threadCache;
+  }
 };
 
 #define MEMALLOC() \
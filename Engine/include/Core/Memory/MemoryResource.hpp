@@ -0,0 +1,186 @@
+/**
+ * @file MemoryResource.hpp
+ * @brief std::pmr::memory_resource adapters over the engine's allocators
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see SmallObjectMemoryResource
+ * @see PoolMemoryResource
+ * @see FrameMemoryResource
+ * @see BufferedFrameMemoryResource
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/PoolAllocator.hpp"
+#include "Core/Memory/SmallObjectAllocator.hpp"
+#include "Core/Memory/FrameAllocator.hpp"
+#include "Core/Memory/BufferedFrameAllocator.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @class SmallObjectMemoryResource
+ * @brief Serves std::pmr containers from the SmallObjectAllocator's pools
+ *
+ * Node-based containers (maps, lists) allocate one small node per element,
+ * which is exactly what the size classes are for. Anything larger, like a
+ * hash map's bucket array, goes to the global heap.
+ *
+ * Goes to the shared pools directly rather than through the per-thread
+ * caches, so containers owned by singletons can still free their nodes while
+ * the program exits, after the thread caches are gone. The pools are created
+ * with the resource, so they outlive anything constructed with it.
+ */
+class SmallObjectMemoryResource : public std::pmr::memory_resource
+{
+public:
+  /// Singleton instance getter
+  static SmallObjectMemoryResource& GetInstance();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(SmallObjectMemoryResource);
+
+private:
+  SmallObjectMemoryResource();
+
+  void* do_allocate(std::size_t _size, std::size_t _alignment) override;
+
+  void do_deallocate(void* _block, std::size_t _size, std::size_t _alignment) override;
+
+  bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override
+  {
+    return this == &_other;
+  }
+};
+
+/**
+ * @class PoolMemoryResource
+ * @brief Serves std::pmr containers from the pool of one type
+ *
+ * Requests that fit one block of the pool, e.g. the nodes of a std::pmr::list
+ * of T, are served by the pool. Anything else goes to the upstream resource.
+ *
+ * @tparam T type of the pool's objects
+ */
+template <typename T>
+class PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+  /**
+   * @brief Creates the resource over a pool
+   * @param _pool pool serving the requests that fit its blocks
+   * @param _upstream resource serving the rest
+   */
+  explicit PoolMemoryResource(PoolAllocator<T>& _pool,
+                              std::pmr::memory_resource* _upstream = std::pmr::new_delete_resource())
+    : m_pool(_pool), m_upstream(_upstream)
+  {};
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(PoolMemoryResource);
+
+private:
+  /// Returns true if a request fits one block of the pool
+  static constexpr B8 Fits(std::size_t _size, std::size_t _alignment)
+  {
+    return _size <= PoolAllocator<T>::BlockSize && _alignment <= PoolAllocator<T>::BlockAlignment;
+  }
+
+  void* do_allocate(std::size_t _size, std::size_t _alignment) override
+  {
+    if(Fits(_size, _alignment))
+      return m_pool.Allocate();
+    return m_upstream->allocate(_size, _alignment);
+  }
+
+  void do_deallocate(void* _block, std::size_t _size, std::size_t _alignment) override
+  {
+    if(Fits(_size, _alignment))
+      m_pool.Deallocate(static_cast<T*>(_block));
+    else
+      m_upstream->deallocate(_block, _size, _alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override
+  {
+    return this == &_other;
+  }
+
+  /// Pool serving the requests that fit its blocks
+  PoolAllocator<T>& m_pool;
+
+  /// Resource serving the rest
+  std::pmr::memory_resource* m_upstream;
+};
+
+/**
+ * @class FrameMemoryResource
+ * @brief Serves std::pmr containers from the calling thread's frame arena
+ *
+ * Deallocation does nothing, the memory comes back when the frame ends. Only
+ * for containers created and dropped by one thread within a single frame.
+ */
+class FrameMemoryResource : public std::pmr::memory_resource
+{
+public:
+  /// Singleton instance getter
+  static FrameMemoryResource& GetInstance();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(FrameMemoryResource);
+
+private:
+  FrameMemoryResource() {};
+
+  void* do_allocate(std::size_t _size, std::size_t _alignment) override
+  {
+    return FRAMEALLOC().Allocate(_size, _alignment);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {};
+
+  bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override
+  {
+    return this == &_other;
+  }
+};
+
+/**
+ * @class BufferedFrameMemoryResource
+ * @brief Serves std::pmr containers from a BufferedFrameAllocator
+ *
+ * Deallocation does nothing, the memory comes back when its slot is
+ * recycled. For containers that have to survive into the next frame(s).
+ */
+class BufferedFrameMemoryResource : public std::pmr::memory_resource
+{
+public:
+  /**
+   * @brief Creates the resource over an arena
+   * @param _allocator the arena, BUFFEREDFRAMEALLOC() by default
+   */
+  explicit BufferedFrameMemoryResource(BufferedFrameAllocator& _allocator = BUFFEREDFRAMEALLOC())
+    : m_allocator(_allocator)
+  {};
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(BufferedFrameMemoryResource);
+
+private:
+  void* do_allocate(std::size_t _size, std::size_t _alignment) override
+  {
+    return m_allocator.Allocate(_size, _alignment);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {};
+
+  bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override
+  {
+    return this == &_other;
+  }
+
+  /// The arena
+  BufferedFrameAllocator& m_allocator;
+};
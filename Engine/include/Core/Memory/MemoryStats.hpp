@@ -0,0 +1,232 @@
+/**
+ * @file MemoryStats.hpp
+ * @brief Per-thread allocation counters for the MemoryManager
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see MemoryTag
+ * @see AllocationCounters
+ * @see AllocationStats
+ * @see MemoryTagCounters
+ * @see ThreadAllocationCounters
+ * @see MemoryTagStats
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/// Number of distinct types the MemoryManager keeps statistics for. Types
+/// registered past this are counted together in the MEMORY_OTHER_TYPES slot.
+#define MEMORY_MAX_TRACKED_TYPES 512
+
+/// Index of the slot shared by the types past MEMORY_MAX_TRACKED_TYPES,
+/// reported as "(other types)"
+#define MEMORY_OTHER_TYPES MEMORY_MAX_TRACKED_TYPES
+
+/// Name the MEMORY_OTHER_TYPES slot is reported under
+#define MEMORY_OTHER_TYPES_NAME "(other types)"
+
+/**
+ * @enum MemoryTag
+ * @brief Subsystem an allocation is accounted to
+ */
+enum MemoryTag : U8
+{
+  MEMORY_TAG_GENERAL,
+  MEMORY_TAG_RENDERER,
+  MEMORY_TAG_ECS,
+  MEMORY_TAG_EVENTS,
+  MEMORY_TAG_LOGGING,
+  MEMORY_TAG_ASSETS,
+  MEMORY_TAG_MAX
+};
+
+/**
+ * @brief Returns the name of a tag, as used for its budget in the config
+ * @param _tag the tag
+ */
+inline const char* GetMemoryTagName(MemoryTag _tag)
+{
+  static const char* names[MEMORY_TAG_MAX] = {
+    "general", "renderer", "ecs", "events", "logging", "assets"
+  };
+  return _tag < MEMORY_TAG_MAX ? names[_tag] : "unknown";
+}
+
+/**
+ * @struct MemoryTagTraits
+ * @brief Picks the tag the MemoryManager accounts a type's allocations to
+ *
+ * A type is tagged either by declaring a `static constexpr MemoryTag
+ * s_memoryTag` member, which its derived classes inherit, or by specialising
+ * this struct:
+ * @code
+ *   template <>
+ *   struct MemoryTagTraits<Mesh>
+ *   {
+ *     static constexpr MemoryTag Tag = MEMORY_TAG_ASSETS;
+ *   };
+ * @endcode
+ */
+template <typename T>
+struct MemoryTagTraits
+{
+  static constexpr MemoryTag Tag = MEMORY_TAG_GENERAL;
+};
+
+template <typename T>
+  requires requires { T::s_memoryTag; }
+struct MemoryTagTraits<T>
+{
+  static constexpr MemoryTag Tag = T::s_memoryTag;
+};
+
+/**
+ * @struct AllocationCounters
+ * @brief Description and per-frame snapshot of one allocated type
+ *
+ * The counts themselves live in every thread's ThreadAllocationCounters,
+ * these are only written when registering the type and by NextFrame().
+ */
+struct alignas(64) AllocationCounters
+{
+  /// Mangled type name, from typeid
+  const char* m_typeName = nullptr;
+
+  /// Size of the type in bytes
+  std::size_t m_typeSize = 0;
+
+  /// Tag the type is accounted to
+  MemoryTag m_tag = MEMORY_TAG_GENERAL;
+
+  /// Most objects allocated at once, as seen at the end of each frame
+  std::atomic<I64> m_peak{0};
+
+  /// Allocations since the start, when the current frame started
+  std::atomic<U64> m_totalAtFrameStart{0};
+
+  /// Allocations made during the last complete frame
+  std::atomic<U64> m_lastFrame{0};
+
+  /// Set once the type name and size are written
+  std::atomic<B8> m_registered{false};
+};
+
+/**
+ * @struct MemoryTagCounters
+ * @brief Budget and per-frame snapshot of one tag
+ */
+struct alignas(64) MemoryTagCounters
+{
+  /// Most bytes allocated at once, as seen at the end of each frame
+  std::atomic<I64> m_peakBytes{0};
+
+  /// Budget in bytes, 0 for none
+  std::atomic<U64> m_budget{0};
+
+  /// Allocations and frees since the start, when the current frame started
+  U64 m_allocationsAtFrameStart = 0;
+  U64 m_freesAtFrameStart = 0;
+
+  /// Allocations and frees made during the last complete frame
+  std::atomic<U64> m_lastFrameAllocations{0};
+  std::atomic<U64> m_lastFrameFrees{0};
+
+  /// Set once the budget is exceeded, so it is only reported once
+  std::atomic<B8> m_overBudget{false};
+};
+
+/**
+ * @struct ThreadAllocationCounters
+ * @brief One thread's share of the allocation counts of every type and tag
+ *
+ * Each thread counts into a block of its own, so allocating never writes a
+ * cache line another thread is writing too; the MemoryManager sums the
+ * blocks whenever it takes a snapshot. The counts only ever grow, so a block
+ * left by an exited thread is handed to the next new one and the sums stay
+ * right. A thread's own allocations are the only ones touching its block,
+ * the increments are atomic just so a straggling write from a thread that
+ * is exiting doesn't get lost.
+ */
+struct alignas(64) ThreadAllocationCounters
+{
+  /// Allocations and frees of every type, indexed like the type's counters
+  std::atomic<U64> m_allocations[MEMORY_MAX_TRACKED_TYPES + 1]{};
+  std::atomic<U64> m_frees[MEMORY_MAX_TRACKED_TYPES + 1]{};
+
+  /// Allocations, frees and their bytes of every tag
+  std::atomic<U64> m_tagAllocations[MEMORY_TAG_MAX]{};
+  std::atomic<U64> m_tagFrees[MEMORY_TAG_MAX]{};
+  std::atomic<U64> m_tagBytesAllocated[MEMORY_TAG_MAX]{};
+  std::atomic<U64> m_tagBytesFreed[MEMORY_TAG_MAX]{};
+
+  /// Set while a thread owns the block, guarded by the MemoryManager
+  B8 m_inUse = false;
+
+  /// Adds to a counter, never contended unless its thread is exiting
+  static void Add(std::atomic<U64>& _counter, U64 _value)
+  {
+    _counter.fetch_add(_value, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @struct MemoryTagStats
+ * @brief Snapshot of one tag's counters, taken at the end of a frame
+ */
+struct MemoryTagStats
+{
+  /// The tag
+  MemoryTag m_tag;
+
+  /// Bytes currently allocated
+  U64 m_bytes;
+
+  /// Most bytes allocated at once
+  U64 m_peakBytes;
+
+  /// Budget in bytes, 0 for none
+  U64 m_budget;
+
+  /// Allocations made during the last complete frame
+  U64 m_allocationsPerFrame;
+
+  /// Frees made during the last complete frame
+  U64 m_freesPerFrame;
+};
+
+/**
+ * @struct AllocationStats
+ * @brief Snapshot of one type's allocation counters
+ */
+struct AllocationStats
+{
+  /// Demangled type name, MEMORY_OTHER_TYPES_NAME for the types past the
+  /// limit
+  std::string m_typeName;
+
+  /// Size of the type in bytes, 0 for the other types
+  std::size_t m_typeSize;
+
+  /// Tag the type is accounted to
+  MemoryTag m_tag;
+
+  /// Objects currently allocated
+  U64 m_liveCount;
+
+  /// Most objects allocated at once
+  U64 m_peakCount;
+
+  /// Bytes currently allocated
+  U64 m_bytes;
+
+  /// Allocations made during the last complete frame
+  U64 m_allocationsPerFrame;
+
+  /// Allocations since the start
+  U64 m_totalAllocations;
+};
@@ -0,0 +1,61 @@
+/**
+ * @file PageAllocator.hpp
+ * @brief Large, aligned allocations straight from the OS
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see PageAllocator
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+
+/// Size of a transparent huge page on x86-64 Linux
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/// Size of a cache line, what objects are padded to to avoid false sharing
+#define CACHE_LINE_SIZE 64
+
+/**
+ * @class PageAllocator
+ * @brief Allocates the big blocks other allocators carve up
+ *
+ * Plain blocks come from the aligned global operator new. Huge-page blocks
+ * are mapped with mmap on Linux, aligned to and rounded up to whole huge
+ * pages, and marked with MADV_HUGEPAGE so that the kernel backs them with
+ * 2 MiB pages. Iterating over tens of thousands of objects then touches a
+ * handful of TLB entries rather than one per 4 KiB. Elsewhere huge-page
+ * requests fall back to plain blocks.
+ */
+class PageAllocator
+{
+public:
+  /**
+   * @brief Allocates a block
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   * @param _hugePages back the block with huge pages if the OS allows it
+   * @return The block, or nullptr if out of memory
+   */
+  static void* Allocate(std::size_t _size, std::size_t _alignment, B8 _hugePages = false);
+
+  /**
+   * @brief Frees a block returned by Allocate()
+   * @param _block the block
+   * @param _size size the block was allocated with
+   * @param _alignment alignment the block was allocated with
+   * @param _hugePages whether the block was allocated with huge pages
+   */
+  static void Free(void* _block, std::size_t _size, std::size_t _alignment, B8 _hugePages = false);
+
+  /**
+   * @brief Returns the size a huge-page block of _size bytes really takes
+   * @param _size requested size in bytes
+   */
+  static constexpr std::size_t RoundToHugePages(std::size_t _size)
+  {
+    return (_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+};
@@ -1,50 +1,435 @@
+/**
+ * @file PoolAllocator.hpp
+ * @brief Growable, chunked pool allocator for objects of a single type
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see PoolAllocator
+ * @see PoolTraits
+ * @see DefaultPoolTraits
+ */
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <new>
-#include <typeindex>
+#include <vector>
 
 #include "Core/Logging/LogManager.hpp"
-#include "Core/DataStructures/Queue.hpp"
+#include "Core/Memory/FreeList.hpp"
+#include "Core/Memory/PageAllocator.hpp"
 
+/**
+ * @struct DefaultPoolTraits
+ * @brief Default tuning of the PoolAllocator, see PoolTraits
+ */
+template <typename T>
+struct DefaultPoolTraits
+{
+  /// Number of objects in every chunk the pool grows by
+  static constexpr std::size_t ChunkSize = 1024;
+
+  /// Number of free blocks each thread keeps for itself, 0 disables caching
+  static constexpr std::size_t ThreadCacheSize = 64;
+
+  /// Alignment of every block, raised to alignof(T) if lower
+  static constexpr std::size_t Alignment = alignof(T);
+
+  /// Gives every block a cache line of its own, so objects updated by
+  /// different threads never share one
+  static constexpr B8 PadToCacheLine = false;
+
+  /// Backs the chunks with huge pages, for pools iterated over as a whole.
+  /// Chunks are then grown to fill whole 2 MiB pages.
+  static constexpr B8 UseHugePages = false;
+};
+
+/**
+ * @struct PoolTraits
+ * @brief Per-type tuning of the PoolAllocator
+ *
+ * Specialise this for a type to change how its pool grows and lays out its
+ * memory. Deriving from DefaultPoolTraits keeps the settings that aren't
+ * overridden, e.g. for a component iterated over by tens of thousands:
+ * @code
+ *   template <>
+ *   struct PoolTraits<TransformComponent> : DefaultPoolTraits<TransformComponent>
+ *   {
+ *     static constexpr std::size_t ChunkSize = 16384;
+ *     static constexpr B8 UseHugePages = true;
+ *   };
+ * @endcode
+ */
+template <typename T>
+struct PoolTraits : DefaultPoolTraits<T>
+{
+};
+
+/// Returns true if PoolTraits<T> changes nothing from DefaultPoolTraits<T>
+template <typename T>
+constexpr B8 HasDefaultPoolTraits()
+{
+  using Traits = PoolTraits<T>;
+  using Defaults = DefaultPoolTraits<T>;
+  return Traits::ChunkSize == Defaults::ChunkSize &&
+         Traits::ThreadCacheSize == Defaults::ThreadCacheSize &&
+         Traits::Alignment == Defaults::Alignment &&
+         Traits::PadToCacheLine == Defaults::PadToCacheLine &&
+         Traits::UseHugePages == Defaults::UseHugePages;
+}
+
+/**
+ * @class PoolAllocator
+ * @brief Pool of fixed-size blocks that grows one chunk at a time
+ *
+ * Memory is requested from the OS in chunks of ChunkSize objects. When all
+ * the blocks are in use a new chunk is added, so live objects are never moved
+ * and pointers handed out stay valid until they are deallocated. Chunks that
+ * hold no live objects can be given back to the OS with Trim().
+ *
+ * New chunks are not threaded onto the free list up front. Blocks are carved
+ * off a chunk with a bump pointer, a batch at a time, the first time they are
+ * needed. A pool that is never used past its first few objects never touches
+ * the rest of its memory.
+ *
+ * Free blocks are kept in a lock-free intrusive FreeList, so Allocate() and
+ * Deallocate() are a single compare-and-swap on the common path. Only growing
+ * the pool takes a lock.
+ *
+ * Blocks are aligned and padded as set in PoolTraits, and chunks come from
+ * the PageAllocator, so over-aligned types are always aligned correctly.
+ */
 template <typename T>
 class PoolAllocator
 {
-// Private data members
+public:
+  /// Alignment of every block
+  static constexpr std::size_t BlockAlignment =
+    std::max({PoolTraits<T>::Alignment,
+              alignof(T),
+              alignof(FreeList::Node),
+              PoolTraits<T>::PadToCacheLine ? std::size_t(CACHE_LINE_SIZE) : std::size_t(1)});
+
+  static_assert((BlockAlignment & (BlockAlignment - 1)) == 0, "Pool alignment must be a power of two");
+
 private:
- // The size of the memory pool
- std::size_t m_poolSize;
+  /// A block is either a free-list link or storage for one T. Its size is
+  /// rounded up to a multiple of its alignment.
+  union alignas(BlockAlignment) Slot
+  {
+    FreeList::Node m_node;
+    unsigned char m_object[sizeof(T)];
+  };
 
- // The memory pool
- T* m_memoryPool;
+  /// Chunks are mapped from huge pages
+  static constexpr B8 s_hugePages = PoolTraits<T>::UseHugePages;
 
- // The list of free blocks
- psl::Queue<T*> m_freeList;
+public:
+  /// Distance in bytes between two neighbouring blocks
+  static constexpr std::size_t BlockSize = sizeof(Slot);
 
- // Mutex for thread-safety
- mutable std::mutex m_mutex;
+  /// Number of blocks carved off a fresh chunk at a time
+  static constexpr std::size_t CarveBatch = 32;
 
- // Pujblic data functions
 public:
-  // Constructor that initializes the memory pool with the given size
-  explicit PoolAllocator(std::size_t poolSize_ = 1024);
-
-  // Destructor that frees the memory pool
-  ~PoolAllocator();
-  
-  // Allocates a block of memory from the pool
-  T* Allocate();
-  
-  // Deallocates a block of memory back to the pool
-  void Deallocate(T* block_);
-  
-  // Returns the number of blocks currently allocated
-  std::size_t GetAllocationCount() const;
-
-  std::size_t GetAllocationSize() const;
-
-  std::size_t GetFreeAllocationCount() const;
-
-  std::size_t GetFreeAllocationSize() const;
-};
+  /**
+   * @brief Creates the pool and allocates its first chunk
+   * @param _chunkSize number of objects in each chunk the pool grows by
+   */
+  explicit PoolAllocator(std::size_t _chunkSize = PoolTraits<T>::ChunkSize)
+    : m_chunkSize(std::max<std::size_t>(_chunkSize, 1)), m_capacity(0), m_allocated(0),
+      m_carveNext(nullptr), m_carveEnd(nullptr)
+  {
+    // Use all of the huge pages a chunk takes anyway
+    if constexpr (s_hugePages)
+      m_chunkSize = PageAllocator::RoundToHugePages(m_chunkSize * sizeof(Slot)) / sizeof(Slot);
+
+    std::lock_guard<std::mutex> lock(m_growMutex);
+    m_carveNext = AddChunk();
+    m_carveEnd  = m_carveNext + m_chunkSize;
+  }
+
+  /// Frees all the chunks, live objects included
+  ~PoolAllocator()
+  {
+    for(Slot* chunk : m_chunks)
+      FreeChunk(chunk);
+  };
+
+  NOCOPY(PoolAllocator);
+
+  /**
+   * @brief Allocates a block of memory from the pool
+   *
+   * Grows the pool by another chunk if there are no free blocks left.
+   *
+   * @return Pointer to uninitialised memory for one T
+   */
+  T* Allocate()
+  {
+    FreeList::Node* node = m_freeList.Pop();
+    if(node == nullptr)
+      node = Grow();
+
+    m_allocated.fetch_add(1, std::memory_order_relaxed);
+    return reinterpret_cast<T*>(node);
+  }
+
+  /**
+   * @brief Deallocates a block of memory back to the pool
+   * @param _block block previously returned by Allocate()
+   */
+  void Deallocate(T* _block)
+  {
+    m_allocated.fetch_sub(1, std::memory_order_relaxed);
+    m_freeList.Push(reinterpret_cast<FreeList::Node*>(_block));
+  }
+
+  /**
+   * @brief Allocates several blocks at once
+   *
+   * Used to refill the per-thread caches. Grows the pool as needed, so all
+   * _count blocks are always filled in.
+   *
+   * @param _blocks array receiving the blocks
+   * @param _count number of blocks to allocate
+   */
+  void AllocateBatch(T** _blocks, std::size_t _count)
+  {
+    for(std::size_t i = 0; i < _count; ++i){
+      FreeList::Node* node = m_freeList.Pop();
+      if(node == nullptr)
+        node = Grow();
+      _blocks[i] = reinterpret_cast<T*>(node);
+    }
+    m_allocated.fetch_add(_count, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Deallocates several blocks with a single push to the free list
+   * @param _blocks array of blocks previously returned by the pool
+   * @param _count number of blocks to deallocate
+   */
+  void DeallocateBatch(T** _blocks, std::size_t _count)
+  {
+    if(_count == 0)
+      return;
+
+    for(std::size_t i = 0; i + 1 < _count; ++i)
+      FreeList::StoreNext(reinterpret_cast<FreeList::Node*>(_blocks[i]),
+                          reinterpret_cast<FreeList::Node*>(_blocks[i + 1]));
+
+    m_allocated.fetch_sub(_count, std::memory_order_relaxed);
+    m_freeList.Push(reinterpret_cast<FreeList::Node*>(_blocks[0]),
+                    reinterpret_cast<FreeList::Node*>(_blocks[_count - 1]));
+  }
+
+  /**
+   * @brief Makes sure _count more blocks can be allocated without growing
+   *
+   * Adds whole chunks, which are only carved up once they are needed.
+   *
+   * @param _count number of blocks to make room for
+   */
+  void Reserve(std::size_t _count)
+  {
+    std::lock_guard<std::mutex> lock(m_growMutex);
+    while(GetFreeAllocationCount() < _count)
+      m_spareChunks.push_back(AddChunk());
+  }
+
+  /**
+   * @brief Gives the chunks without any live objects back to the OS
+   *
+   * Walks the whole free list, so it is meant to be called between frames or
+   * after a level unload, not on a hot path. No other thread may allocate or
+   * deallocate from this pool while it runs. The first chunk is always kept,
+   * and blocks parked in the per-thread caches count as live.
+   *
+   * @return Number of chunks released
+   */
+  std::size_t Trim()
+  {
+    std::lock_guard<std::mutex> lock(m_growMutex);
+    if(m_chunks.size() <= 1)
+      return 0;
 
+    // Drain the free list and sort it, so each chunk's free blocks are
+    // contiguous and can be counted in one pass
+    std::vector<Slot*> freeBlocks;
+    freeBlocks.reserve(m_capacity.load() - m_allocated.load());
+    for(FreeList::Node* node = m_freeList.PopAll(); node != nullptr; node = FreeList::LoadNext(node))
+      freeBlocks.push_back(reinterpret_cast<Slot*>(node));
+    std::sort(freeBlocks.begin(), freeBlocks.end(), std::less<Slot*>());
+
+    std::vector<Slot*> keptChunks;
+    std::size_t released = 0;
+    for(std::size_t idx = 0; idx < m_chunks.size(); ++idx){
+      Slot* chunk = m_chunks[idx];
+      auto first = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), chunk, std::less<Slot*>());
+      auto last  = std::lower_bound(first, freeBlocks.end(), chunk + m_chunkSize, std::less<Slot*>());
+
+      // Blocks never carved off the chunk are free too
+      std::size_t freeCount = last - first;
+      const B8 carving = m_carveNext != m_carveEnd && m_carveNext >= chunk && m_carveNext < chunk + m_chunkSize;
+      if(carving)
+        freeCount += m_carveEnd - m_carveNext;
+      auto spare = std::find(m_spareChunks.begin(), m_spareChunks.end(), chunk);
+      if(spare != m_spareChunks.end())
+        freeCount = m_chunkSize;
+
+      const B8 empty = freeCount == m_chunkSize;
+      if(idx > 0 && empty){
+        // Forget this chunk's blocks and hand the memory back
+        freeBlocks.erase(first, last);
+        if(carving)
+          m_carveNext = m_carveEnd = nullptr;
+        if(spare != m_spareChunks.end())
+          m_spareChunks.erase(spare);
+        FreeChunk(chunk);
+        m_capacity.fetch_sub(m_chunkSize, std::memory_order_relaxed);
+        ++released;
+      }
+      else{
+        keptChunks.push_back(chunk);
+      }
+    }
+    m_chunks.swap(keptChunks);
+
+    // Re-link the remaining free blocks in address order
+    if(!freeBlocks.empty()){
+      for(std::size_t i = 0; i + 1 < freeBlocks.size(); ++i)
+        FreeList::StoreNext(&freeBlocks[i]->m_node, &freeBlocks[i + 1]->m_node);
+      m_freeList.Push(&freeBlocks.front()->m_node, &freeBlocks.back()->m_node);
+    }
+
+    return released;
+  }
+
+  /// Returns the number of blocks currently allocated
+  std::size_t GetAllocationCount() const
+  {
+    return m_allocated.load(std::memory_order_relaxed);
+  }
+
+  /// Returns the size of the blocks currently allocated
+  std::size_t GetAllocationSize() const
+  {
+    return GetAllocationCount() * sizeof(T);
+  }
+
+  /// Returns the number of blocks available without growing
+  std::size_t GetFreeAllocationCount() const
+  {
+    return m_capacity.load(std::memory_order_relaxed) - GetAllocationCount();
+  }
+
+  /// Returns the size of the blocks available without growing
+  std::size_t GetFreeAllocationSize() const
+  {
+    return GetFreeAllocationCount() * sizeof(T);
+  }
+
+  /// Returns the number of chunks the pool currently owns
+  std::size_t GetChunkCount() const
+  {
+    std::lock_guard<std::mutex> lock(m_growMutex);
+    return m_chunks.size();
+  }
+
+  /// Returns the number of objects in each chunk
+  std::size_t GetChunkSize() const { return m_chunkSize; };
+
+private:
+  /**
+   * @brief Slow path of Allocate(), carves more blocks off the current chunk
+   *
+   * Moves on to a reserved chunk, or adds a new one, once the current chunk
+   * is used up.
+   *
+   * @return A block taken from the pool
+   */
+  FreeList::Node* Grow()
+  {
+    std::lock_guard<std::mutex> lock(m_growMutex);
+
+    // Another thread might have grown the pool while we waited
+    FreeList::Node* node = m_freeList.Pop();
+    if(node != nullptr)
+      return node;
+
+    if(m_carveNext == m_carveEnd){
+      if(!m_spareChunks.empty()){
+        m_carveNext = m_spareChunks.back();
+        m_spareChunks.pop_back();
+      }
+      else{
+        m_carveNext = AddChunk();
+      }
+      m_carveEnd = m_carveNext + m_chunkSize;
+    }
+
+    // Link a batch of fresh blocks, keep the first and free the rest
+    std::size_t count = std::min<std::size_t>(CarveBatch, m_carveEnd - m_carveNext);
+    Slot* batch = m_carveNext;
+    m_carveNext += count;
+
+    for(std::size_t i = 1; i + 1 < count; ++i)
+      batch[i].m_node.m_next = &batch[i + 1].m_node;
+    if(count > 1)
+      m_freeList.Push(&batch[1].m_node, &batch[count - 1].m_node);
+
+    return &batch[0].m_node;
+  }
+
+  /**
+   * @brief Allocates a new chunk, without touching its memory
+   * @return The chunk
+   */
+  Slot* AddChunk()
+  {
+    Slot* chunk = static_cast<Slot*>(PageAllocator::Allocate(m_chunkSize * sizeof(Slot), alignof(Slot), s_hugePages));
+    if(chunk == nullptr){
+      LERROR("Failed to allocate a pool chunk of %zu objects", m_chunkSize);
+      throw std::bad_alloc();
+    }
+
+    m_chunks.push_back(chunk);
+    m_capacity.fetch_add(m_chunkSize, std::memory_order_relaxed);
+
+    return chunk;
+  }
+
+  /// Gives a chunk back to the OS
+  void FreeChunk(Slot* _chunk)
+  {
+    PageAllocator::Free(_chunk, m_chunkSize * sizeof(Slot), alignof(Slot), s_hugePages);
+  }
+
+private:
+  /// Number of objects in each chunk
+  std::size_t m_chunkSize;
+
+  /// Total number of blocks across all the chunks
+  std::atomic<std::size_t> m_capacity;
+
+  /// Number of blocks handed out
+  std::atomic<std::size_t> m_allocated;
+
+  /// The list of free blocks, stored inside the blocks themselves
+  FreeList m_freeList;
+
+  /// Chunks of memory requested from the OS, never moved
+  std::vector<Slot*> m_chunks;
+
+  /// Next block of the chunk being carved up, and the end of that chunk
+  Slot* m_carveNext;
+  Slot* m_carveEnd;
+
+  /// Chunks added by Reserve() that haven't been carved up yet
+  std::vector<Slot*> m_spareChunks;
+
+  /// Serialises growing and trimming the pool
+  mutable std::mutex m_growMutex;
+};
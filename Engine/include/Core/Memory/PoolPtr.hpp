@@ -0,0 +1,94 @@
+/**
+ * @file PoolPtr.hpp
+ * @brief Owning smart pointer for objects made by the MemoryManager
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see PoolPtr
+ * @see MakePooled
+ */
+#pragma once
+
+#include "Core/Memory/MemoryManager.hpp"
+
+#include <utility>
+
+/**
+ * @class PoolPtr
+ * @brief Move-only owner of an object created with MEMALLOC().Create<T>()
+ *
+ * The pooled equivalent of std::unique_ptr: destroys the object and gives its
+ * memory back to the right pool when it goes out of scope.
+ */
+template <typename T>
+class PoolPtr
+{
+public:
+  PoolPtr() : m_ptr(nullptr) {};
+
+  /**
+   * @brief Takes ownership of an object
+   * @param _ptr object created with MEMALLOC().Create<T>()
+   */
+  explicit PoolPtr(T* _ptr) : m_ptr(_ptr) {};
+
+  PoolPtr(PoolPtr&& _other) noexcept
+    : m_ptr(_other.Release())
+  {};
+
+  PoolPtr& operator=(PoolPtr&& _other) noexcept
+  {
+    if(this != &_other)
+      Reset(_other.Release());
+    return *this;
+  };
+
+  PoolPtr(const PoolPtr&) = delete;
+  PoolPtr& operator=(const PoolPtr&) = delete;
+
+  /// Destroys the owned object
+  ~PoolPtr()
+  {
+    Reset();
+  };
+
+  /// Returns the owned object
+  T* Get() const { return m_ptr; };
+
+  T* operator->() const { return m_ptr; };
+  T& operator*() const { return *m_ptr; };
+  explicit operator bool() const { return m_ptr != nullptr; };
+
+  /// Gives up ownership without destroying the object
+  T* Release()
+  {
+    T* ptr = m_ptr;
+    m_ptr = nullptr;
+    return ptr;
+  };
+
+  /**
+   * @brief Destroys the owned object and takes ownership of another
+   * @param _ptr new object to own, may be nullptr
+   */
+  void Reset(T* _ptr = nullptr)
+  {
+    T* old = m_ptr;
+    m_ptr = _ptr;
+    MEMALLOC().Destroy<T>(old);
+  };
+
+private:
+  /// The owned object
+  T* m_ptr;
+};
+
+/**
+ * @brief Creates a T in pooled memory, owned by a PoolPtr
+ * @param _args arguments passed to T's constructor
+ */
+template <typename T, typename... Args>
+PoolPtr<T> MakePooled(Args&&... _args)
+{
+  return PoolPtr<T>(MEMALLOC().Create<T>(std::forward<Args>(_args)...));
+}
@@ -0,0 +1,164 @@
+/**
+ * @file SmallObjectAllocator.hpp
+ * @brief General allocator for small objects, bucketed by size class
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see SmallObjectAllocator
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/PoolAllocator.hpp"
+#include "Core/Memory/ThreadCache.hpp"
+
+#include <cstddef>
+#include <new>
+
+/// Alignment of every size-class block
+#define SMALL_OBJECT_ALIGNMENT 16
+
+/// Largest object served from the size classes
+#define SMALL_OBJECT_MAX_SIZE 256
+
+/**
+ * @struct SizeClassBlock
+ * @brief Storage of one block of a size class
+ * @tparam Size size of the class in bytes
+ */
+template <std::size_t Size>
+struct alignas(SMALL_OBJECT_ALIGNMENT) SizeClassBlock
+{
+  unsigned char m_bytes[Size];
+};
+
+/**
+ * @class SmallObjectAllocator
+ * @brief Shares pools between all the objects of similar size
+ *
+ * Requests are rounded up to one of the 16/32/64/128/256 byte size classes,
+ * each backed by one PoolAllocator with its own per-thread caches. Types of
+ * the same size therefore share slabs and each other's free blocks, instead
+ * of every type reserving a pool of its own.
+ *
+ * The typed interface picks the class at compile time. The untyped one picks
+ * it at run time and sends anything too large or over-aligned to the global
+ * heap.
+ */
+class SmallObjectAllocator
+{
+public:
+  /// Returns true if an object fits one of the size classes
+  static constexpr B8 Fits(std::size_t _size, std::size_t _alignment)
+  {
+    return _size <= SMALL_OBJECT_MAX_SIZE && _alignment <= SMALL_OBJECT_ALIGNMENT;
+  }
+
+  /// Returns the size class an object of _size bytes goes to
+  static constexpr std::size_t SizeClass(std::size_t _size)
+  {
+    std::size_t sizeClass = SMALL_OBJECT_ALIGNMENT;
+    while(sizeClass < _size)
+      sizeClass *= 2;
+    return sizeClass;
+  }
+
+  /**
+   * @brief Allocates a block for an object of a size known at compile time
+   * @tparam Size size of the object in bytes
+   */
+  template <std::size_t Size>
+  static void* Allocate()
+  {
+    static_assert(Size <= SMALL_OBJECT_MAX_SIZE, "Object too large for the small-object allocator");
+    return GetThreadCache<SizeClass(Size)>().Allocate();
+  }
+
+  /**
+   * @brief Deallocates a block returned by Allocate<Size>()
+   * @tparam Size size of the object in bytes
+   */
+  template <std::size_t Size>
+  static void Deallocate(void* _block)
+  {
+    GetThreadCache<SizeClass(Size)>().Deallocate(static_cast<SizeClassBlock<SizeClass(Size)>*>(_block));
+  }
+
+  /**
+   * @brief Allocates a block picking the size class at run time
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   */
+  static void* Allocate(std::size_t _size, std::size_t _alignment = alignof(std::max_align_t))
+  {
+    if(!Fits(_size, _alignment))
+      return ::operator new(_size, std::align_val_t(_alignment));
+
+    switch(SizeClass(_size)){
+      case 16:  return Allocate<16>();
+      case 32:  return Allocate<32>();
+      case 64:  return Allocate<64>();
+      case 128: return Allocate<128>();
+      default:  return Allocate<256>();
+    }
+  }
+
+  /**
+   * @brief Deallocates a block returned by Allocate(_size, _alignment)
+   * @param _block the block
+   * @param _size size the block was allocated with
+   * @param _alignment alignment the block was allocated with
+   */
+  static void Deallocate(void* _block, std::size_t _size, std::size_t _alignment = alignof(std::max_align_t))
+  {
+    if(!Fits(_size, _alignment)){
+      ::operator delete(_block, std::align_val_t(_alignment));
+      return;
+    }
+
+    switch(SizeClass(_size)){
+      case 16:  Deallocate<16>(_block);  break;
+      case 32:  Deallocate<32>(_block);  break;
+      case 64:  Deallocate<64>(_block);  break;
+      case 128: Deallocate<128>(_block); break;
+      default:  Deallocate<256>(_block); break;
+    }
+  }
+
+  /**
+   * @brief Returns the pool behind the size class of Size bytes
+   * @tparam Size size of the object in bytes
+   */
+  template <std::size_t Size>
+  static PoolAllocator<SizeClassBlock<SizeClass(Size)>>& GetPool()
+  {
+    return GetClassPool<SizeClass(Size)>();
+  }
+
+  /**
+   * @brief Returns the calling thread's cache of the size class of Size bytes
+   * @tparam Size size of the object in bytes
+   */
+  template <std::size_t Size>
+  static auto& GetThreadCache()
+  {
+    return GetClassThreadCache<SizeClass(Size)>();
+  }
+
+private:
+  /// One pool per size class, whichever object size asks for it
+  template <std::size_t Class>
+  static PoolAllocator<SizeClassBlock<Class>>& GetClassPool()
+  {
+    static PoolAllocator<SizeClassBlock<Class>> pool;
+    return pool;
+  }
+
+  template <std::size_t Class>
+  static ThreadCache<SizeClassBlock<Class>, PoolTraits<SizeClassBlock<Class>>::ThreadCacheSize>& GetClassThreadCache()
+  {
+    static thread_local ThreadCache<SizeClassBlock<Class>, PoolTraits<SizeClassBlock<Class>>::ThreadCacheSize>
+      cache(GetClassPool<Class>());
+    return cache;
+  }
+};
@@ -0,0 +1,175 @@
+/**
+ * @file StackAllocator.hpp
+ * @brief Double-ended LIFO allocator with rollback markers
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see StackAllocator
+ * @see StackScope
+ */
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/**
+ * @enum StackEnd
+ * @brief End of the StackAllocator's buffer to allocate from
+ */
+enum StackEnd
+{
+  STACK_END_BOTTOM,
+  STACK_END_TOP
+};
+
+/**
+ * @class StackAllocator
+ * @brief LIFO allocator over one buffer, growing from both of its ends
+ *
+ * Allocations are freed by rolling back to a marker taken earlier, which
+ * frees everything allocated after it in one go. The two ends grow towards
+ * each other, so e.g. level loading can keep long-lived data at the bottom
+ * and temporary buffers at the top of the same buffer without fragmenting
+ * the heap. Destructors are never run. Not thread-safe.
+ */
+class StackAllocator
+{
+public:
+  /// Position of one of the ends, returned by GetMarker()
+  using Marker = std::size_t;
+
+  /**
+   * @brief Allocates the buffer
+   * @param _size size of the buffer in bytes
+   */
+  explicit StackAllocator(std::size_t _size);
+
+  ~StackAllocator();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(StackAllocator);
+
+  /**
+   * @brief Allocates a block from one of the ends
+   * @param _size size of the block in bytes
+   * @param _alignment alignment of the block, must be a power of two
+   * @param _end end of the buffer to allocate from
+   * @return The block. Throws std::bad_alloc if the ends would overlap.
+   */
+  void* Allocate(std::size_t _size,
+                 std::size_t _alignment = alignof(std::max_align_t),
+                 StackEnd _end = STACK_END_BOTTOM);
+
+  /**
+   * @brief Allocates uninitialised memory for an array of T
+   * @param _count number of objects
+   * @param _end end of the buffer to allocate from
+   */
+  template <typename T>
+  T* Allocate(std::size_t _count = 1, StackEnd _end = STACK_END_BOTTOM)
+  {
+    return static_cast<T*>(Allocate(_count * sizeof(T), alignof(T), _end));
+  }
+
+  /**
+   * @brief Constructs a T at the bottom end. Its destructor will never run.
+   * @param _args arguments passed to T's constructor
+   */
+  template <typename T, typename... Args>
+  T* New(Args&&... _args)
+  {
+    return new (Allocate<T>()) T(std::forward<Args>(_args)...);
+  }
+
+  /**
+   * @brief Returns the current position of one of the ends
+   * @param _end end of the buffer
+   */
+  Marker GetMarker(StackEnd _end = STACK_END_BOTTOM) const;
+
+  /**
+   * @brief Frees everything allocated at one end since the marker was taken
+   * @param _marker marker returned by GetMarker() for the same end
+   * @param _end end of the buffer
+   */
+  void FreeToMarker(Marker _marker, StackEnd _end = STACK_END_BOTTOM);
+
+  /**
+   * @brief Frees everything allocated at one end
+   * @param _end end of the buffer
+   */
+  void Clear(StackEnd _end);
+
+  /// Frees everything at both ends
+  void Clear();
+
+  /// Returns the number of bytes used at one end, padding included
+  std::size_t GetUsed(StackEnd _end) const;
+
+  /// Returns the number of bytes left between the two ends
+  std::size_t GetFree() const { return m_top - m_bottom; };
+
+  /// Returns the size of the buffer
+  std::size_t GetSize() const { return m_size; };
+
+private:
+  /// Buffer both ends allocate from
+  U8* m_buffer;
+
+  /// Size of the buffer in bytes
+  std::size_t m_size;
+
+  /// Offset of the first free byte of the bottom end
+  std::size_t m_bottom;
+
+  /// Offset one past the last free byte of the top end
+  std::size_t m_top;
+};
+
+/**
+ * @class StackScope
+ * @brief Rolls a StackAllocator's end back when it goes out of scope
+ *
+ * Takes a marker on construction, so everything allocated from that end
+ * during the scope is freed when it ends:
+ * @code
+ *   {
+ *     StackScope scope(stack, STACK_END_TOP);
+ *     F32* temp = stack.Allocate<F32>(1024, STACK_END_TOP);
+ *   } // temp is freed here
+ * @endcode
+ */
+class StackScope
+{
+public:
+  /**
+   * @brief Takes a marker of one end of the allocator
+   * @param _allocator allocator to roll back
+   * @param _end end of the allocator to roll back
+   */
+  explicit StackScope(StackAllocator& _allocator, StackEnd _end = STACK_END_BOTTOM)
+    : m_allocator(_allocator), m_end(_end), m_marker(_allocator.GetMarker(_end))
+  {};
+
+  /// Rolls the end back to the marker
+  ~StackScope()
+  {
+    m_allocator.FreeToMarker(m_marker, m_end);
+  };
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(StackScope);
+
+private:
+  /// Allocator to roll back
+  StackAllocator& m_allocator;
+
+  /// End of the allocator to roll back
+  StackEnd m_end;
+
+  /// Position to roll back to
+  StackAllocator::Marker m_marker;
+};
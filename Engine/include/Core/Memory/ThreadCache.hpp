@@ -0,0 +1,187 @@
+/**
+ * @file ThreadCache.hpp
+ * @brief Per-thread cache of free pool blocks
+ * @author Artur Sztuc <artursztuc@googlemail.com>
+ * @date 2023-01-21
+ *
+ * @see ThreadCache
+ * @see ThreadCacheCounters
+ * @see ThreadCacheRegistry
+ */
+#pragma once
+
+#include "defines.h"
+#include "Core/Memory/PoolAllocator.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct ThreadCacheCounters
+ * @brief Hit and miss counters of one thread's caches
+ *
+ * Only the owning thread writes the counters, anyone can read them. Once
+ * the thread exits they are reset and handed to the next new thread.
+ */
+struct ThreadCacheCounters
+{
+  /// Thread the counters belong to
+  std::thread::id m_threadId;
+
+  /// Allocations served straight from the thread's cache
+  std::atomic<U64> m_hits{0};
+
+  /// Allocations that had to refill the cache from the shared pool
+  std::atomic<U64> m_misses{0};
+
+  /// Set while a thread owns the counters, guarded by the registry
+  B8 m_inUse = false;
+
+  /// Bumps a counter without a locked instruction, we are the only writer
+  static void Increment(std::atomic<U64>& _counter)
+  {
+    _counter.store(_counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @struct ThreadCacheStats
+ * @brief Snapshot of one thread's cache counters
+ */
+struct ThreadCacheStats
+{
+  std::thread::id m_threadId;
+  U64 m_hits;
+  U64 m_misses;
+};
+
+/**
+ * @class ThreadCacheRegistry
+ * @brief Singleton keeping the cache counters of every thread
+ */
+class ThreadCacheRegistry
+{
+public:
+  /// Singleton instance getter
+  static ThreadCacheRegistry& GetInstance();
+
+  /// Makes the class non-copyable and non-movable
+  NOCOPY(ThreadCacheRegistry);
+
+  /// Returns the calling thread's counters, registering them on first use
+  ThreadCacheCounters& GetCounters();
+
+  /// Returns the cache hit and miss counts of every running thread
+  std::vector<ThreadCacheStats> GetStats() const;
+
+private:
+  ThreadCacheRegistry() {};
+
+  /// Hands the calling thread's counters back to the registry when it exits
+  struct CountersOwner
+  {
+    ThreadCacheCounters* m_counters = nullptr;
+
+    ~CountersOwner();
+  };
+
+  /// Gives the calling thread counters left by an exited thread, or new ones
+  ThreadCacheCounters& AcquireCounters();
+
+  /// Makes counters free for the next thread to take
+  void ReleaseCounters(ThreadCacheCounters& _counters);
+
+  /// Counters of every thread, never shrinks so the threads can keep
+  /// pointers into it
+  std::deque<ThreadCacheCounters> m_counters;
+
+  /// Guards taking and handing back counters, and reading them all
+  mutable std::mutex m_mutex;
+};
+
+/**
+ * @class ThreadCache
+ * @brief A thread's private stack ("magazine") of free blocks for one pool
+ *
+ * Allocations pop from the cache without touching shared memory. An empty
+ * cache is refilled from the pool with half its capacity in one go, and a
+ * full cache spills half of it back with a single push, so the shared free
+ * list is only touched once per Capacity/2 operations.
+ *
+ * @tparam T type of the pooled objects
+ * @tparam Capacity number of blocks the cache can hold
+ */
+template <typename T, std::size_t Capacity>
+class ThreadCache
+{
+  static_assert(Capacity >= 2, "ThreadCache needs room for at least two blocks");
+
+public:
+  /**
+   * @brief Creates an empty cache over a shared pool
+   * @param _pool pool to refill from and spill to
+   */
+  explicit ThreadCache(PoolAllocator<T>& _pool)
+    : m_pool(_pool), m_counters(ThreadCacheRegistry::GetInstance().GetCounters()), m_count(0)
+  {};
+
+  /// Returns all the cached blocks to the pool when the thread exits
+  ~ThreadCache()
+  {
+    Flush();
+  };
+
+  NOCOPY(ThreadCache);
+
+  /// Takes a block, refilling the cache from the pool if it's empty
+  T* Allocate()
+  {
+    if(m_count == 0){
+      ThreadCacheCounters::Increment(m_counters.m_misses);
+      m_pool.AllocateBatch(m_blocks, Capacity / 2);
+      m_count = Capacity / 2;
+    }
+    else{
+      ThreadCacheCounters::Increment(m_counters.m_hits);
+    }
+
+    return m_blocks[--m_count];
+  }
+
+  /// Keeps a block, spilling half of the cache to the pool if it's full
+  void Deallocate(T* _block)
+  {
+    if(m_count == Capacity){
+      m_pool.DeallocateBatch(m_blocks + Capacity / 2, Capacity / 2);
+      m_count = Capacity / 2;
+    }
+
+    m_blocks[m_count++] = _block;
+  }
+
+  /// Gives every cached block back to the shared pool
+  void Flush()
+  {
+    m_pool.DeallocateBatch(m_blocks, m_count);
+    m_count = 0;
+  }
+
+  /// Returns the number of blocks currently cached
+  std::size_t Size() const { return m_count; };
+
+private:
+  /// Shared pool behind this cache
+  PoolAllocator<T>& m_pool;
+
+  /// Hit and miss counters of the owning thread
+  ThreadCacheCounters& m_counters;
+
+  /// Number of cached blocks
+  std::size_t m_count;
+
+  /// Cached free blocks, used as a stack
+  T* m_blocks[Capacity];
+};
@@ -2,6 +2,7 @@
 
 // Internal includes
 #include "defines.h"
+#include "Core/DataStructures/SmallVector.hpp"
 
 // Std includes
 #include <vector>
@@ -27,6 +28,8 @@ class Task : public std::enable_shared_from_this<Task>
 {
   using TaskPtr = std::shared_ptr<Task>;
   using Function = std::function<void()>;
+  /// Most tasks have a few dependencies at most, keep them inside the task
+  using TaskList = SmallVector<TaskPtr, 4>;
 
 public:
   /**
@@ -69,18 +72,17 @@ public:
 
   /**
    * @brief Get all the thasks that need to be executed prior to this one
-   * @todo TODO: Could this be a const vector pointer of TaskPtrs?
    *
-   * @return std::vector<TaskPtr> Vector of task pointers
+   * @return const TaskList& List of task pointers
    */
-  std::vector<TaskPtr> GetDependencies() { return m_dependencies; };
+  const TaskList& GetDependencies() const { return m_dependencies; };
 
 
-  /// @brief Vector of tasks that this one depends upon
-  std::vector<TaskPtr> m_dependencies;
+  /// @brief Tasks that this one depends upon
+  TaskList m_dependencies;
 
-  /// @brief Vector of tasks that are dependent on this task
-  std::vector<TaskPtr> m_dependents;
+  /// @brief Tasks that are dependent on this task
+  TaskList m_dependents;
 
   std::atomic<B8> m_executed;
   std::atomic<U16> m_dependenciesCount;
@@ -4,27 +4,45 @@
 #include "defines.h"
 #include "Core/Threads/Task.hpp"
 #include "Core/Logging/LogManager.hpp"
+#include "Core/DataStructures/MPMCQueue.hpp"
+#include "Core/DataStructures/WorkStealingDeque.hpp"
 
 // Std includes
-#include <queue>
+#include <atomic>
 #include <list>
+#include <memory>
+#include <memory_resource>
 #include <vector>
-#include <unordered_map>
 #include <condition_variable>
 #include <thread>
 #include <mutex>
-/// @todo Remove strings...
-#include <string>
+
+/// Tasks the injection queue holds before submitting threads have to help
+/// run them
+#ifndef TASK_INJECTION_CAPACITY
+#define TASK_INJECTION_CAPACITY 1024
+#endif
 
 namespace psge
 {
 
 using TaskPtr = std::shared_ptr<Task>;
 using Function = std::function<void()>;
-  
+
 /**
  * @class TaskManager
  * @brief Task manager singleton, schedules and dispatches tasks
+ *
+ * Work-stealing scheduler. Every worker has its own WorkStealingDeque: the
+ * tasks a worker makes ready, i.e. the dependents of the task it just ran,
+ * go to the bottom of its deque and it runs them next, while idle workers
+ * steal from the top of a random victim's deque. Tasks submitted from
+ * outside the pool go through a lock-free injection queue. No lock is taken
+ * per task; workers only sleep on a condition variable once they have found
+ * nothing to do for a while.
+ *
+ * Registered tasks form a graph that runs once per Update(). A task becomes
+ * ready when its last dependency has run.
  */
 class TaskManager
 {
@@ -35,7 +53,7 @@ public:
 
   /**
    * @brief Initialises the threads for TaskManager
-   * 
+   *
    * @param _numThreads number of threads for concurrent task dispatching
    */
   void Initialize(U8 _numThreads);
@@ -44,27 +62,83 @@ public:
   NOCOPY(TaskManager);
 
   /**
-   * @brief Creates task graph and dispatches to threads
-   * 
+   * @brief Waits for the previous frame's tasks, resets the task graph and
+   *        dispatches the tasks that have no dependencies
+   *
    * @param _deltaTime time passed since the last frame
    */
   void Update(F32 _deltaTime);
 
+  /**
+   * @brief Adds a task to the graph run on every Update()
+   *
+   * @param _task task to run every frame, after its dependencies
+   */
+  void RegisterTask(TaskPtr _task);
+
+  /**
+   * @brief Runs a task once, from any thread
+   *
+   * Tasks depending on it run after it as usual. The task is kept alive
+   * until the Update() after it and its dependents have run.
+   *
+   * @param _task task without dependencies of its own
+   */
+  void Submit(TaskPtr _task);
+
+  /**
+   * @brief Blocks until every dispatched task has run, helping to run them
+   *
+   * Must not be called from inside a task, which would wait for itself; it
+   * logs an error and returns straight away there.
+   */
+  void Wait();
+
 // Private member functions
 private:
+  /// Deque of one worker
+  using WorkerQueue = psl::WorkStealingDeque<Task*>;
+
+  /**
+   * @brief Loop of a worker thread
+   *
+   * @param _index index of the worker's deque
+   */
+  void WorkerLoop(U32 _index);
+
+  /**
+   * @brief Makes a ready task available to the workers
+   *
+   * Goes to the calling worker's deque, or to the injection queue from
+   * other threads.
+   *
+   * @param _task task with no dependencies left to run
+   */
+  void Schedule(Task* _task);
+
+  /**
+   * @brief Looks for a task: the worker's own deque first, then the
+   *        injection queue, then the other workers' deques
+   *
+   * @param _index index of the calling worker, anything past the workers
+   *               for other threads
+   * @return Task* task to run, nullptr if none was found
+   */
+  Task* FindTask(U32 _index);
+
   /**
-   * @brief Get the next Task to execute
-   * 
-   * @return TaskPtr pointer to task containing function to execute
+   * @brief Runs a task, then schedules the dependents it made ready
+   *
+   * @param _task task to run
    */
-  TaskPtr GetNextTask();
+  void RunTask(Task* _task);
+
+  /// @brief Bumps the signal and wakes the sleeping workers
+  void WakeWorkers();
 
   /// @brief Resets all the tasks
   void ResetTasks();
 
-  /// @brief Builds the task graph
-  void BuildTaskGraph();
-
   /// @brief Dispatches the tasks
   void DispatchTasks();
 
@@ -78,24 +152,45 @@ private:
 
   U8 m_numThreads{1};
 
-  /// @brief A list of tasks to execute concurrently
-  /// @todo Change to our internal queue?
-  std::list<TaskPtr> m_tasks;
+  /// @brief The deque of each worker thread
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+  /// @brief Tasks scheduled by threads outside the pool
+  psl::MPMCQueue<Task*> m_injected;
 
-  /// @brief Mutex for locking the queue
-  std::mutex m_queueMutex;
+  /// @brief Registered tasks, run every frame, its nodes allocated from the
+  /// small-object pools
+  std::pmr::list<TaskPtr> m_tasks;
+
+  /// @brief Tasks submitted to run once, kept alive until their frame ends
+  std::vector<TaskPtr> m_submitted;
 
   /// @brief Mutex for locking the graph
   std::mutex m_graphMutex;
 
-  std::condition_variable m_condition;
+  /// @brief Tasks scheduled but not run yet
+  std::atomic<U32> m_pending{0};
 
-  /// @brief Bool deciding if we should stop updating/dispatching tasks
-  /// @todo should use this more...
-  B8 m_shouldStop;
+  /// @brief Bumped when tasks are scheduled while workers may be asleep, so
+  /// the sleeping workers can tell they missed nothing
+  std::atomic<U64> m_workSignal{0};
+
+  /// @brief Number of workers asleep or taking their last look for a task
+  /// before they sleep. Workers scheduling a task only touch the signal
+  /// when it isn't zero.
+  std::atomic<U32> m_sleepingWorkers{0};
+
+  /// @brief Mutex the sleeping workers and waiting threads wait with
+  std::mutex m_sleepMutex;
 
-  /// @brief Graph of tasks to execute
-  std::unordered_map<TaskPtr, int> m_graph;
+  /// @brief Condition the workers sleep on
+  std::condition_variable m_wakeCondition;
+
+  /// @brief Condition Wait() sleeps on until no task is pending
+  std::condition_variable m_idleCondition;
+
+  /// @brief Bool deciding if we should stop updating/dispatching tasks
+  std::atomic<B8> m_shouldStop{false};
 };
 
-};
\ No newline at end of file
+};
@@ -38,6 +38,9 @@ struct RendererConfig
   S16 m_applicationName       = "ApplicationName";
   /// @brief Version of the application/game
   I8 m_applicationVersion[3]  = {0, 0, 0};
+
+  /// @brief Bytes of scratch memory per frame in flight
+  U64 m_frameDataSize         = 1 << 20;
 };
 
 class Renderer
@@ -99,6 +99,15 @@ namespace psge
     void UpdateObject(glm::mat4 _modelMatrix,
                       U32 _mode);
 
+    /**
+     * @brief Returns the arena for data that must live while its frame is in flight
+     *
+     * Holds one slot per swapchain frame in flight, so e.g. pending upload
+     * data written while recording a frame stays valid until the GPU is done
+     * with that frame.
+     */
+    BufferedFrameAllocator& GetFrameData() { return *m_frameData; };
+
     void UploadDataRange(VkCommandPool _commandPool,
                          VkFence _fence,
                          VkQueue _queue,
@@ -213,6 +222,9 @@ namespace psge
     /// @brief Vulkan index buffer
     std::shared_ptr<VulkanBuffer> m_objectIndexBuffer;
 
+    /// @brief Per-frame-in-flight scratch memory, flipped at the end of each frame
+    std::unique_ptr<BufferedFrameAllocator> m_frameData;
+
     U64 m_geometryVertexOffset;
     U64 m_geometryIndexOffset;
 
@@ -144,6 +144,8 @@ public:
 
   VkSwapchainKHR GetSwapchain() { return m_swapchain; };
 
+  U8 GetMaxFramesInFlight() { return m_maxFramesInFlight; };
+
   std::shared_ptr<VulkanRenderPass> GetRenderPass() { return m_renderpass; };
 
   B8 SwapchainInitialised() { return m_swapchainInitialised; };
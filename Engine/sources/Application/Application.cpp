@@ -25,6 +25,27 @@ void Application::Configure()
   // Initialising global log
   LOG_NEW("global", LOG_LEVEL_TRACE, std::string(m_config->Get<std::string>("log_location")) + "global_log.txt");
 
+  // Per-thread scratch memory, recycled every frame
+  FRAMEALLOC().Initialize(m_config->Get<std::size_t>("frame_allocator_size", 1 << 20));
+
+  // Scratch memory that has to survive into the next frame
+  BufferedFrameAllocator::InitializeInstance(m_config->Get<std::size_t>("buffered_frame_allocator_size", 1 << 20));
+
+  json memory = m_config->Get<json>("memory", json::object());
+
+  // Per-subsystem memory budgets, warned about when exceeded
+  auto budgets = memory.value("budgets", std::unordered_map<std::string, U64>());
+  for(U8 tag = 0; tag < MEMORY_TAG_MAX; ++tag){
+    auto budget = budgets.find(GetMemoryTagName(static_cast<MemoryTag>(tag)));
+    if(budget != budgets.end())
+      MEMALLOC().SetBudget(static_cast<MemoryTag>(tag), budget->second);
+  }
+
+  // Pools reserved up front, before their types are first allocated
+  auto capacities = memory.value("initial_capacities", std::unordered_map<std::string, std::size_t>());
+  for(const auto& [typeName, capacity] : capacities)
+    MEMALLOC().SetInitialCapacity(typeName, capacity);
+
   CreateWindow();
 
   CreateCamera();
@@ -44,9 +65,16 @@ void Application::CreateCamera()
 
 Application::~Application()
 {
+  FRAMEALLOC().ReportHighWaterMark();
+
   LINFO("Destroying the application's renderer");
   m_renderer.reset();
 
+  // Free the retired nodes while the memory pools they go back to are
+  // still alive, statics are torn down in no useful order after this
+  TaskManager::GetInstance().Wait();
+  EPOCH().DrainAll();
+
   LINFO("Application deconstructed gracefully");
   LOGS_SAVE();
 };
@@ -59,6 +87,11 @@ void Application::Run(bool _shouldRun)
 
   while(!m_shouldClose){
 
+    // Recycle last frame's scratch memory and close its allocation stats
+    FRAMEALLOC().NextFrame();
+    BUFFEREDFRAMEALLOC().NextFrame();
+    MEMALLOC().NextFrame();
+
     // Check if should close
     ShouldLoopClose();
 
@@ -105,6 +138,7 @@ void Application::InitializeRenderer()
 {
   RendererConfig config{};
   config.m_applicationName = (m_config->Get<std::string>("game_title")).data();
+  config.m_frameDataSize   = m_config->Get<U64>("renderer_frame_allocator_size", 1 << 20);
 
   m_renderer = std::make_unique<VulkanRenderer>();
   m_renderer->Initialize(config, m_window, m_camera);
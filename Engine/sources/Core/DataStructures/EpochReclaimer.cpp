@@ -0,0 +1,216 @@
+#include "Core/DataStructures/EpochReclaimer.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+/**
+ * @brief Index of the calling thread's record plus one, 0 while it isn't
+ *        registered. Unregisters the thread when it exits.
+ */
+struct ThreadRegistration
+{
+  U32 m_index = 0;
+
+  ~ThreadRegistration()
+  {
+    if(m_index != 0)
+      EPOCH().UnregisterThread();
+  }
+};
+
+thread_local ThreadRegistration t_registration;
+}
+
+EpochReclaimer& EpochReclaimer::GetInstance()
+{
+  static EpochReclaimer instance;
+  return instance;
+}
+
+EpochReclaimer::EpochReclaimer()
+{
+}
+
+EpochReclaimer::~EpochReclaimer()
+{
+  // Nothing is freed here: the pools the nodes go back to are statics
+  // created after us, so they are already destroyed. DrainAll() frees the
+  // nodes at shutdown while the pools are still there.
+}
+
+void EpochReclaimer::RegisterThread()
+{
+  if(t_registration.m_index != 0)
+    return;
+
+  for(U32 i = 0; i < EPOCH_MAX_THREADS; ++i){
+    B8 expected = false;
+    if(m_records[i].m_inUse.load(std::memory_order_relaxed) ||
+       !m_records[i].m_inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+      continue;
+
+    t_registration.m_index = i + 1;
+
+    U32 count = m_recordCount.load(std::memory_order_relaxed);
+    while(count < i + 1 && !m_recordCount.compare_exchange_weak(count, i + 1, std::memory_order_release));
+    return;
+  }
+
+  LERROR("More than %i threads registered with the EpochReclaimer", EPOCH_MAX_THREADS);
+  throw std::runtime_error("Too many threads registered with the EpochReclaimer");
+}
+
+void EpochReclaimer::UnregisterThread()
+{
+  if(t_registration.m_index == 0)
+    return;
+
+  ThreadRecord& record = m_records[t_registration.m_index - 1];
+  if(record.m_nesting != 0)
+    LWARN("Thread unregistered from the EpochReclaimer inside a guard");
+
+  {
+    std::lock_guard<std::mutex> lock(m_orphanMutex);
+    for(LimboList& list : record.m_limbo){
+      if(!list.m_nodes.empty())
+        m_orphans.push_back(std::move(list));
+      list.m_nodes.clear();
+      list.m_epoch = 0;
+    }
+  }
+
+  record.m_nesting = 0;
+  record.m_retiredSinceCollect = 0;
+  record.m_state.store(0, std::memory_order_release);
+  record.m_inUse.store(false, std::memory_order_release);
+  t_registration.m_index = 0;
+}
+
+EpochReclaimer::ThreadRecord& EpochReclaimer::GetRecord()
+{
+  if(t_registration.m_index == 0)
+    RegisterThread();
+  return m_records[t_registration.m_index - 1];
+}
+
+void EpochReclaimer::Enter()
+{
+  ThreadRecord& record = GetRecord();
+  if(record.m_nesting++ != 0)
+    return;
+
+  // Announce the epoch before touching any shared node. A read-modify-write
+  // rather than a store, so the node reads can't move ahead of it, and in the
+  // single seq_cst order TryAdvance() reads the pin from
+  U64 epoch = m_epoch.load(std::memory_order_relaxed);
+  record.m_state.exchange((epoch << 1) | 1, std::memory_order_seq_cst);
+}
+
+void EpochReclaimer::Leave()
+{
+  ThreadRecord& record = GetRecord();
+  if(--record.m_nesting != 0)
+    return;
+
+  // Releases every read made inside the guard to whoever frees the nodes
+  record.m_state.store(record.m_state.load(std::memory_order_relaxed) & ~U64(1), std::memory_order_release);
+}
+
+void EpochReclaimer::Retire(void* _node, void (*_deleter)(void*))
+{
+  ThreadRecord& record = GetRecord();
+  U64 epoch = m_epoch.load(std::memory_order_acquire);
+
+  // The list last held the nodes of three epochs ago, which are safe by now
+  LimboList& list = record.m_limbo[epoch % 3];
+  if(list.m_epoch != epoch){
+    Free(list);
+    list.m_epoch = epoch;
+  }
+
+  list.m_nodes.push_back({_node, _deleter});
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+
+  if(++record.m_retiredSinceCollect >= EPOCH_RECLAIM_BATCH)
+    Collect();
+}
+
+std::size_t EpochReclaimer::Collect()
+{
+  ThreadRecord& record = GetRecord();
+  record.m_retiredSinceCollect = 0;
+
+  TryAdvance();
+  U64 epoch = m_epoch.load(std::memory_order_acquire);
+
+  std::size_t freed = 0;
+  for(LimboList& list : record.m_limbo)
+    if(list.m_epoch + 2 <= epoch)
+      freed += Free(list);
+
+  // Whoever holds the lock is collecting the orphans already
+  std::unique_lock<std::mutex> lock(m_orphanMutex, std::try_to_lock);
+  if(lock.owns_lock()){
+    std::size_t kept = 0;
+    for(std::size_t i = 0; i < m_orphans.size(); ++i){
+      if(m_orphans[i].m_epoch + 2 <= epoch)
+        freed += Free(m_orphans[i]);
+      else if(i != kept)
+        std::swap(m_orphans[kept++], m_orphans[i]);
+      else
+        ++kept;
+    }
+    m_orphans.resize(kept);
+  }
+
+  return freed;
+}
+
+std::size_t EpochReclaimer::DrainAll()
+{
+  // No thread is left that could be reading the nodes
+  std::size_t freed = 0;
+  U32 count = m_recordCount.load(std::memory_order_acquire);
+  for(U32 i = 0; i < count; ++i)
+    for(LimboList& list : m_records[i].m_limbo)
+      freed += Free(list);
+
+  std::lock_guard<std::mutex> lock(m_orphanMutex);
+  for(LimboList& list : m_orphans)
+    freed += Free(list);
+  m_orphans.clear();
+
+  return freed;
+}
+
+void EpochReclaimer::TryAdvance()
+{
+  U64 epoch = m_epoch.load(std::memory_order_seq_cst);
+
+  U32 count = m_recordCount.load(std::memory_order_acquire);
+  for(U32 i = 0; i < count; ++i){
+    const ThreadRecord& record = m_records[i];
+    if(!record.m_inUse.load(std::memory_order_acquire))
+      continue;
+
+    // A thread still pinned to an older epoch may see nodes retired in it
+    U64 state = record.m_state.load(std::memory_order_seq_cst);
+    if((state & 1) && (state >> 1) != epoch)
+      return;
+  }
+
+  m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+}
+
+std::size_t EpochReclaimer::Free(LimboList& _list)
+{
+  std::size_t count = _list.m_nodes.size();
+  for(const RetiredNode& node : _list.m_nodes)
+    node.m_deleter(node.m_node);
+
+  _list.m_nodes.clear();
+  m_pending.fetch_sub(count, std::memory_order_relaxed);
+  return count;
+}
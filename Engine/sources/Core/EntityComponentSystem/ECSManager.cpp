@@ -11,6 +11,8 @@ ECSManager& ECSManager::GetInstance()
 }
 
 ECSManager::ECSManager()
+  : m_entities(&SmallObjectMemoryResource::GetInstance()),
+    m_components(&SmallObjectMemoryResource::GetInstance())
 {
 };
 
@@ -27,8 +29,7 @@ ECSManager::~ECSManager()
 
 Entity* ECSManager::CreateEntity()
 {
-  Entity* entity = MEMALLOC().Allocate<Entity>();
-  *entity = Entity();
+  Entity* entity = MEMALLOC().Create<Entity>();
 
   m_entities.push_back(entity);
 
@@ -38,13 +39,16 @@ Entity* ECSManager::CreateEntity()
 void ECSManager::DestroyEntity(Entity* _entity)
 {
   for(auto& componentArray : m_components){
-    ComponentBase* bb = (componentArray.second[_entity->GetId()]);
-    MEMALLOC().Deallocate(bb);
-    componentArray.second.erase(_entity->GetId());
+    auto component = componentArray.second.find(_entity->GetId());
+    if(component == componentArray.second.end())
+      continue;
+
+    m_componentDeleters[componentArray.first](component->second);
+    componentArray.second.erase(component);
   }
 
   // TODO: Check if there are faster ways...
-  MEMALLOC().Deallocate(_entity);
+  MEMALLOC().Destroy(_entity);
   auto it = std::find(m_entities.begin(), m_entities.end(), _entity);
   if(it != m_entities.end())
     m_entities.erase(it);
@@ -56,12 +60,11 @@ void ECSManager::AddComponent(Entity* _entity, Args&&... _args)
   // TODO: Insert our own assert
   static_assert(std::is_base_of<ComponentBase, C>::value, "Component must be derived from ComponentBase!");
 
-  // TODO: Use our own memory manager
-  //C* component = MEMALLOC().Allocate<C>(std::forward<Args>(args_)...);
-  C* component = MEMALLOC().Allocate<C>();
-  *component = C(std::forward<Args>(_args)...);
+  C* component = MEMALLOC().Create<C>(std::forward<Args>(_args)...);
   m_components[typeid(C)][_entity->GetId()] = component;
-  //m_components[typeid(C)][entity_->GetId()] = new C(std::forward<Args>(args_)...);
+  m_componentDeleters[typeid(C)] = [](ComponentBase* _component){
+    MEMALLOC().Destroy<C>(static_cast<C*>(_component));
+  };
 };
 
 template <typename C>
@@ -69,9 +72,13 @@ void ECSManager::RemoveComponent(Entity* _entity)
 {
   static_assert(std::is_base_of<ComponentBase, C>::value, "Component must be derived from ComponentBase!");
 
-  // TODO: Check if it should not be the other way round, like in deleting entities...
-  delete m_components[typeid(C)][_entity->GetId()];
-  m_components[typeid(C)].erase(_entity->GetId());
+  auto& components = m_components[typeid(C)];
+  auto component = components.find(_entity->GetId());
+  if(component == components.end())
+    return;
+
+  MEMALLOC().Destroy<C>(static_cast<C*>(component->second));
+  components.erase(component);
 }
 
 template <typename C>
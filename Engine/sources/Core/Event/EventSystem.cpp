@@ -1,6 +1,8 @@
 #include "Core/Event/EventSystem.hpp"
+#include "Core/Memory/MemoryResource.hpp"
 
 EventSystem::EventSystem()
+  : m_handlers(&SmallObjectMemoryResource::GetInstance())
 {
 }
 
@@ -13,7 +15,7 @@ EventSystem& EventSystem::GetInstance()
 void EventSystem::Subscribe(const EventType& _type,
                             EventFunction&& _handler)
 {
-  m_handlers[_type].push_back(_handler);
+  m_handlers[_type].PushBack(std::move(_handler));
 }
 
 void EventSystem::SendEvent(const Event& _event)
@@ -23,19 +25,15 @@ void EventSystem::SendEvent(const Event& _event)
 
 void EventSystem::Update()
 {
-  bool noEvents = false;
-  while (!noEvents){
-
-    if(m_queue.Empty()){
-      noEvents = true;
-      continue;
-    }
-
+  // Handlers can send more events, keep going until none are left
+  while(m_queue.PopAll(m_dispatchBuffer) > 0){
     // TODO: Should we implement a separate type of event loop for ECS?
     // TODO: Perhaps the handlers could also actually be whole system themselves, which will progress the event to objects that are actually specified in the event itself (if applicable)
-    Event event = m_queue.Pop();
-    for(auto&& handler : m_handlers[event.GetType()]){
-      handler(event);
+    for(Event& event : m_dispatchBuffer){
+      for(auto&& handler : m_handlers[event.GetType()]){
+        handler(event);
+      }
     }
+    m_dispatchBuffer.clear();
   }
 }
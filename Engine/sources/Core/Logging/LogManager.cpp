@@ -1,4 +1,5 @@
 #include "Core/Logging/LogManager.hpp"
+#include "Core/Memory/MemoryResource.hpp"
 
 LogManager& LogManager::GetInstance()
 {
@@ -6,6 +7,12 @@ LogManager& LogManager::GetInstance()
   return instance;
 };
 
+LogManager::LogManager()
+  : m_loggers(&SmallObjectMemoryResource::GetInstance()),
+    m_logFiles(&SmallObjectMemoryResource::GetInstance())
+{
+};
+
 void LogManager::SetLogLevel(const std::string& _loggerName, 
                              LogLevel _logLevel)
 {
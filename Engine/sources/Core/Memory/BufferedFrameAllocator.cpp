@@ -0,0 +1,90 @@
+#include "Core/Memory/BufferedFrameAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+// Slots start on their own cache line so threads writing to neighbouring
+// slots don't share one
+static constexpr std::size_t SLOT_ALIGNMENT = 64;
+
+std::size_t BufferedFrameAllocator::m_instanceSlotSize = 1 << 20;
+
+BufferedFrameAllocator::BufferedFrameAllocator(std::size_t _slotSize, U8 _slotCount)
+  : m_slotSize((_slotSize + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1)),
+    m_memory(nullptr), m_current(0), m_peak(0)
+{
+  U8 slotCount = std::max<U8>(_slotCount, 1);
+
+  m_memory = static_cast<U8*>(std::aligned_alloc(SLOT_ALIGNMENT, m_slotSize * slotCount));
+  if(m_memory == nullptr)
+    throw std::bad_alloc();
+
+  for(U8 idx = 0; idx < slotCount; ++idx){
+    m_slots.push_back(std::make_unique<Slot>());
+    m_slots.back()->m_buffer = m_memory + idx * m_slotSize;
+  }
+}
+
+BufferedFrameAllocator::~BufferedFrameAllocator()
+{
+  for(std::unique_ptr<Slot>& slot : m_slots)
+    Recycle(*slot);
+  std::free(m_memory);
+}
+
+BufferedFrameAllocator& BufferedFrameAllocator::GetInstance()
+{
+  static BufferedFrameAllocator instance(m_instanceSlotSize, 2);
+  return instance;
+}
+
+void BufferedFrameAllocator::InitializeInstance(std::size_t _slotSize)
+{
+  m_instanceSlotSize = _slotSize;
+}
+
+void BufferedFrameAllocator::NextFrame()
+{
+  m_current = (m_current + 1) % m_slots.size();
+  Recycle(*m_slots[m_current]);
+}
+
+void* BufferedFrameAllocator::Allocate(std::size_t _size, std::size_t _alignment)
+{
+  Slot& slot = *m_slots[m_current];
+
+  // Reserve enough to align within the reservation, so a single fetch_add is
+  // all threads need to agree on
+  std::size_t reserved = _size + _alignment - 1;
+  std::size_t offset = slot.m_offset.fetch_add(reserved, std::memory_order_relaxed);
+  std::size_t used = offset + reserved;
+
+  std::size_t peak = m_peak.load(std::memory_order_relaxed);
+  while(used > peak && !m_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed));
+
+  if(used > m_slotSize){
+    // Out of room, use the heap until this slot is recycled
+    void* block = std::aligned_alloc(_alignment, (_size + _alignment - 1) & ~(_alignment - 1));
+    if(block == nullptr)
+      throw std::bad_alloc();
+
+    std::lock_guard<std::mutex> lock(slot.m_overflowMutex);
+    slot.m_overflow.push_back(block);
+    return block;
+  }
+
+  std::uintptr_t current = reinterpret_cast<std::uintptr_t>(slot.m_buffer) + offset;
+  std::uintptr_t aligned = (current + (_alignment - 1)) & ~(std::uintptr_t(_alignment) - 1);
+  return reinterpret_cast<void*>(aligned);
+}
+
+void BufferedFrameAllocator::Recycle(Slot& _slot)
+{
+  std::lock_guard<std::mutex> lock(_slot.m_overflowMutex);
+  for(void* block : _slot.m_overflow)
+    std::free(block);
+  _slot.m_overflow.clear();
+
+  _slot.m_offset.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,142 @@
+#include "Core/Memory/FrameAllocator.hpp"
+#include "Core/Logging/LogManager.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Used if nothing calls Initialize(), e.g. in unit tests
+static constexpr std::size_t DEFAULT_REGION_SIZE = 1 << 20;
+
+FrameAllocator& FrameAllocator::GetInstance()
+{
+  static FrameAllocator instance;
+  return instance;
+}
+
+FrameAllocator::FrameAllocator()
+  : m_regionSize(DEFAULT_REGION_SIZE), m_frameIndex(0)
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+  for(Region& region : m_regions){
+    for(void* block : region.m_overflow)
+      std::free(block);
+    std::free(region.m_arena.GetBuffer());
+  }
+}
+
+void FrameAllocator::Initialize(std::size_t _regionSize)
+{
+  std::lock_guard<std::mutex> lock(m_regionsMutex);
+  m_regionSize = _regionSize;
+}
+
+void FrameAllocator::NextFrame()
+{
+  // Regions are recycled lazily by their own threads, so nobody writes to
+  // another thread's region
+  m_frameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* FrameAllocator::Allocate(std::size_t _size, std::size_t _alignment)
+{
+  Region& region = GetRegion();
+
+  void* block = region.m_arena.Allocate(_size, _alignment);
+  if(block == nullptr){
+    // Out of room, use the heap until the end of the frame
+    block = std::aligned_alloc(_alignment, (_size + _alignment - 1) & ~(_alignment - 1));
+    if(block == nullptr)
+      throw std::bad_alloc();
+    region.m_overflow.push_back(block);
+    region.m_overflowBytes += _size;
+  }
+
+  std::size_t used = region.m_arena.GetUsed() + region.m_overflowBytes;
+  if(used > region.m_peak.load(std::memory_order_relaxed))
+    region.m_peak.store(used, std::memory_order_relaxed);
+
+  return block;
+}
+
+std::size_t FrameAllocator::GetHighWaterMark() const
+{
+  std::lock_guard<std::mutex> lock(m_regionsMutex);
+
+  std::size_t peak = 0;
+  for(const Region& region : m_regions)
+    peak = std::max(peak, region.m_peak.load(std::memory_order_relaxed));
+  return peak;
+}
+
+void FrameAllocator::ReportHighWaterMark() const
+{
+  std::size_t peak = GetHighWaterMark();
+  if(peak > m_regionSize)
+    LWARN("Frame allocator high-water mark is %zu bytes, over the %zu bytes per thread. Increase frame_allocator_size.",
+          peak, m_regionSize);
+  else
+    LINFO("Frame allocator high-water mark is %zu of %zu bytes per thread", peak, m_regionSize);
+}
+
+FrameAllocator::RegionOwner::~RegionOwner()
+{
+  if(m_region != nullptr)
+    FRAMEALLOC().ReleaseRegion(*m_region);
+  m_region = nullptr;
+}
+
+FrameAllocator::Region& FrameAllocator::GetRegion()
+{
+  static thread_local RegionOwner owner;
+  if(owner.m_region == nullptr)
+    owner.m_region = &AcquireRegion();
+
+  Region& region = *owner.m_region;
+  if(region.m_frame != GetFrameIndex())
+    Recycle(region);
+
+  return region;
+}
+
+FrameAllocator::Region& FrameAllocator::AcquireRegion()
+{
+  std::lock_guard<std::mutex> lock(m_regionsMutex);
+
+  // Regions made before a resize keep their old size
+  for(Region& region : m_regions){
+    if(!region.m_inUse && region.m_arena.GetSize() == m_regionSize){
+      region.m_inUse = true;
+      return region;
+    }
+  }
+
+  void* buffer = std::malloc(m_regionSize);
+  if(buffer == nullptr)
+    throw std::bad_alloc();
+
+  Region& region = m_regions.emplace_back();
+  region.m_arena = LinearAllocator(buffer, m_regionSize);
+  region.m_frame = GetFrameIndex();
+  region.m_inUse = true;
+  return region;
+}
+
+void FrameAllocator::ReleaseRegion(Region& _region)
+{
+  std::lock_guard<std::mutex> lock(m_regionsMutex);
+  _region.m_inUse = false;
+}
+
+void FrameAllocator::Recycle(Region& _region)
+{
+  for(void* block : _region.m_overflow)
+    std::free(block);
+  _region.m_overflow.clear();
+  _region.m_overflowBytes = 0;
+
+  _region.m_arena.Reset();
+  _region.m_frame = GetFrameIndex();
+}
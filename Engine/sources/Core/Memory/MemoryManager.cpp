@@ -1,50 +1,293 @@
 #include "Core/Memory/MemoryManager.hpp"
 
+#include <algorithm>
+#include <cxxabi.h>
+
+namespace
+{
+/// Gives the calling thread's block of counters back when the thread exits
+struct ThreadCountersOwner
+{
+  ThreadAllocationCounters* m_counters = nullptr;
+  std::mutex* m_mutex = nullptr;
+
+  ~ThreadCountersOwner()
+  {
+    if(m_counters == nullptr)
+      return;
+    std::lock_guard<std::mutex> lock(*m_mutex);
+    m_counters->m_inUse = false;
+  }
+};
+
+thread_local ThreadCountersOwner t_countersOwner;
+}
+
 MemoryManager& MemoryManager::GetInstance()
 {
   static MemoryManager instance;
   return instance;
 }
 
-template <typename T>
-T* MemoryManager::Allocate()
+MemoryManager::MemoryManager()
+{
+  // Mixed types, so no size to count bytes with
+  AllocationCounters& other = m_counters[MEMORY_OTHER_TYPES];
+  other.m_typeName = MEMORY_OTHER_TYPES_NAME;
+  other.m_typeSize = 0;
+  other.m_registered.store(true, std::memory_order_release);
+}
+
+U32 MemoryManager::RegisterType(const char* _typeName, std::size_t _typeSize, MemoryTag _tag)
 {
-  std::type_index type = typeid(T);
-  if(m_allocationCounts.find(type) == m_allocationCounts.end()){
-    // create new pool for this object type
-    m_allocationCounts[type] = 0;
+  U32 index = m_typeCount.fetch_add(1, std::memory_order_relaxed);
+  if(index >= MEMORY_MAX_TRACKED_TYPES){
+    m_typeCount.store(MEMORY_MAX_TRACKED_TYPES, std::memory_order_relaxed);
+    if(!m_otherTypesReported.exchange(true, std::memory_order_relaxed))
+      LWARN("MemoryManager tracks at most %d types, %s and any after it are counted as %s",
+            MEMORY_MAX_TRACKED_TYPES, _typeName, MEMORY_OTHER_TYPES_NAME);
+    return MEMORY_OTHER_TYPES;
   }
-  m_allocationCounts[type]++;
 
-  return GetPoolAllocator<T>().Allocate();
+  AllocationCounters& counters = m_counters[index];
+  counters.m_typeName = _typeName;
+  counters.m_typeSize = _typeSize;
+  counters.m_tag      = _tag;
+  counters.m_registered.store(true, std::memory_order_release);
+  return index;
 }
 
-template <typename T>
-void MemoryManager::Deallocate(T* ptr)
+void MemoryManager::SetInitialCapacity(const std::string& _typeName, std::size_t _capacity)
 {
-  std::type_index type = typeid(T);
-  m_allocationCounts[type]--;
-  GetPoolAllocator<T>().Deallocate(ptr);
+  std::lock_guard<std::mutex> lock(m_capacityMutex);
+  m_initialCapacities[_typeName] = _capacity;
+}
+
+std::size_t MemoryManager::GetInitialCapacity(const char* _typeName) const
+{
+  std::lock_guard<std::mutex> lock(m_capacityMutex);
+  if(m_initialCapacities.empty())
+    return 0;
+
+  int status;
+  char* demangled = abi::__cxa_demangle(_typeName, 0, 0, &status);
+  auto capacity = m_initialCapacities.find((status == 0 && demangled) ? demangled : _typeName);
+  std::free(demangled);
+
+  return capacity != m_initialCapacities.end() ? capacity->second : 0;
+}
+
+ThreadAllocationCounters& MemoryManager::AcquireThreadCounters()
+{
+  std::lock_guard<std::mutex> lock(m_threadCountersMutex);
+
+  // The counts of an exited thread stay in the sums, we add on top of them
+  ThreadAllocationCounters* counters = nullptr;
+  for(ThreadAllocationCounters& block : m_threadCounters){
+    if(!block.m_inUse){
+      counters = &block;
+      break;
+    }
+  }
+  if(counters == nullptr)
+    counters = &m_threadCounters.emplace_back();
+
+  counters->m_inUse = true;
+  t_countersOwner.m_counters = counters;
+  t_countersOwner.m_mutex = &m_threadCountersMutex;
+  return *counters;
+}
+
+MemoryManager::CountTotals MemoryManager::SumTypeCounts(U32 _index) const
+{
+  CountTotals totals;
+  std::lock_guard<std::mutex> lock(m_threadCountersMutex);
+  for(const ThreadAllocationCounters& counters : m_threadCounters){
+    totals.m_allocations += counters.m_allocations[_index].load(std::memory_order_relaxed);
+    totals.m_frees       += counters.m_frees[_index].load(std::memory_order_relaxed);
+  }
+  return totals;
+}
+
+MemoryManager::CountTotals MemoryManager::SumTagCounts(MemoryTag _tag) const
+{
+  CountTotals totals;
+  std::lock_guard<std::mutex> lock(m_threadCountersMutex);
+  for(const ThreadAllocationCounters& counters : m_threadCounters){
+    totals.m_allocations    += counters.m_tagAllocations[_tag].load(std::memory_order_relaxed);
+    totals.m_frees          += counters.m_tagFrees[_tag].load(std::memory_order_relaxed);
+    totals.m_bytesAllocated += counters.m_tagBytesAllocated[_tag].load(std::memory_order_relaxed);
+    totals.m_bytesFreed     += counters.m_tagBytesFreed[_tag].load(std::memory_order_relaxed);
+  }
+  return totals;
+}
+
+std::size_t MemoryManager::GetLiveCount(U32 _index) const
+{
+  // Frees counted by another thread may be read before their allocations
+  CountTotals totals = SumTypeCounts(_index);
+  return totals.m_allocations > totals.m_frees ? totals.m_allocations - totals.m_frees : 0;
 }
 
 size_t MemoryManager::GetAllocatorTypes() const
 {
-  return m_allocationCounts.size();
+  size_t types = 0;
+  U32 count = m_typeCount.load(std::memory_order_acquire);
+  if(count > MEMORY_MAX_TRACKED_TYPES)
+    count = MEMORY_MAX_TRACKED_TYPES;
+  for(U32 i = 0; i < count; ++i){
+    if(SumTypeCounts(i).m_allocations > 0)
+      types++;
+  }
+  return types;
 }
 
-template <typename T>
-size_t MemoryManager::GetAllocationCount()
+void MemoryManager::ReportOverBudget(MemoryTag _tag, I64 _bytes)
 {
-  std::type_index type = typeid(T);
-  size_t ret = 0;
-  if(m_allocationCounts.find(type) != m_allocationCounts.end())
-    ret = m_allocationCounts[type];
-  return ret;
+  LWARN("Memory tag %s is over its budget: %lld of %llu bytes",
+        GetMemoryTagName(_tag),
+        static_cast<long long>(_bytes),
+        static_cast<unsigned long long>(m_tagCounters[_tag].m_budget.load(std::memory_order_relaxed)));
+}
+
+void MemoryManager::SetBudget(MemoryTag _tag, U64 _budget)
+{
+  m_tagCounters[_tag].m_budget.store(_budget, std::memory_order_relaxed);
+  m_tagCounters[_tag].m_overBudget.store(false, std::memory_order_relaxed);
+}
+
+U64 MemoryManager::GetBudget(MemoryTag _tag) const
+{
+  return m_tagCounters[_tag].m_budget.load(std::memory_order_relaxed);
+}
+
+void MemoryManager::NextFrame()
+{
+  for(U8 tag = 0; tag < MEMORY_TAG_MAX; ++tag){
+    MemoryTagCounters& counters = m_tagCounters[tag];
+    CountTotals totals = SumTagCounts(static_cast<MemoryTag>(tag));
+    counters.m_lastFrameAllocations.store(totals.m_allocations - counters.m_allocationsAtFrameStart, std::memory_order_relaxed);
+    counters.m_lastFrameFrees.store(totals.m_frees - counters.m_freesAtFrameStart, std::memory_order_relaxed);
+    counters.m_allocationsAtFrameStart = totals.m_allocations;
+    counters.m_freesAtFrameStart       = totals.m_frees;
+
+    I64 bytes = static_cast<I64>(totals.m_bytesAllocated - totals.m_bytesFreed);
+    if(bytes > counters.m_peakBytes.load(std::memory_order_relaxed))
+      counters.m_peakBytes.store(bytes, std::memory_order_relaxed);
+
+    // Warn once when the tag goes over, and again next time it does
+    U64 budget = counters.m_budget.load(std::memory_order_relaxed);
+    if(budget > 0 && bytes > static_cast<I64>(budget)){
+      if(!counters.m_overBudget.exchange(true, std::memory_order_relaxed))
+        ReportOverBudget(static_cast<MemoryTag>(tag), bytes);
+    }
+    else{
+      counters.m_overBudget.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  auto closeFrame = [this](U32 _index){
+    AllocationCounters& counters = m_counters[_index];
+    CountTotals totals = SumTypeCounts(_index);
+    U64 atFrameStart = counters.m_totalAtFrameStart.exchange(totals.m_allocations, std::memory_order_relaxed);
+    counters.m_lastFrame.store(totals.m_allocations - atFrameStart, std::memory_order_relaxed);
+
+    I64 live = totals.m_allocations > totals.m_frees ? static_cast<I64>(totals.m_allocations - totals.m_frees) : 0;
+    if(live > counters.m_peak.load(std::memory_order_relaxed))
+      counters.m_peak.store(live, std::memory_order_relaxed);
+  };
+
+  U32 count = m_typeCount.load(std::memory_order_acquire);
+  if(count > MEMORY_MAX_TRACKED_TYPES)
+    count = MEMORY_MAX_TRACKED_TYPES;
+
+  for(U32 i = 0; i < count; ++i)
+    closeFrame(i);
+  closeFrame(MEMORY_OTHER_TYPES);
+}
+
+std::vector<AllocationStats> MemoryManager::GetAllocationStats() const
+{
+  std::vector<AllocationStats> stats;
+  U32 count = m_typeCount.load(std::memory_order_acquire);
+  if(count > MEMORY_MAX_TRACKED_TYPES)
+    count = MEMORY_MAX_TRACKED_TYPES;
+
+  // The types past the limit come last, under their own name
+  for(U32 i = 0; i <= count; ++i){
+    U32 index = i < count ? i : MEMORY_OTHER_TYPES;
+    const AllocationCounters& counters = m_counters[index];
+    // Slot handed out but not written yet by the registering thread
+    if(!counters.m_registered.load(std::memory_order_acquire))
+      continue;
+
+    CountTotals totals = SumTypeCounts(index);
+    if(totals.m_allocations == 0)
+      continue;
+
+    U64 liveCount = totals.m_allocations > totals.m_frees ? totals.m_allocations - totals.m_frees : 0;
+    U64 peak = static_cast<U64>(counters.m_peak.load(std::memory_order_relaxed));
+
+    int status;
+    char* demangled = abi::__cxa_demangle(counters.m_typeName, 0, 0, &status);
+    std::string typeName = (status == 0 && demangled) ? demangled : counters.m_typeName;
+    std::free(demangled);
+
+    stats.push_back({typeName,
+                     counters.m_typeSize,
+                     counters.m_tag,
+                     liveCount,
+                     std::max(peak, liveCount),
+                     liveCount * counters.m_typeSize,
+                     counters.m_lastFrame.load(std::memory_order_relaxed),
+                     totals.m_allocations});
+  }
+  return stats;
+}
+
+std::vector<MemoryTagStats> MemoryManager::GetMemoryTagStats() const
+{
+  std::vector<MemoryTagStats> stats;
+  stats.reserve(MEMORY_TAG_MAX);
+  for(U8 tag = 0; tag < MEMORY_TAG_MAX; ++tag){
+    const MemoryTagCounters& counters = m_tagCounters[tag];
+    CountTotals totals = SumTagCounts(static_cast<MemoryTag>(tag));
+    U64 bytes = totals.m_bytesAllocated > totals.m_bytesFreed ? totals.m_bytesAllocated - totals.m_bytesFreed : 0;
+    U64 peak = static_cast<U64>(counters.m_peakBytes.load(std::memory_order_relaxed));
+    stats.push_back({static_cast<MemoryTag>(tag),
+                     bytes,
+                     std::max(peak, bytes),
+                     counters.m_budget.load(std::memory_order_relaxed),
+                     counters.m_lastFrameAllocations.load(std::memory_order_relaxed),
+                     counters.m_lastFrameFrees.load(std::memory_order_relaxed)});
+  }
+  return stats;
+}
+
+void MemoryManager::Print()
+{
+  for(const MemoryTagStats& stats : GetMemoryTagStats())
+  {
+    std::cout << "[" << GetMemoryTagName(stats.m_tag) << "] "
+              << stats.m_bytes << " bytes";
+    if(stats.m_budget > 0)
+      std::cout << " of " << stats.m_budget;
+    std::cout << ", " << stats.m_peakBytes << " peak, "
+              << stats.m_allocationsPerFrame << " allocations and "
+              << stats.m_freesPerFrame << " frees last frame" << std::endl;
+  }
+
+  for(const AllocationStats& stats : GetAllocationStats())
+  {
+    std::cout << "  " << stats.m_typeName << " (" << GetMemoryTagName(stats.m_tag)
+              << ") : " << stats.m_liveCount
+              << " live, " << stats.m_peakCount << " peak, "
+              << stats.m_bytes << " bytes, "
+              << stats.m_allocationsPerFrame << " last frame" << std::endl;
+  }
 }
 
-template<typename T>
-PoolAllocator<T>& MemoryManager::GetPoolAllocator()
+std::vector<ThreadCacheStats> MemoryManager::GetThreadCacheStats() const
 {
-  static PoolAllocator<T> poolAllocator;
-  return poolAllocator;
+  return ThreadCacheRegistry::GetInstance().GetStats();
 }
@@ -0,0 +1,56 @@
+#include "Core/Memory/MemoryResource.hpp"
+
+#include <new>
+
+SmallObjectMemoryResource& SmallObjectMemoryResource::GetInstance()
+{
+  static SmallObjectMemoryResource instance;
+  return instance;
+}
+
+SmallObjectMemoryResource::SmallObjectMemoryResource()
+{
+  // Create the pools first, so they are destroyed after the resource and
+  // everything that allocated from it
+  SmallObjectAllocator::GetPool<16>();
+  SmallObjectAllocator::GetPool<32>();
+  SmallObjectAllocator::GetPool<64>();
+  SmallObjectAllocator::GetPool<128>();
+  SmallObjectAllocator::GetPool<256>();
+}
+
+void* SmallObjectMemoryResource::do_allocate(std::size_t _size, std::size_t _alignment)
+{
+  if(!SmallObjectAllocator::Fits(_size, _alignment))
+    return ::operator new(_size, std::align_val_t(_alignment));
+
+  switch(SmallObjectAllocator::SizeClass(_size)){
+    case 16:  return SmallObjectAllocator::GetPool<16>().Allocate();
+    case 32:  return SmallObjectAllocator::GetPool<32>().Allocate();
+    case 64:  return SmallObjectAllocator::GetPool<64>().Allocate();
+    case 128: return SmallObjectAllocator::GetPool<128>().Allocate();
+    default:  return SmallObjectAllocator::GetPool<256>().Allocate();
+  }
+}
+
+void SmallObjectMemoryResource::do_deallocate(void* _block, std::size_t _size, std::size_t _alignment)
+{
+  if(!SmallObjectAllocator::Fits(_size, _alignment)){
+    ::operator delete(_block, std::align_val_t(_alignment));
+    return;
+  }
+
+  switch(SmallObjectAllocator::SizeClass(_size)){
+    case 16:  SmallObjectAllocator::GetPool<16>().Deallocate(static_cast<SizeClassBlock<16>*>(_block));   break;
+    case 32:  SmallObjectAllocator::GetPool<32>().Deallocate(static_cast<SizeClassBlock<32>*>(_block));   break;
+    case 64:  SmallObjectAllocator::GetPool<64>().Deallocate(static_cast<SizeClassBlock<64>*>(_block));   break;
+    case 128: SmallObjectAllocator::GetPool<128>().Deallocate(static_cast<SizeClassBlock<128>*>(_block)); break;
+    default:  SmallObjectAllocator::GetPool<256>().Deallocate(static_cast<SizeClassBlock<256>*>(_block)); break;
+  }
+}
+
+FrameMemoryResource& FrameMemoryResource::GetInstance()
+{
+  static FrameMemoryResource instance;
+  return instance;
+}
@@ -0,0 +1,56 @@
+#include "Core/Memory/PageAllocator.hpp"
+#include "Core/Logging/LogManager.hpp"
+
+#include <cstdint>
+#include <new>
+
+#ifdef PLATFORM_LINUX
+  #include <sys/mman.h>
+#endif
+
+void* PageAllocator::Allocate(std::size_t _size, std::size_t _alignment, B8 _hugePages)
+{
+#ifdef PLATFORM_LINUX
+  if(_hugePages){
+    std::size_t size = RoundToHugePages(_size);
+
+    // Map an extra huge page, so the block can start on a huge page boundary
+    void* mapping = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED)
+      return nullptr;
+
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(mapping);
+    std::uintptr_t block = (start + HUGE_PAGE_SIZE - 1) & ~std::uintptr_t(HUGE_PAGE_SIZE - 1);
+
+    // Unmap the unaligned head and the unused tail
+    if(block > start)
+      munmap(mapping, block - start);
+    std::size_t tail = (start + size + HUGE_PAGE_SIZE) - (block + size);
+    if(tail > 0)
+      munmap(reinterpret_cast<void*>(block + size), tail);
+
+    if(madvise(reinterpret_cast<void*>(block), size, MADV_HUGEPAGE) != 0)
+      LDEBUG("Transparent huge pages unavailable, using regular pages for %zu bytes", size);
+
+    return reinterpret_cast<void*>(block);
+  }
+#endif
+
+  return ::operator new(_size, std::align_val_t(_alignment), std::nothrow);
+}
+
+void PageAllocator::Free(void* _block, std::size_t _size, std::size_t _alignment, B8 _hugePages)
+{
+  if(_block == nullptr)
+    return;
+
+#ifdef PLATFORM_LINUX
+  if(_hugePages){
+    munmap(_block, RoundToHugePages(_size));
+    return;
+  }
+#endif
+
+  ::operator delete(_block, std::align_val_t(_alignment));
+}
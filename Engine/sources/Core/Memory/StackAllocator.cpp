@@ -0,0 +1,95 @@
+#include "Core/Memory/StackAllocator.hpp"
+#include "Core/Logging/LogManager.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+StackAllocator::StackAllocator(std::size_t _size)
+  : m_buffer(nullptr), m_size(_size), m_bottom(0), m_top(_size)
+{
+  m_buffer = static_cast<U8*>(std::malloc(m_size));
+  if(m_buffer == nullptr)
+    throw std::bad_alloc();
+}
+
+StackAllocator::~StackAllocator()
+{
+  std::free(m_buffer);
+}
+
+void* StackAllocator::Allocate(std::size_t _size,
+                               std::size_t _alignment,
+                               StackEnd _end)
+{
+  std::uintptr_t base = reinterpret_cast<std::uintptr_t>(m_buffer);
+  std::uintptr_t mask = ~(std::uintptr_t(_alignment) - 1);
+
+  if(_end == STACK_END_BOTTOM){
+    // Align the start of the block up
+    std::uintptr_t start = (base + m_bottom + (_alignment - 1)) & mask;
+    if(start + _size > base + m_top){
+      LERROR("Stack allocator out of memory, %zu bytes requested with %zu free", _size, GetFree());
+      throw std::bad_alloc();
+    }
+
+    m_bottom = start + _size - base;
+    return reinterpret_cast<void*>(start);
+  }
+
+  // Top end grows downwards, so align the start of the block down
+  if(_size > m_top){
+    LERROR("Stack allocator out of memory, %zu bytes requested with %zu free", _size, GetFree());
+    throw std::bad_alloc();
+  }
+  std::uintptr_t start = (base + m_top - _size) & mask;
+  if(start < base + m_bottom){
+    LERROR("Stack allocator out of memory, %zu bytes requested with %zu free", _size, GetFree());
+    throw std::bad_alloc();
+  }
+
+  m_top = start - base;
+  return reinterpret_cast<void*>(start);
+}
+
+StackAllocator::Marker StackAllocator::GetMarker(StackEnd _end) const
+{
+  return _end == STACK_END_BOTTOM ? m_bottom : m_top;
+}
+
+void StackAllocator::FreeToMarker(Marker _marker, StackEnd _end)
+{
+  if(_end == STACK_END_BOTTOM){
+    // Rolling forwards would hand out memory that is still in use
+    if(_marker > m_bottom){
+      LERROR("Stack allocator marker %zu is past the bottom end at %zu", _marker, m_bottom);
+      return;
+    }
+    m_bottom = _marker;
+  }
+  else{
+    if(_marker < m_top || _marker > m_size){
+      LERROR("Stack allocator marker %zu is past the top end at %zu", _marker, m_top);
+      return;
+    }
+    m_top = _marker;
+  }
+}
+
+void StackAllocator::Clear(StackEnd _end)
+{
+  if(_end == STACK_END_BOTTOM)
+    m_bottom = 0;
+  else
+    m_top = m_size;
+}
+
+void StackAllocator::Clear()
+{
+  Clear(STACK_END_BOTTOM);
+  Clear(STACK_END_TOP);
+}
+
+std::size_t StackAllocator::GetUsed(StackEnd _end) const
+{
+  return _end == STACK_END_BOTTOM ? m_bottom : m_size - m_top;
+}
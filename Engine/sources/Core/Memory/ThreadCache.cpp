@@ -0,0 +1,66 @@
+#include "Core/Memory/ThreadCache.hpp"
+
+ThreadCacheRegistry& ThreadCacheRegistry::GetInstance()
+{
+  static ThreadCacheRegistry instance;
+  return instance;
+}
+
+ThreadCacheRegistry::CountersOwner::~CountersOwner()
+{
+  if(m_counters != nullptr)
+    ThreadCacheRegistry::GetInstance().ReleaseCounters(*m_counters);
+  m_counters = nullptr;
+}
+
+ThreadCacheCounters& ThreadCacheRegistry::GetCounters()
+{
+  static thread_local CountersOwner owner;
+  if(owner.m_counters == nullptr)
+    owner.m_counters = &AcquireCounters();
+  return *owner.m_counters;
+}
+
+ThreadCacheCounters& ThreadCacheRegistry::AcquireCounters()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  ThreadCacheCounters* counters = nullptr;
+  for(ThreadCacheCounters& unused : m_counters){
+    if(!unused.m_inUse){
+      counters = &unused;
+      break;
+    }
+  }
+  if(counters == nullptr)
+    counters = &m_counters.emplace_back();
+
+  // The counts are per thread, start over
+  counters->m_threadId = std::this_thread::get_id();
+  counters->m_hits.store(0, std::memory_order_relaxed);
+  counters->m_misses.store(0, std::memory_order_relaxed);
+  counters->m_inUse = true;
+  return *counters;
+}
+
+void ThreadCacheRegistry::ReleaseCounters(ThreadCacheCounters& _counters)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  _counters.m_inUse = false;
+}
+
+std::vector<ThreadCacheStats> ThreadCacheRegistry::GetStats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  std::vector<ThreadCacheStats> stats;
+  stats.reserve(m_counters.size());
+  for(const ThreadCacheCounters& counters : m_counters){
+    if(!counters.m_inUse)
+      continue;
+    stats.push_back({counters.m_threadId,
+                     counters.m_hits.load(std::memory_order_relaxed),
+                     counters.m_misses.load(std::memory_order_relaxed)});
+  }
+  return stats;
+}
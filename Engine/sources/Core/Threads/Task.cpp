@@ -31,12 +31,12 @@ namespace psge
 
   void Task::AddDependant(TaskPtr _dependant)
   {
-    m_dependents.push_back(_dependant);
+    m_dependents.PushBack(std::move(_dependant));
   }
 
   void Task::AddDependency(TaskPtr _dependency)
   {
-    m_dependencies.push_back(_dependency);
+    m_dependencies.PushBack(_dependency);
     _dependency->AddDependant(shared_from_this());
     m_dependenciesCount++;
   }
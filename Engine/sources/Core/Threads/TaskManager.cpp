@@ -1,20 +1,66 @@
 #include "Core/Threads/TaskManager.hpp"
+#include "Core/Memory/MemoryResource.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+/// Index of the calling thread's deque, or NOT_A_WORKER outside the pool
+constexpr U32 NOT_A_WORKER = std::numeric_limits<U32>::max();
+thread_local U32 t_workerIndex = NOT_A_WORKER;
+
+/// Number of tasks the calling thread is running, nested when it runs
+/// queued tasks while scheduling
+thread_local U32 t_runningTasks = 0;
+
+/// State of the calling thread's victim picker
+thread_local U32 t_victimState = 0;
+
+/// Rounds a worker looks for tasks before going to sleep
+constexpr U32 IDLE_ROUNDS = 64;
+
+/// True once a task and everything depending on it have run
+bool IsFinished(const psge::Task& _task)
+{
+  if(!_task.m_executed.load())
+    return false;
+  for(const auto& dependent : _task.m_dependents){
+    if(!IsFinished(*dependent))
+      return false;
+  }
+  return true;
+}
+
+/// Xorshift step picking the first victim to steal from
+U32 NextVictim(U32 _count)
+{
+  if(t_victimState == 0)
+    t_victimState = 2463534242u ^ (t_workerIndex + 1);
+  t_victimState ^= t_victimState << 13;
+  t_victimState ^= t_victimState >> 17;
+  t_victimState ^= t_victimState << 5;
+  return t_victimState % _count;
+}
+}
 
 namespace psge
 {
 
 TaskManager::TaskManager()
+  : m_injected(TASK_INJECTION_CAPACITY),
+    m_tasks(&SmallObjectMemoryResource::GetInstance())
 {
 }
 
 TaskManager::~TaskManager()
 {
-  // Lock the queue and issue stop
+  // Issue stop and wake everyone up to see it
+  m_shouldStop = true;
   {
-    std::unique_lock<std::mutex> lock(m_queueMutex);
-    m_shouldStop = true;
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_wakeCondition.notify_all();
   }
-  m_condition.notify_all();
 
   // Join the worker threads
   for(std::thread& thread : m_threads){
@@ -30,111 +76,237 @@ TaskManager& TaskManager::GetInstance()
 
 void TaskManager::Initialize(U8 _numThreads)
 {
+  if(!m_threads.empty()){
+    LWARN("The task manager is already initialized with %i threads", m_numThreads);
+    return;
+  }
+
   m_numThreads = _numThreads;
+
+  // Every deque has to exist before any worker starts stealing
+  for(U8 idx = 0; idx < m_numThreads; ++idx)
+    m_queues.push_back(std::make_unique<WorkerQueue>());
+
   for(U8 idx = 0; idx < m_numThreads; ++idx){
-    m_threads.emplace_back([this](){
-      while(true){
-        // Get the next task
-        TaskPtr task = GetNextTask();
-
-        // Break if no tasks left
-        if(!task)
-          break;
-
-        // Break if task was already executed
-        if(task->IsComplete())
-          break;
-
-        // Execute the task
-        task->Execute();
-      }
+    m_threads.emplace_back([this, idx](){
+      WorkerLoop(idx);
     });
   }
 
   LINFO("Initialized the task manager with %i threads!", _numThreads);
 }
 
-TaskPtr TaskManager::GetNextTask()
+void TaskManager::WorkerLoop(U32 _index)
 {
-  // Lock the thread
-  std::unique_lock<std::mutex> lock(m_queueMutex);
-  m_condition.wait(lock, [this](){
-    return m_shouldStop || !m_tasks.empty();
-  });
+  t_workerIndex = _index;
 
-  // Return nothing if no tasks left
-  if(m_shouldStop && m_tasks.empty())
-    return nullptr;
-  
-  // Get a task and remove from the queue
-  TaskPtr task = m_tasks.front();
-  if(task->m_dependenciesCount == 0 && !task->IsComplete()){
-    // Remove this task from dependencies of other tasks...
-    for(const TaskPtr& dependent : task->m_dependents){
-      /// @todo should we remove it from the vector too though? :|
-      --dependent->m_dependenciesCount;
+  U32 idleRounds = 0;
+  while(!m_shouldStop.load(std::memory_order_relaxed)){
+    if(Task* task = FindTask(_index)){
+      RunTask(task);
+      idleRounds = 0;
+      continue;
+    }
+
+    if(++idleRounds < IDLE_ROUNDS){
+      std::this_thread::yield();
+      continue;
+    }
+
+    // Count ourselves asleep before looking once more: whoever schedules
+    // a task we miss here sees the count, and bumps the signal to wake us
+    m_sleepingWorkers.fetch_add(1);
+    U64 signal = m_workSignal.load();
+    if(Task* task = FindTask(_index)){
+      m_sleepingWorkers.fetch_sub(1);
+      RunTask(task);
+      idleRounds = 0;
+      continue;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_wakeCondition.wait(lock, [&](){
+        return m_shouldStop.load() || m_workSignal.load() != signal;
+      });
     }
+    m_sleepingWorkers.fetch_sub(1);
+    idleRounds = 0;
   }
+}
+
+Task* TaskManager::FindTask(U32 _index)
+{
+  Task* task = nullptr;
 
-  // Remove this task from our todo list
-  m_tasks.erase(m_tasks.begin());
+  // Newest task of our own first, its data is likely still in cache
+  if(_index < m_queues.size() && m_queues[_index]->TryPop(task))
+    return task;
 
-  // Return the task
-  return std::move(task);
+  if(m_injected.TryPop(task))
+    return task;
+
+  // Oldest task of someone else, starting from a random victim
+  const U32 count = U32(m_queues.size());
+  if(count == 0)
+    return nullptr;
+  U32 first = NextVictim(count);
+  for(U32 offset = 0; offset < count; ++offset){
+    U32 victim = (first + offset) % count;
+    if(victim != _index && m_queues[victim]->TrySteal(task))
+      return task;
+  }
+  return nullptr;
 }
 
-void TaskManager::ResetTasks()
+void TaskManager::Schedule(Task* _task)
+{
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+
+  if(t_workerIndex < m_queues.size()){
+    // The worker runs it itself unless someone steals it first. The push is
+    // sequentially consistent, so either the count below sees a worker about
+    // to sleep, or that worker's last look finds the task.
+    m_queues[t_workerIndex]->Push(_task);
+    if(m_sleepingWorkers.load() > 0)
+      WakeWorkers();
+    return;
+  }
+
+  // Make room by running queued tasks ourselves if the queue is full
+  while(!m_injected.TryPush(_task)){
+    Task* queued = nullptr;
+    if(m_injected.TryPop(queued))
+      RunTask(queued);
+  }
+
+  // The injection queue only publishes with release, so the signal always
+  // moves here: a worker that read it before it moved is woken, one that
+  // read it after sees the task
+  m_workSignal.fetch_add(1);
+  if(m_sleepingWorkers.load() > 0){
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_wakeCondition.notify_all();
+  }
+}
+
+void TaskManager::RunTask(Task* _task)
+{
+  ++t_runningTasks;
+  _task->Execute();
+  --t_runningTasks;
+
+  // Whoever finishes a dependent's last dependency schedules it
+  for(const TaskPtr& dependent : _task->m_dependents){
+    if(dependent->m_dependenciesCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      Schedule(dependent.get());
+  }
+
+  if(m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1){
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_idleCondition.notify_all();
+  }
+}
+
+void TaskManager::WakeWorkers()
+{
+  // Moved under the lock, so a worker checking it before it waits either
+  // sees it moved or is already waiting for the notification
+  std::lock_guard<std::mutex> lock(m_sleepMutex);
+  m_workSignal.fetch_add(1);
+  m_wakeCondition.notify_all();
+}
+
+void TaskManager::Wait()
+{
+  // The calling task is pending itself, it would wait forever
+  if(t_runningTasks > 0){
+    LERROR("Wait() called from inside a task, ignoring it");
+    return;
+  }
+
+  while(m_pending.load(std::memory_order_acquire) > 0){
+    if(Task* task = FindTask(t_workerIndex)){
+      RunTask(task);
+      continue;
+    }
+
+    // Whatever is left is running, or queued on a worker that will run it
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_idleCondition.wait(lock, [this](){
+      return m_pending.load(std::memory_order_acquire) == 0;
+    });
+  }
+}
+
+void TaskManager::RegisterTask(TaskPtr _task)
 {
-  // Lock the threads
   std::unique_lock<std::mutex> lock(m_graphMutex);
+  m_tasks.push_back(std::move(_task));
+}
 
-  // Re-load the dependencies count
-  for(const TaskPtr& task : m_tasks){
-    task->m_dependenciesCount = task->m_dependencies.size();
-    task->m_executed = false;
+void TaskManager::Submit(TaskPtr _task)
+{
+  // A dependent is scheduled by its last dependency instead
+  if(_task->m_dependenciesCount.load() != 0){
+    LWARN("Submitted a task with dependencies, it runs after them instead");
+    return;
   }
+
+  Task* task = _task.get();
+  {
+    std::unique_lock<std::mutex> lock(m_graphMutex);
+    m_submitted.push_back(std::move(_task));
+  }
+  Schedule(task);
 }
 
-void TaskManager::BuildTaskGraph()
+void TaskManager::ResetTasks()
 {
-  // Lock and clear the graph
+  // Lock the threads
   std::unique_lock<std::mutex> lock(m_graphMutex);
-  m_graph.clear();
 
-  // Dependencies per task
+  // Re-load the dependencies count
   for(const TaskPtr& task : m_tasks){
-    m_graph[task] = task->m_dependenciesCount.load();
+    task->m_dependenciesCount = task->m_dependencies.Size();
+    task->m_executed = false;
   }
+
+  // Let go of the one-off tasks that have run, along with their dependents.
+  // Tasks may still be submitted while we are here, so check them all.
+  std::erase_if(m_submitted, [](const TaskPtr& _task){ return IsFinished(*_task); });
 }
 
 void TaskManager::DispatchTasks()
 {
-  std::unique_lock<std::mutex> lock(m_queueMutex);
-
-  // Find all the tasks with no remaining dependencies
-  std::vector<TaskPtr> readyTasks;
-  for(const auto& entry : m_graph){
-    if(entry.second == 0)
-      readyTasks.push_back(entry.first);
+  // Only the tasks with no dependencies, the rest are scheduled as their
+  // dependencies finish. Registered tasks are never removed, so the raw
+  // pointers stay valid once the lock is gone.
+  std::vector<Task*> roots;
+  {
+    std::unique_lock<std::mutex> lock(m_graphMutex);
+    for(const TaskPtr& task : m_tasks){
+      if(task->m_dependenciesCount == 0)
+        roots.push_back(task.get());
+    }
   }
 
-  // Dispatch tasks to the worker threads
-  for(const auto& task : readyTasks){
-    m_tasks.push_back(task);
-  }
-  m_condition.notify_all();
+  // Scheduling can run tasks right here when the injection queue is full,
+  // and those may register or submit tasks themselves
+  for(Task* task : roots)
+    Schedule(task);
 }
 
 void TaskManager::Update(F32 _deltaTime)
 {
+  // Finish the last frame's tasks
+  Wait();
+
   // Reset the task states
   ResetTasks();
 
-  // Build the task graph
-  BuildTaskGraph();
-
   // Dispatch tasks to worker threads
   DispatchTasks();
 }
 
-};
\ No newline at end of file
+};
@@ -47,6 +47,11 @@ void VulkanRenderer::Destroy()
   // Wait for the device to become idle before destroying anything
   vkDeviceWaitIdle(*m_device->GetDevice());
 
+  if (m_frameData) {
+    MEMALLOC().TrackDeallocation(MEMORY_TAG_RENDERER, m_frameData->GetSlotCount() * m_frameData->GetSlotSize());
+    m_frameData.reset();
+  }
+
   LDEBUG("Shutting down Vulkan buffers");
   m_objectVertexBuffer.reset();
   m_objectIndexBuffer.reset();
@@ -252,6 +257,9 @@ B8 VulkanRenderer::EndFrame(F64 _deltaTime)
   }
 
   m_frameNumber++;
+
+  // Recycle the scratch memory of the frame that just left flight
+  m_frameData->NextFrame();
   return true;
 }
 
@@ -305,6 +313,11 @@ B8 VulkanRenderer::Initialize(RendererConfig& _config, Window* _window, std::sha
     return false;
   }
 
+  // One slot of scratch memory for each frame in flight
+  m_frameData = std::make_unique<BufferedFrameAllocator>(_config.m_frameDataSize,
+                                                         m_swapchain->GetMaxFramesInFlight());
+  MEMALLOC().TrackAllocation(MEMORY_TAG_RENDERER, m_frameData->GetSlotCount() * m_frameData->GetSlotSize());
+
   if (!CreateRenderingPipeline()) {
     LFATAL("Failed to create vulkan rendering pipeline!");
     return false;
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <Core/DataStructures/Bitset.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST(BitsetTests, SetTestCount)
+{
+  Bitset bits(1000);
+  EXPECT_EQ(bits.Size(), 1000);
+  EXPECT_TRUE(bits.None());
+  EXPECT_EQ(bits.FindNext(0), 1000);
+
+  bits.Set(0);
+  bits.Set(63);
+  bits.Set(64);
+  bits.Set(999);
+  EXPECT_TRUE(bits.Test(63));
+  EXPECT_FALSE(bits.Test(62));
+  EXPECT_EQ(bits.Count(), 4);
+  EXPECT_EQ(bits.FindNext(1), 63);
+  EXPECT_EQ(bits.FindNext(65), 999);
+
+  std::vector<std::size_t> visited;
+  bits.ForEachSetBit([&](std::size_t _bit) { visited.push_back(_bit); });
+  EXPECT_EQ(visited, (std::vector<std::size_t>{0, 63, 64, 999}));
+
+  bits.Reset(63);
+  bits.Assign(64, false);
+  EXPECT_EQ(bits.Count(), 2);
+
+  // Bits past the size never show up
+  bits.SetAll();
+  EXPECT_EQ(bits.Count(), 1000);
+  bits.Resize(70);
+  EXPECT_EQ(bits.Count(), 70);
+  bits.Resize(200);
+  EXPECT_EQ(bits.Count(), 70);
+  EXPECT_FALSE(bits.Test(150));
+  bits.ResetAll();
+  EXPECT_TRUE(bits.None());
+}
+
+TEST(BitsetTests, MatchesReference)
+{
+  // Random sets of several sizes, so every vector width and tail is hit
+  std::mt19937 random(7);
+  for(std::size_t size : {1, 63, 64, 65, 127, 128, 300, 1024, 4099}){
+    Bitset first(size), second(size);
+    std::vector<B8> a(size), b(size);
+    for(std::size_t i = 0; i < size; ++i){
+      a[i] = random() % 3 == 0;
+      b[i] = random() % 5 == 0;
+      first.Assign(i, a[i]);
+      second.Assign(i, b[i]);
+    }
+
+    Bitset both = first & second;
+    Bitset either = first | second;
+    Bitset only = first;
+    only.AndNot(second);
+
+    std::size_t count = 0, bothCount = 0, eitherCount = 0, onlyCount = 0;
+    for(std::size_t i = 0; i < size; ++i){
+      count += a[i];
+      bothCount += a[i] && b[i];
+      eitherCount += a[i] || b[i];
+      onlyCount += a[i] && !b[i];
+      ASSERT_EQ(both.Test(i), a[i] && b[i]);
+      ASSERT_EQ(either.Test(i), a[i] || b[i]);
+      ASSERT_EQ(only.Test(i), a[i] && !b[i]);
+    }
+    EXPECT_EQ(first.Count(), count) << size;
+    EXPECT_EQ(both.Count(), bothCount) << size;
+    EXPECT_EQ(either.Count(), eitherCount) << size;
+    EXPECT_EQ(only.Count(), onlyCount) << size;
+
+    EXPECT_TRUE(first.ContainsAll(both));
+    EXPECT_TRUE(either.ContainsAll(second));
+    EXPECT_EQ(first.ContainsAll(second), bothCount == std::size_t(std::count(b.begin(), b.end(), true)));
+    EXPECT_EQ(first.Intersects(second), bothCount > 0);
+    EXPECT_FALSE(only.Intersects(second));
+    EXPECT_TRUE((both | only) == first);
+
+    std::size_t visited = 0;
+    either.ForEachSetBit([&](std::size_t _bit) {
+      EXPECT_TRUE(a[_bit] || b[_bit]);
+      ++visited;
+    });
+    EXPECT_EQ(visited, eitherCount);
+  }
+}
+
+TEST(BitsetTests, DifferentSizes)
+{
+  Bitset small(10), large(300);
+  small.Set(3);
+  large.Set(3);
+  large.Set(200);
+
+  EXPECT_TRUE(large.ContainsAll(small));
+  EXPECT_FALSE(small.ContainsAll(large));
+
+  // What doesn't fit is dropped, what isn't there counts as clear
+  Bitset merged = small | large;
+  EXPECT_EQ(merged.Size(), 10);
+  EXPECT_EQ(merged.Count(), 1);
+  large &= small;
+  EXPECT_EQ(large.Count(), 1);
+  EXPECT_TRUE(large.Test(3));
+}
+
+TEST(BitsetTests, MatchSignatures)
+{
+  std::mt19937 random(11);
+  std::vector<FixedBitset<64>> narrow(1003);
+  std::vector<FixedBitset<256>> wide(1003);
+  for(std::size_t i = 0; i < narrow.size(); ++i){
+    for(int bit = 0; bit < 8; ++bit){
+      narrow[i].Set(random() % 16);
+      wide[i].Set(random() % 16 + (bit % 2) * 200);
+    }
+  }
+
+  FixedBitset<64> narrowQuery;
+  narrowQuery.Set(1);
+  narrowQuery.Set(5);
+  FixedBitset<256> wideQuery;
+  wideQuery.Set(2);
+  wideQuery.Set(207);
+
+  std::vector<U32> matches(narrow.size());
+  std::size_t count = MatchSignatures(narrow.data(), narrow.size(), narrowQuery, matches.data());
+  std::size_t expected = 0;
+  for(std::size_t i = 0; i < narrow.size(); ++i){
+    if(narrow[i].Test(1) && narrow[i].Test(5)){
+      ASSERT_LT(expected, count);
+      EXPECT_EQ(matches[expected++], i);
+    }
+  }
+  EXPECT_EQ(count, expected);
+  EXPECT_GT(count, 0);
+
+  count = MatchSignatures(wide.data(), wide.size(), wideQuery, matches.data());
+  expected = 0;
+  for(std::size_t i = 0; i < wide.size(); ++i){
+    if(wide[i].ContainsAll(wideQuery)){
+      ASSERT_LT(expected, count);
+      EXPECT_EQ(matches[expected++], i);
+    }
+  }
+  EXPECT_EQ(count, expected);
+  EXPECT_GT(count, 0);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <Core/DataStructures/FlatHashMap.hpp>
+
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+TEST(FlatHashMapTests, InsertFindErase)
+{
+  FlatHashMap<U32, U32> map;
+  EXPECT_TRUE(map.Empty());
+  EXPECT_EQ(map.Find(1u), map.end());
+  EXPECT_EQ(map.Get(1u), nullptr);
+
+  // Enough entries to grow the table a few times
+  for(U32 i = 0; i < 1000; ++i)
+    EXPECT_TRUE(map.TryEmplace(i, i * 2).second);
+  EXPECT_EQ(map.Size(), 1000);
+  EXPECT_EQ((map.Capacity() % FlatHashMap<U32, U32>::GroupWidth), 0);
+
+  // Adding an existing key keeps the old value
+  auto [it, added] = map.TryEmplace(5u, 0u);
+  EXPECT_FALSE(added);
+  EXPECT_EQ(it->second, 10);
+
+  for(U32 i = 0; i < 1000; ++i){
+    ASSERT_NE(map.Get(i), nullptr);
+    EXPECT_EQ(*map.Get(i), i * 2);
+  }
+  EXPECT_FALSE(map.Contains(1000u));
+
+  // Keys of another integer type are converted
+  EXPECT_TRUE(map.Contains(7));
+  map[2000] = 1;
+  EXPECT_EQ(map[2000u], 1);
+  map.InsertOrAssign(2000, 3u);
+  EXPECT_EQ(map[2000u], 3);
+
+  // Erase every other key, the rest must still be found
+  for(U32 i = 0; i < 1000; i += 2)
+    EXPECT_TRUE(map.Erase(i));
+  EXPECT_FALSE(map.Erase(0u));
+  EXPECT_EQ(map.Size(), 501);
+  for(U32 i = 0; i < 1000; ++i)
+    EXPECT_EQ(map.Contains(i), i % 2 == 1);
+
+  // Iteration sees every entry once
+  U64 sum = 0;
+  std::size_t count = 0;
+  for(const auto& [key, value] : map){
+    sum += key;
+    ++count;
+  }
+  EXPECT_EQ(count, map.Size());
+  EXPECT_EQ(sum, 250000 + 2000);
+
+  // Erasing through iterators
+  for(auto entry = map.begin(); entry != map.end();)
+    entry = entry->first < 500 ? map.Erase(entry) : std::next(entry);
+  EXPECT_EQ(map.Size(), 251);
+
+  map.Clear();
+  EXPECT_TRUE(map.Empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(FlatHashMapTests, StringKeys)
+{
+  // Engine strings are looked up without building a String
+  FlatHashMap<String32, int> map;
+  map.TryEmplace(String32("player"), 1);
+  map.TryEmplace("enemy", 2);
+  map["pickup"] = 3;
+
+  EXPECT_EQ(map.Size(), 3);
+  EXPECT_TRUE(map.Contains("player"));
+  EXPECT_TRUE(map.Contains(std::string_view("enemy")));
+  EXPECT_TRUE(map.Contains(String32("pickup")));
+  EXPECT_FALSE(map.Contains("play"));
+  EXPECT_EQ(*map.Get("enemy"), 2);
+  EXPECT_TRUE(map.Erase("enemy"));
+  EXPECT_FALSE(map.Contains("enemy"));
+
+  FlatHashMap<std::string, int> stdMap;
+  stdMap["renderer"] = 4;
+  EXPECT_EQ(*stdMap.Get("renderer"), 4);
+  EXPECT_EQ(*stdMap.Get(std::string_view("renderer")), 4);
+}
+
+TEST(FlatHashMapTests, OwnershipAndCopies)
+{
+  // Entries are destroyed on erase, clear and destruction, and moved on
+  // growth
+  auto value = std::make_shared<int>(1);
+  {
+    FlatHashMap<int, std::shared_ptr<int>> map;
+    for(int i = 0; i < 100; ++i)
+      map.TryEmplace(i, value);
+    EXPECT_EQ(value.use_count(), 101);
+
+    map.Erase(0);
+    EXPECT_EQ(value.use_count(), 100);
+
+    FlatHashMap<int, std::shared_ptr<int>> copy(map);
+    EXPECT_EQ(value.use_count(), 199);
+    EXPECT_EQ(copy.Size(), 99);
+
+    FlatHashMap<int, std::shared_ptr<int>> moved(std::move(copy));
+    EXPECT_EQ(value.use_count(), 199);
+    EXPECT_TRUE(copy.Empty());
+
+    moved.Clear();
+    EXPECT_EQ(value.use_count(), 100);
+  }
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(FlatHashMapTests, MatchesUnorderedMap)
+{
+  // Random inserts and erases, checked against std::unordered_map, so
+  // tombstones pile up and get cleaned by rehashing
+  std::mt19937 random(1234);
+  FlatHashMap<U64, U64> map;
+  std::unordered_map<U64, U64> reference;
+
+  for(int i = 0; i < 200000; ++i){
+    U64 key = random() % 5000;
+    if(random() % 3 == 0){
+      EXPECT_EQ(map.Erase(key), reference.erase(key) == 1);
+    }
+    else{
+      map[key] = i;
+      reference[key] = i;
+    }
+  }
+
+  ASSERT_EQ(map.Size(), reference.size());
+  for(const auto& [key, value] : reference){
+    ASSERT_NE(map.Get(key), nullptr);
+    EXPECT_EQ(*map.Get(key), value);
+  }
+}
@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include <Core/Memory/Allocator.hpp>
 
+#include <list>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 struct Datum
 {
   double  a;
@@ -89,3 +95,740 @@ TEST(MemoryManagerTests, MemoryManager)
   EXPECT_EQ(MEMALLOC().GetAllocationCount<BigData>(), 0);
   EXPECT_EQ(MEMALLOC().GetAllocationCount<double>(), 0);
 }
+
+TEST(MemoryManagerTests, PoolAllocatorGrowth)
+{
+  PoolAllocator<Datum> allocator(16);
+  EXPECT_EQ(allocator.GetChunkCount(), 1);
+
+  // Allocate well past the first chunk, the pool should grow instead of throwing
+  std::vector<Datum*> data;
+  for(int i = 0; i < 100; ++i){
+    Datum* datum = allocator.Allocate();
+    datum->c = i;
+    data.push_back(datum);
+  }
+
+  EXPECT_EQ(allocator.GetAllocationCount(), 100);
+  EXPECT_EQ(allocator.GetChunkCount(), 7);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), 7 * 16 - 100);
+
+  // Growing must not move live objects
+  for(int i = 0; i < 100; ++i)
+    EXPECT_EQ(data[i]->c, i);
+
+  // Nothing to release while every chunk holds live objects
+  EXPECT_EQ(allocator.Trim(), 0);
+
+  // Free the last 68 objects, which empties the last five chunks
+  for(int i = 32; i < 100; ++i)
+    allocator.Deallocate(data[i]);
+
+  EXPECT_EQ(allocator.Trim(), 5);
+  EXPECT_EQ(allocator.GetChunkCount(), 2);
+  EXPECT_EQ(allocator.GetAllocationCount(), 32);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), 0);
+
+  for(int i = 0; i < 32; ++i){
+    EXPECT_EQ(data[i]->c, i);
+    allocator.Deallocate(data[i]);
+  }
+
+  // The first chunk is always kept
+  EXPECT_EQ(allocator.Trim(), 1);
+  EXPECT_EQ(allocator.GetChunkCount(), 1);
+  EXPECT_EQ(allocator.GetAllocationCount(), 0);
+}
+
+TEST(MemoryManagerTests, PoolAllocatorMultithreaded)
+{
+  PoolAllocator<Datum> allocator(64);
+
+  // Several threads allocating and freeing at once must never hand out the
+  // same block twice
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 4; ++t){
+    threads.emplace_back([&allocator, t](){
+      std::vector<Datum*> data;
+      for(int round = 0; round < 100; ++round){
+        for(int i = 0; i < 50; ++i){
+          Datum* datum = allocator.Allocate();
+          datum->c = t * 1000 + i;
+          data.push_back(datum);
+        }
+        for(int i = 0; i < 50; ++i){
+          EXPECT_EQ(data[i]->c, t * 1000 + i);
+          allocator.Deallocate(data[i]);
+        }
+        data.clear();
+      }
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(allocator.GetAllocationCount(), 0);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), allocator.GetChunkCount() * 64);
+}
+
+TEST(MemoryManagerTests, PoolAllocatorSmallType)
+{
+  // Blocks smaller than a pointer still have to hold the free-list link
+  PoolAllocator<char> allocator(8);
+  std::vector<char*> data;
+  for(int i = 0; i < 20; ++i){
+    data.push_back(allocator.Allocate());
+    *data.back() = static_cast<char>(i);
+  }
+  for(int i = 0; i < 20; ++i){
+    EXPECT_EQ(*data[i], static_cast<char>(i));
+    allocator.Deallocate(data[i]);
+  }
+  EXPECT_EQ(allocator.GetAllocationCount(), 0);
+}
+
+struct CachedDatum
+{
+  double a;
+  int    b;
+};
+
+TEST(MemoryManagerTests, ThreadCache)
+{
+  // One miss refills half of the cache, the rest of those are hits
+  using Block = SizeClassBlock<SmallObjectAllocator::SizeClass(sizeof(CachedDatum))>;
+  constexpr std::size_t half = PoolTraits<Block>::ThreadCacheSize / 2;
+
+  auto countsForThisThread = [](){
+    for(const ThreadCacheStats& stats : MEMALLOC().GetThreadCacheStats())
+      if(stats.m_threadId == std::this_thread::get_id())
+        return stats;
+    return ThreadCacheStats{std::this_thread::get_id(), 0, 0};
+  };
+
+  std::thread worker([&](){
+    ThreadCacheStats before = countsForThisThread();
+
+    std::vector<CachedDatum*> data;
+    for(std::size_t i = 0; i < half; ++i)
+      data.push_back(MEMALLOC().Allocate<CachedDatum>());
+
+    ThreadCacheStats after = countsForThisThread();
+    EXPECT_EQ(after.m_misses - before.m_misses, 1);
+    EXPECT_EQ(after.m_hits - before.m_hits, half - 1);
+
+    for(CachedDatum* datum : data)
+      MEMALLOC().Deallocate<CachedDatum>(datum);
+
+    // Freed blocks are reused by the next allocation without a miss
+    CachedDatum* datum = MEMALLOC().Allocate<CachedDatum>();
+    EXPECT_EQ(countsForThisThread().m_misses, after.m_misses);
+    MEMALLOC().Deallocate<CachedDatum>(datum);
+
+    EXPECT_EQ(MEMALLOC().GetAllocationCount<CachedDatum>(), 0);
+  });
+  std::thread::id workerId = worker.get_id();
+  worker.join();
+
+  // Exited threads are dropped, their counters go to the next thread
+  std::size_t threads = MEMALLOC().GetThreadCacheStats().size();
+  for(const ThreadCacheStats& stats : MEMALLOC().GetThreadCacheStats())
+    EXPECT_NE(stats.m_threadId, workerId);
+  for(int i = 0; i < 10; ++i){
+    std::thread([](){
+      MEMALLOC().Deallocate<CachedDatum>(MEMALLOC().Allocate<CachedDatum>());
+    }).join();
+  }
+  EXPECT_EQ(MEMALLOC().GetThreadCacheStats().size(), threads);
+}
+
+TEST(MemoryManagerTests, LinearAllocator)
+{
+  alignas(64) unsigned char buffer[256];
+  LinearAllocator arena(buffer, sizeof(buffer));
+
+  void* a = arena.Allocate(3, 1);
+  void* b = arena.Allocate(8, 8);
+  EXPECT_EQ(a, buffer);
+  EXPECT_EQ(b, buffer + 8);
+  EXPECT_EQ(arena.GetUsed(), 16);
+
+  // Doesn't fit anymore
+  EXPECT_EQ(arena.Allocate(512), nullptr);
+
+  arena.Reset();
+  EXPECT_EQ(arena.GetUsed(), 0);
+  EXPECT_EQ(arena.Allocate(3, 1), buffer);
+}
+
+TEST(MemoryManagerTests, FrameAllocator)
+{
+  FRAMEALLOC().NextFrame();
+  Datum* first = FRAMEALLOC().New<Datum>();
+  first->c = 5;
+  BigData* array = FRAMEALLOC().Allocate<BigData>(10);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array) % alignof(BigData), 0);
+  EXPECT_EQ(first->c, 5);
+
+  // The next frame hands out the same memory again
+  FRAMEALLOC().NextFrame();
+  EXPECT_EQ(FRAMEALLOC().New<Datum>(), first);
+  EXPECT_GE(FRAMEALLOC().GetHighWaterMark(), sizeof(Datum) + 10 * sizeof(BigData));
+
+  // Each thread has a region of its own
+  Datum* other = nullptr;
+  std::thread worker([&other](){ other = FRAMEALLOC().New<Datum>(); });
+  worker.join();
+  EXPECT_NE(other, nullptr);
+  EXPECT_NE(other, first);
+
+  // An exited thread's region goes to the next thread instead of piling up
+  std::vector<Datum*> reused;
+  for(int i = 0; i < 10; ++i){
+    FRAMEALLOC().NextFrame();
+    std::thread([&reused](){ reused.push_back(FRAMEALLOC().New<Datum>()); }).join();
+  }
+  for(Datum* datum : reused)
+    EXPECT_EQ(datum, reused.front());
+
+  // Running out of the region falls back to the heap instead of failing
+  std::size_t size = FRAMEALLOC().GetRegionSize();
+  void* big = FRAMEALLOC().Allocate(2 * size);
+  EXPECT_NE(big, nullptr);
+  EXPECT_GE(FRAMEALLOC().GetHighWaterMark(), 2 * size);
+
+  // Frame-lifetime scratch containers
+  std::vector<int, FrameStdAllocator<int>> scratch;
+  for(int i = 0; i < 100; ++i)
+    scratch.push_back(i);
+  EXPECT_EQ(scratch[99], 99);
+  FRAMEALLOC().NextFrame();
+}
+
+TEST(MemoryManagerTests, BufferedFrameAllocator)
+{
+  BufferedFrameAllocator arena(1024, 2);
+  EXPECT_EQ(arena.GetSlotCount(), 2);
+
+  // Written in frame N...
+  Datum* datum = arena.New<Datum>();
+  datum->c = 42;
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(datum) % alignof(Datum), 0);
+
+  // ...still readable in frame N+1, while new data goes to the other slot
+  arena.NextFrame();
+  Datum* next = arena.New<Datum>();
+  next->c = 7;
+  EXPECT_EQ(datum->c, 42);
+  EXPECT_NE(datum, next);
+
+  // Frame N+2 reuses frame N's memory
+  arena.NextFrame();
+  EXPECT_EQ(arena.New<Datum>(), datum);
+  EXPECT_EQ(next->c, 7);
+
+  // Running out of a slot falls back to the heap
+  EXPECT_NE(arena.Allocate(4096), nullptr);
+  EXPECT_GE(arena.GetHighWaterMark(), 4096);
+
+  // One slot per frame in flight
+  BufferedFrameAllocator tripleBuffered(256, 3);
+  Datum* first = tripleBuffered.New<Datum>();
+  tripleBuffered.NextFrame();
+  tripleBuffered.NextFrame();
+  EXPECT_NE(tripleBuffered.New<Datum>(), first);
+  tripleBuffered.NextFrame();
+  EXPECT_EQ(tripleBuffered.New<Datum>(), first);
+}
+
+TEST(MemoryManagerTests, StackAllocator)
+{
+  StackAllocator stack(1024);
+  EXPECT_EQ(stack.GetFree(), 1024);
+
+  // Long-lived data at the bottom
+  Datum* level = stack.New<Datum>();
+  level->c = 1;
+  StackAllocator::Marker afterLevel = stack.GetMarker();
+
+  double* temp = stack.Allocate<double>(10);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(temp) % alignof(double), 0);
+  EXPECT_GT(stack.GetUsed(STACK_END_BOTTOM), afterLevel);
+
+  // Rolling back frees everything after the marker
+  stack.FreeToMarker(afterLevel);
+  EXPECT_EQ(stack.GetUsed(STACK_END_BOTTOM), afterLevel);
+  EXPECT_EQ(stack.Allocate<double>(10), temp);
+  stack.FreeToMarker(afterLevel);
+
+  // Temporary buffers at the top, freed when the scope ends
+  {
+    StackScope scope(stack, STACK_END_TOP);
+    BigData* scratch = stack.Allocate<BigData>(4, STACK_END_TOP);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(scratch) % alignof(BigData), 0);
+    EXPECT_GE(stack.GetUsed(STACK_END_TOP), 4 * sizeof(BigData));
+    EXPECT_GT(reinterpret_cast<std::uintptr_t>(scratch), reinterpret_cast<std::uintptr_t>(level));
+  }
+  EXPECT_EQ(stack.GetUsed(STACK_END_TOP), 0);
+  EXPECT_EQ(level->c, 1);
+
+  // The two ends must not overlap
+  stack.Allocate(stack.GetFree() / 2, 1, STACK_END_TOP);
+  EXPECT_THROW(stack.Allocate(stack.GetFree() + 1), std::bad_alloc);
+  EXPECT_NO_THROW(stack.Allocate(stack.GetFree(), 1));
+  EXPECT_EQ(stack.GetFree(), 0);
+
+  stack.Clear();
+  EXPECT_EQ(stack.GetFree(), 1024);
+}
+
+struct OddSized
+{
+  int a[5];
+};
+
+struct alignas(64) CacheLinePadded
+{
+  int a;
+};
+
+struct Counter
+{
+  int a;
+};
+
+struct Vec4
+{
+  float v[4];
+};
+
+struct Particle
+{
+  float x, y, z;
+};
+
+template <>
+struct PoolTraits<Counter> : DefaultPoolTraits<Counter>
+{
+  static constexpr B8 PadToCacheLine = true;
+};
+
+template <>
+struct PoolTraits<Vec4> : DefaultPoolTraits<Vec4>
+{
+  static constexpr std::size_t Alignment = 32;
+};
+
+template <>
+struct PoolTraits<Particle> : DefaultPoolTraits<Particle>
+{
+  static constexpr B8 UseHugePages = true;
+};
+
+TEST(MemoryManagerTests, PoolAllocatorLayout)
+{
+  // Over-aligned types
+  PoolAllocator<CacheLinePadded> padded(4);
+  for(int i = 0; i < 8; ++i)
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(padded.Allocate()) % 64, 0);
+
+  // Alignment set through the traits
+  PoolAllocator<Vec4> vectors(4);
+  EXPECT_EQ(PoolAllocator<Vec4>::BlockAlignment, 32);
+  for(int i = 0; i < 8; ++i)
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(vectors.Allocate()) % 32, 0);
+
+  // Every counter gets a cache line of its own
+  PoolAllocator<Counter> counters;
+  EXPECT_EQ(PoolAllocator<Counter>::BlockSize, 64);
+  Counter* first = counters.Allocate();
+  Counter* second = counters.Allocate();
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0);
+  EXPECT_GE(reinterpret_cast<std::uintptr_t>(second) - reinterpret_cast<std::uintptr_t>(first), 64);
+
+  // Huge-page chunks fill whole huge pages
+  PoolAllocator<Particle> particles(1000);
+  EXPECT_EQ(particles.GetChunkSize(), HUGE_PAGE_SIZE / PoolAllocator<Particle>::BlockSize);
+  std::vector<Particle*> live;
+  for(std::size_t i = 0; i < particles.GetChunkSize() + 1; ++i){
+    live.push_back(particles.Allocate());
+    live.back()->x = float(i);
+  }
+  EXPECT_EQ(particles.GetChunkCount(), 2);
+  for(Particle* particle : live)
+    particles.Deallocate(particle);
+  EXPECT_EQ(particles.Trim(), 1);
+
+  // The MemoryManager keeps the traits too, rather than sending these small
+  // types to the shared size classes
+  EXPECT_FALSE(MemoryManager::UsesSizeClass<Counter>());
+  EXPECT_FALSE(MemoryManager::UsesSizeClass<Vec4>());
+  EXPECT_FALSE(MemoryManager::UsesSizeClass<Particle>());
+
+  Counter* managedFirst = MEMALLOC().Allocate<Counter>();
+  Counter* managedSecond = MEMALLOC().Allocate<Counter>();
+  std::uintptr_t a = reinterpret_cast<std::uintptr_t>(managedFirst);
+  std::uintptr_t b = reinterpret_cast<std::uintptr_t>(managedSecond);
+  EXPECT_EQ(a % 64, 0);
+  EXPECT_EQ(b % 64, 0);
+  EXPECT_GE(a > b ? a - b : b - a, 64);
+  MEMALLOC().Deallocate(managedFirst);
+  MEMALLOC().Deallocate(managedSecond);
+
+  Vec4* managedVectors[8];
+  for(Vec4*& vector : managedVectors){
+    vector = MEMALLOC().Allocate<Vec4>();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(vector) % 32, 0);
+  }
+  for(Vec4* vector : managedVectors)
+    MEMALLOC().Deallocate(vector);
+}
+
+TEST(MemoryManagerTests, SmallObjectAllocator)
+{
+  EXPECT_EQ(SmallObjectAllocator::SizeClass(1), 16);
+  EXPECT_EQ(SmallObjectAllocator::SizeClass(16), 16);
+  EXPECT_EQ(SmallObjectAllocator::SizeClass(17), 32);
+  EXPECT_EQ(SmallObjectAllocator::SizeClass(200), 256);
+
+  // Different types of a similar size share one pool
+  static_assert(SmallObjectAllocator::SizeClass(sizeof(Datum)) == SmallObjectAllocator::SizeClass(sizeof(OddSized)));
+  EXPECT_TRUE(MemoryManager::UsesSizeClass<Datum>());
+  EXPECT_FALSE(MemoryManager::UsesSizeClass<CacheLinePadded>());
+
+  Datum* datum = MEMALLOC().Allocate<Datum>();
+  OddSized* odd = MEMALLOC().Allocate<OddSized>();
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(datum) % alignof(Datum), 0);
+
+  // Both come from the same pool
+  auto& pool = SmallObjectAllocator::GetPool<sizeof(Datum)>();
+  EXPECT_EQ(&pool, &SmallObjectAllocator::GetPool<sizeof(OddSized)>());
+  EXPECT_GE(pool.GetAllocationCount(), 2);
+
+  // A freed block of one type is reused by the other
+  MEMALLOC().Deallocate<Datum>(datum);
+  EXPECT_EQ(static_cast<void*>(MEMALLOC().Allocate<OddSized>()), static_cast<void*>(datum));
+  MEMALLOC().Deallocate<OddSized>(reinterpret_cast<OddSized*>(datum));
+  MEMALLOC().Deallocate<OddSized>(odd);
+
+  // Over-aligned types keep a pool of their own
+  CacheLinePadded* padded = MEMALLOC().Allocate<CacheLinePadded>();
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(padded) % alignof(CacheLinePadded), 0);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<CacheLinePadded>(), 1);
+  MEMALLOC().Deallocate<CacheLinePadded>(padded);
+
+  // Sizes only known at run time
+  void* small = SmallObjectAllocator::Allocate(100);
+  void* large = SmallObjectAllocator::Allocate(4096);
+  EXPECT_NE(small, nullptr);
+  EXPECT_NE(large, nullptr);
+  SmallObjectAllocator::Deallocate(small, 100);
+  SmallObjectAllocator::Deallocate(large, 4096);
+}
+
+struct Tracked
+{
+  static int m_alive;
+
+  Tracked(int _value, std::string _name)
+    : m_value(_value), m_name(std::move(_name))
+  {
+    ++m_alive;
+  }
+
+  ~Tracked()
+  {
+    --m_alive;
+  }
+
+  int m_value;
+  std::string m_name;
+};
+
+int Tracked::m_alive = 0;
+
+TEST(MemoryManagerTests, CreateDestroy)
+{
+  // Constructed in place with the forwarded arguments
+  Tracked* tracked = MEMALLOC().Create<Tracked>(5, "five");
+  EXPECT_EQ(tracked->m_value, 5);
+  EXPECT_EQ(tracked->m_name, "five");
+  EXPECT_EQ(Tracked::m_alive, 1);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<Tracked>(), 1);
+
+  // Destroy runs the destructor before giving the memory back
+  MEMALLOC().Destroy(tracked);
+  EXPECT_EQ(Tracked::m_alive, 0);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<Tracked>(), 0);
+
+  {
+    PoolPtr<Tracked> owner = MakePooled<Tracked>(6, "six");
+    EXPECT_EQ(owner->m_value, 6);
+    EXPECT_EQ(Tracked::m_alive, 1);
+
+    // Ownership moves, the object doesn't
+    Tracked* raw = owner.Get();
+    PoolPtr<Tracked> other = std::move(owner);
+    EXPECT_FALSE(owner);
+    EXPECT_EQ(other.Get(), raw);
+
+    other.Reset(MEMALLOC().Create<Tracked>(7, "seven"));
+    EXPECT_EQ(Tracked::m_alive, 1);
+    EXPECT_EQ(other->m_value, 7);
+  }
+  EXPECT_EQ(Tracked::m_alive, 0);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<Tracked>(), 0);
+}
+
+struct Counted
+{
+  double  a;
+  int     b;
+};
+
+TEST(MemoryManagerTests, AllocationStats)
+{
+  std::vector<Counted*> objects;
+  for(int i = 0; i < 10; ++i)
+    objects.push_back(MEMALLOC().Allocate<Counted>());
+
+  // Peaks are sampled at the end of a frame
+  MEMALLOC().NextFrame();
+  for(int i = 0; i < 4; ++i){
+    MEMALLOC().Deallocate(objects.back());
+    objects.pop_back();
+  }
+
+  auto findCounted = [](){
+    for(const AllocationStats& stats : MEMALLOC().GetAllocationStats()){
+      if(stats.m_typeName == "Counted")
+        return stats;
+    }
+    return AllocationStats{};
+  };
+
+  AllocationStats stats = findCounted();
+  EXPECT_EQ(stats.m_typeSize, sizeof(Counted));
+  EXPECT_EQ(stats.m_liveCount, 6);
+  EXPECT_EQ(stats.m_peakCount, 10);
+  EXPECT_EQ(stats.m_bytes, 6 * sizeof(Counted));
+  EXPECT_EQ(stats.m_allocationsPerFrame, 10);
+  EXPECT_EQ(stats.m_totalAllocations, 10);
+
+  // Every thread counts on its own, the snapshots add them up
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 4; ++t){
+    threads.emplace_back([](){
+      for(int i = 0; i < 1000; ++i)
+        MEMALLOC().Deallocate(MEMALLOC().Allocate<Counted>());
+    });
+  }
+  for(auto& thread : threads)
+    thread.join();
+  MEMALLOC().NextFrame();
+
+  stats = findCounted();
+  EXPECT_EQ(stats.m_liveCount, 6);
+  EXPECT_EQ(stats.m_peakCount, 10);
+  EXPECT_EQ(stats.m_allocationsPerFrame, 4000);
+  EXPECT_EQ(stats.m_totalAllocations, 4010);
+
+  for(Counted* object : objects)
+    MEMALLOC().Deallocate(object);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<Counted>(), 0);
+}
+
+struct AssetDatum
+{
+  static constexpr MemoryTag s_memoryTag = MEMORY_TAG_ASSETS;
+
+  double  a[4];
+};
+
+TEST(MemoryManagerTests, MemoryTags)
+{
+  EXPECT_EQ(MemoryTagTraits<AssetDatum>::Tag, MEMORY_TAG_ASSETS);
+  EXPECT_EQ(MemoryTagTraits<Datum>::Tag, MEMORY_TAG_GENERAL);
+  EXPECT_STREQ(GetMemoryTagName(MEMORY_TAG_ASSETS), "assets");
+
+  MEMALLOC().NextFrame();
+  MemoryTagStats before = MEMALLOC().GetMemoryTagStats()[MEMORY_TAG_ASSETS];
+
+  MEMALLOC().SetBudget(MEMORY_TAG_ASSETS, 2 * sizeof(AssetDatum));
+  EXPECT_EQ(MEMALLOC().GetBudget(MEMORY_TAG_ASSETS), 2 * sizeof(AssetDatum));
+
+  AssetDatum* assets[3];
+  for(AssetDatum*& asset : assets)
+    asset = MEMALLOC().Allocate<AssetDatum>();
+  MEMALLOC().Deallocate(assets[2]);
+
+  // Counted on another thread, which exits and leaves its counters behind
+  std::thread([](){
+    MEMALLOC().Deallocate(MEMALLOC().Allocate<AssetDatum>());
+  }).join();
+
+  // Memory allocated elsewhere counts against the same tag
+  MEMALLOC().TrackAllocation(MEMORY_TAG_ASSETS, 100);
+  MEMALLOC().NextFrame();
+
+  MemoryTagStats stats = MEMALLOC().GetMemoryTagStats()[MEMORY_TAG_ASSETS];
+  EXPECT_EQ(stats.m_tag, MEMORY_TAG_ASSETS);
+  EXPECT_EQ(stats.m_bytes, before.m_bytes + 2 * sizeof(AssetDatum) + 100);
+  EXPECT_GE(stats.m_peakBytes, stats.m_bytes);
+  EXPECT_EQ(stats.m_budget, 2 * sizeof(AssetDatum));
+  EXPECT_EQ(stats.m_allocationsPerFrame, 5);
+  EXPECT_EQ(stats.m_freesPerFrame, 2);
+
+  MEMALLOC().TrackDeallocation(MEMORY_TAG_ASSETS, 100);
+  MEMALLOC().Deallocate(assets[0]);
+  MEMALLOC().Deallocate(assets[1]);
+  MEMALLOC().NextFrame();
+
+  stats = MEMALLOC().GetMemoryTagStats()[MEMORY_TAG_ASSETS];
+  EXPECT_EQ(stats.m_bytes, before.m_bytes);
+  EXPECT_EQ(stats.m_allocationsPerFrame, 0);
+  EXPECT_EQ(stats.m_freesPerFrame, 3);
+
+  MEMALLOC().SetBudget(MEMORY_TAG_ASSETS, 0);
+}
+
+TEST(MemoryManagerTests, MemoryResource)
+{
+  // Nodes come from the size-class pools, big buckets from the heap
+  SmallObjectMemoryResource& smallObjects = SmallObjectMemoryResource::GetInstance();
+  auto& nodePool = SmallObjectAllocator::GetPool<sizeof(void*) * 3>();
+  std::size_t nodesBefore = nodePool.GetAllocationCount();
+  {
+    std::pmr::list<int> list(&smallObjects);
+    for(int i = 0; i < 100; ++i)
+      list.push_back(i);
+    EXPECT_EQ(nodePool.GetAllocationCount(), nodesBefore + 100);
+
+    std::pmr::unordered_map<U32, int> map(&smallObjects);
+    for(U32 i = 0; i < 1000; ++i)
+      map[i] = i;
+    EXPECT_EQ(map[999], 999);
+  }
+  EXPECT_EQ(nodePool.GetAllocationCount(), nodesBefore);
+  EXPECT_TRUE(smallObjects.is_equal(SmallObjectMemoryResource::GetInstance()));
+
+  // Single nodes from the pool, anything else from upstream
+  PoolAllocator<Datum> pool(16);
+  PoolMemoryResource<Datum> poolResource(pool);
+  void* block = poolResource.allocate(sizeof(Datum), alignof(Datum));
+  void* array = poolResource.allocate(10 * sizeof(Datum), alignof(Datum));
+  EXPECT_EQ(pool.GetAllocationCount(), 1);
+  poolResource.deallocate(block, sizeof(Datum), alignof(Datum));
+  poolResource.deallocate(array, 10 * sizeof(Datum), alignof(Datum));
+  EXPECT_EQ(pool.GetAllocationCount(), 0);
+
+  // Frame containers are dropped with the frame
+  FRAMEALLOC().NextFrame();
+  {
+    std::pmr::vector<int> scratch(&FrameMemoryResource::GetInstance());
+    scratch.resize(256, 7);
+    EXPECT_GE(FRAMEALLOC().GetHighWaterMark(), 256 * sizeof(int));
+  }
+
+  BufferedFrameAllocator arena(4096);
+  BufferedFrameMemoryResource arenaResource(arena);
+  std::pmr::vector<int> buffered(&arenaResource);
+  buffered.assign(100, 3);
+  arena.NextFrame();
+  EXPECT_EQ(buffered[99], 3);
+}
+
+TEST(MemoryManagerTests, HandlePool)
+{
+  HandlePool<std::string> pool(4);
+
+  Handle<std::string> null;
+  EXPECT_TRUE(null.IsNull());
+  EXPECT_EQ(pool.Get(null), nullptr);
+
+  std::vector<Handle<std::string>> handles;
+  for(int i = 0; i < 10; ++i)
+    handles.push_back(pool.Create("object " + std::to_string(i)));
+  EXPECT_EQ(pool.GetCount(), 10);
+  EXPECT_GE(pool.GetCapacity(), 10);
+  EXPECT_EQ(*pool.Get(handles[7]), "object 7");
+
+  // Stale handles resolve to nothing, even once the slot is reused
+  Handle<std::string> stale = handles[3];
+  EXPECT_TRUE(pool.Destroy(stale));
+  EXPECT_FALSE(pool.Destroy(stale));
+  EXPECT_EQ(pool.Get(stale), nullptr);
+
+  Handle<std::string> reused = pool.Create("reused");
+  EXPECT_EQ(reused.GetIndex(), stale.GetIndex());
+  EXPECT_NE(reused, stale);
+  EXPECT_EQ(pool.Get(stale), nullptr);
+  EXPECT_EQ(*pool.Get(reused), "reused");
+  handles[3] = reused;
+
+  // Punch holes and compact the survivors into a dense range
+  for(int i = 0; i < 10; i += 2)
+    pool.Destroy(handles[i]);
+  EXPECT_EQ(pool.GetCount(), 5);
+  EXPECT_EQ(pool.GetRange(), 10);
+
+  EXPECT_GT(pool.Compact(), 0);
+  EXPECT_EQ(pool.GetRange(), 5);
+  EXPECT_EQ(*pool.Get(handles[3]), "reused");
+  for(int i = 1; i < 10; i += 2){
+    EXPECT_NE(pool.Get(handles[i]), nullptr);
+    EXPECT_LT(pool.Get(handles[i]) - pool.GetData(), 5);
+  }
+
+  int visited = 0;
+  pool.ForEach([&visited](std::string& _object){
+    EXPECT_FALSE(_object.empty());
+    ++visited;
+  });
+  EXPECT_EQ(visited, 5);
+
+  pool.Clear();
+  EXPECT_EQ(pool.GetCount(), 0);
+  EXPECT_EQ(pool.Get(handles[1]), nullptr);
+}
+
+struct Reserved
+{
+  double  a[40];
+};
+
+TEST(MemoryManagerTests, PoolAllocatorReserve)
+{
+  // Blocks are carved off lazily, a batch at a time
+  PoolAllocator<Datum> allocator(1000);
+  Datum* first = allocator.Allocate();
+  Datum* second = allocator.Allocate();
+  EXPECT_EQ(second, first + 1);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), 998);
+
+  std::vector<Datum*> data{first, second};
+  for(int i = 2; i < 1000; ++i)
+    data.push_back(allocator.Allocate());
+  EXPECT_EQ(allocator.GetChunkCount(), 1);
+
+  // Reserved chunks count as free and can be trimmed away
+  allocator.Reserve(1500);
+  EXPECT_EQ(allocator.GetChunkCount(), 3);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), 2000);
+  data.push_back(allocator.Allocate());
+  EXPECT_EQ(allocator.GetChunkCount(), 3);
+  EXPECT_EQ(allocator.Trim(), 1);
+
+  for(Datum* datum : data)
+    allocator.Deallocate(datum);
+  EXPECT_EQ(allocator.Trim(), 1);
+  EXPECT_EQ(allocator.GetFreeAllocationCount(), 1000);
+
+  // Initial capacities are applied when a type is first allocated
+  MEMALLOC().SetInitialCapacity("Reserved", 5000);
+  Reserved* reserved = MEMALLOC().Allocate<Reserved>();
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<Reserved>(), 1);
+  MEMALLOC().Deallocate(reserved);
+  MEMALLOC().FlushThreadCache<Reserved>();
+  EXPECT_EQ(MEMALLOC().Trim<Reserved>(), 4);
+}
@@ -1,7 +1,18 @@
 #include <gtest/gtest.h>
 #include <Core/DataStructures/Queue.hpp>
-#include <Core/DataStructures/LockFreeQueue.hpp>
+#include <Core/DataStructures/EpochReclaimer.hpp>
+#include <Core/DataStructures/MPMCQueue.hpp>
+#include <Core/DataStructures/SPSCRing.hpp>
+#include <Core/DataStructures/WorkStealingDeque.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
 #include <thread>
+#include <vector>
 
 TEST(DataStructuresTests, QueueTests)
 {
@@ -56,31 +67,492 @@ TEST(DataStructuresTests, QueueTestsMultithreaded)
   popThread.join();
 }
 
-TEST(DataStructuresTests, LockFreeQueueTests)
+TEST(DataStructuresTests, QueueBatchTests)
 {
-  // Create variable to test
-  double par = 555.555;
+  psl::Queue<int> queue;
 
-  // Create a queue and see if it's empty
-  LockFreeQueue<double> lqueue;
-  EXPECT_TRUE(lqueue.Empty());
-  EXPECT_EQ(lqueue.Size(), 0);
+  // Nothing to pop, and a timed wait gives up
+  int element = -1;
+  EXPECT_FALSE(queue.TryPop(element));
+  EXPECT_FALSE(queue.TryPopFor(element, std::chrono::milliseconds(1)));
+  EXPECT_EQ(element, -1);
 
-  // Push a parameter and raw double into the queue
-  lqueue.Push(par);
-  lqueue.Push(333.333);
+  // Push a range in one go, pop the head, then drain the rest
+  std::vector<int> range = {1, 2, 3, 4};
+  queue.PushRange(range.begin(), range.end());
+  EXPECT_EQ(queue.Size(), 4);
+  EXPECT_TRUE(queue.TryPop(element));
+  EXPECT_EQ(element, 1);
 
-  // Queue should have 2 values and not be empty
-  EXPECT_EQ(lqueue.Size(), 2);
-  EXPECT_FALSE(lqueue.Empty());
+  std::vector<int> drained = {0};
+  EXPECT_EQ(queue.PopAll(drained), 3);
+  EXPECT_EQ(drained, std::vector<int>({0, 2, 3, 4}));
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.PopAll(drained), 0);
 
-  // Pop the parameter and see if it has the right value 
-  double ppar = lqueue.Pop();
+  // A timed wait wakes up as soon as something is pushed
+  std::thread pushThread([&queue]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    queue.Push(5);
+  });
+  EXPECT_TRUE(queue.TryPopFor(element, std::chrono::seconds(10)));
+  EXPECT_EQ(element, 5);
+  pushThread.join();
+}
+
+TEST(DataStructuresTests, MPMCQueueTests)
+{
+  // Capacity is rounded up to a power of two
+  psl::MPMCQueue<double> queue(3);
+  EXPECT_EQ(queue.Capacity(), 4);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.Size(), 0);
+
+  // Fill the queue, the next push should fail
+  double par = 555.555;
+  EXPECT_TRUE(queue.TryPush(par));
+  EXPECT_TRUE(queue.TryPush(333.333));
+  EXPECT_TRUE(queue.TryPush(1.0));
+  EXPECT_TRUE(queue.TryPush(2.0));
+  EXPECT_FALSE(queue.TryPush(3.0));
+  EXPECT_EQ(queue.Size(), 4);
+
+  // Pop in the pushed order
+  double ppar = 0.0;
+  EXPECT_TRUE(queue.TryPop(ppar));
   EXPECT_EQ(ppar, 555.555);
-  // Pop second parameter and see id it has the right value
-  EXPECT_EQ(lqueue.Pop(), 333.333);
+  EXPECT_TRUE(queue.TryPop(ppar));
+  EXPECT_EQ(ppar, 333.333);
+
+  // Wrap around the ring
+  EXPECT_TRUE(queue.TryPush(4.0));
+  EXPECT_TRUE(queue.TryPush(5.0));
+  for(double expected : {1.0, 2.0, 4.0, 5.0}){
+    EXPECT_TRUE(queue.TryPop(ppar));
+    EXPECT_EQ(ppar, expected);
+  }
 
   // The queue should be empty now
-  EXPECT_TRUE(lqueue.Empty());
-  EXPECT_EQ(lqueue.Size(), 0);
+  EXPECT_FALSE(queue.TryPop(ppar));
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(DataStructuresTests, MPMCQueueBatchTests)
+{
+  psl::MPMCQueue<int> queue(8);
+
+  // Only as many items as there is room for get pushed
+  std::vector<int> items = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  EXPECT_EQ(queue.TryPushBatch(items.data(), 5), 5);
+  EXPECT_EQ(queue.TryPushBatch(items.data() + 5, 5), 3);
+  EXPECT_EQ(queue.TryPushBatch(items.data() + 8, 2), 0);
+
+  int popped[16];
+  EXPECT_EQ(queue.TryPopBatch(popped, 3), 3);
+  EXPECT_EQ(queue.TryPopBatch(popped + 3, 16), 5);
+  EXPECT_EQ(queue.TryPopBatch(popped, 16), 0);
+  for(int i = 0; i < 8; ++i)
+    EXPECT_EQ(popped[i], i);
+}
+
+TEST(DataStructuresTests, MPMCQueueDestroysItems)
+{
+  // Items left in the queue are destroyed with it
+  auto item = std::make_shared<int>(42);
+  {
+    psl::MPMCQueue<std::shared_ptr<int>> queue(4);
+    queue.TryPush(item);
+    queue.TryPush(item);
+    std::shared_ptr<int> popped;
+    queue.TryPop(popped);
+    EXPECT_EQ(item.use_count(), 3);
+  }
+  EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(DataStructuresTests, MPMCQueueStress)
+{
+  // Producers push (producer, sequence) pairs, single items and batches mixed,
+  // consumers check nothing is lost or duplicated and that each producer's
+  // items come out in order. Meant to be run under ThreadSanitizer too.
+  constexpr int producers = 4;
+  constexpr int consumers = 4;
+  constexpr int itemsPerProducer = 50000;
+
+  psl::MPMCQueue<U64> queue(64);
+  std::vector<std::atomic<U8>> seen(producers * itemsPerProducer);
+  std::atomic<int> popped{0};
+  std::atomic<B8> failed{false};
+
+  std::vector<std::thread> threads;
+  for(int p = 0; p < producers; ++p){
+    threads.emplace_back([&queue, p]() {
+      U64 batch[8];
+      int i = 0;
+      while(i < itemsPerProducer){
+        if(i % 3 == 0){
+          int count = std::min(8, itemsPerProducer - i);
+          for(int j = 0; j < count; ++j)
+            batch[j] = (U64(p) << 32) | U64(i + j);
+          std::size_t pushed = queue.TryPushBatch(batch, count);
+          i += int(pushed);
+          if(pushed == 0)
+            std::this_thread::yield();
+        }
+        else if(queue.TryPush((U64(p) << 32) | U64(i)))
+          ++i;
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  for(int c = 0; c < consumers; ++c){
+    threads.emplace_back([&]() {
+      std::vector<I64> last(producers, -1);
+      U64 batch[8];
+      while(popped.load(std::memory_order_relaxed) < producers * itemsPerProducer){
+        std::size_t count = queue.TryPopBatch(batch, 1 + (last[0] & 7));
+        if(count == 0 && queue.TryPop(batch[0]))
+          count = 1;
+        if(count == 0){
+          std::this_thread::yield();
+          continue;
+        }
+
+        for(std::size_t j = 0; j < count; ++j){
+          int producer = int(batch[j] >> 32);
+          I64 sequence = I64(batch[j] & 0xffffffff);
+          if(sequence <= last[producer])
+            failed = true;
+          last[producer] = sequence;
+          if(seen[producer * itemsPerProducer + sequence].fetch_add(1) != 0)
+            failed = true;
+        }
+        popped.fetch_add(int(count), std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for(std::thread& thread : threads)
+    thread.join();
+
+  EXPECT_FALSE(failed);
+  EXPECT_EQ(popped.load(), producers * itemsPerProducer);
+  for(const std::atomic<U8>& count : seen)
+    ASSERT_EQ(count.load(), 1);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(DataStructuresTests, WorkStealingDequeTests)
+{
+  psl::WorkStealingDeque<int> deque(2);
+  int item = 0;
+  EXPECT_TRUE(deque.Empty());
+  EXPECT_FALSE(deque.TryPop(item));
+  EXPECT_FALSE(deque.TrySteal(item));
+
+  // Growing keeps every item
+  for(int i = 0; i < 100; ++i)
+    deque.Push(i);
+  EXPECT_EQ(deque.Size(), 100);
+  EXPECT_GE(deque.Capacity(), 100);
+
+  // The owner works from the newest end, thieves from the oldest
+  ASSERT_TRUE(deque.TryPop(item));
+  EXPECT_EQ(item, 99);
+  ASSERT_TRUE(deque.TrySteal(item));
+  EXPECT_EQ(item, 0);
+  ASSERT_TRUE(deque.TrySteal(item));
+  EXPECT_EQ(item, 1);
+  ASSERT_TRUE(deque.TryPop(item));
+  EXPECT_EQ(item, 98);
+
+  int expected = 97;
+  while(deque.TryPop(item))
+    EXPECT_EQ(item, expected--);
+  EXPECT_EQ(expected, 1);
+  EXPECT_TRUE(deque.Empty());
+
+  // Reusable once drained
+  deque.Push(7);
+  ASSERT_TRUE(deque.TrySteal(item));
+  EXPECT_EQ(item, 7);
+  EXPECT_FALSE(deque.TryPop(item));
+}
+
+TEST(DataStructuresTests, WorkStealingDequeStress)
+{
+  // The owner pushes and pops in random runs while thieves steal, starting
+  // from a tiny ring so it grows under them. Every item has to be taken
+  // exactly once, and each thief has to see its items in push order. Runs
+  // a few seeds to shake out different interleavings; meant to be run under
+  // ThreadSanitizer too.
+  constexpr int thieves = 3;
+  constexpr int items = 100000;
+
+  for(U32 seed = 1; seed <= 4; ++seed){
+    psl::WorkStealingDeque<int> deque(2);
+    std::vector<std::atomic<U8>> taken(items);
+    std::atomic<int> done{0};
+    std::atomic<B8> failed{false};
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < thieves; ++t){
+      threads.emplace_back([&]() {
+        int last = -1;
+        int item;
+        while(done.load(std::memory_order_relaxed) < items){
+          if(!deque.TrySteal(item)){
+            std::this_thread::yield();
+            continue;
+          }
+          if(item <= last)
+            failed = true;
+          last = item;
+          if(taken[item].fetch_add(1) != 0)
+            failed = true;
+          done.fetch_add(1, std::memory_order_relaxed);
+        }
+      });
+    }
+
+    std::mt19937 random(seed);
+    int next = 0;
+    int item;
+    while(done.load(std::memory_order_relaxed) < items){
+      int pushes = next < items ? int(random() % 16) : 0;
+      for(int i = 0; i < pushes && next < items; ++i)
+        deque.Push(next++);
+
+      int pops = int(random() % 12);
+      for(int i = 0; i < pops && deque.TryPop(item); ++i){
+        if(taken[item].fetch_add(1) != 0)
+          failed = true;
+        done.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    for(std::thread& thread : threads)
+      thread.join();
+
+    EXPECT_FALSE(failed) << "seed " << seed;
+    for(const std::atomic<U8>& count : taken)
+      ASSERT_EQ(count.load(), 1) << "seed " << seed;
+    EXPECT_TRUE(deque.Empty());
+  }
+}
+
+TEST(DataStructuresTests, SPSCRingTests)
+{
+  psl::SPSCRing ring(128);
+  EXPECT_EQ(ring.Capacity(), 128);
+  EXPECT_TRUE(ring.Empty());
+
+  std::size_t size = 0;
+  EXPECT_EQ(ring.BeginRead(size), nullptr);
+
+  // Write a record in place, using less than was reserved
+  char* text = static_cast<char*>(ring.BeginWrite(64));
+  ASSERT_NE(text, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(text) % psl::SPSCRing::RecordAlignment, 0);
+  int length = std::snprintf(text, 64, "frame %d", 42);
+  ring.CommitWrite(length);
+
+  double value = 555.555;
+  EXPECT_TRUE(ring.TryWrite(&value, sizeof(value)));
+  EXPECT_FALSE(ring.Empty());
+
+  // Records come out in order with their sizes
+  const char* read = static_cast<const char*>(ring.BeginRead(size));
+  ASSERT_NE(read, nullptr);
+  EXPECT_EQ(std::string(read, size), "frame 42");
+  ring.EndRead();
+
+  EXPECT_TRUE(ring.TryRead([](const void* _data, std::size_t _size) {
+    EXPECT_EQ(_size, sizeof(double));
+    EXPECT_EQ(*static_cast<const double*>(_data), 555.555);
+  }));
+  EXPECT_TRUE(ring.Empty());
+
+  // Too big for the ring
+  EXPECT_EQ(ring.BeginWrite(128), nullptr);
+
+  // Wrap around: 32 bytes are used so far, a 64 byte record fits before the
+  // end but the next one has to skip the last 32 bytes and start over
+  U8 block[56] = {};
+  EXPECT_TRUE(ring.TryWrite(block, sizeof(block)));
+  EXPECT_TRUE(ring.TryRead([](const void*, std::size_t) {}));
+  block[0] = 7;
+  EXPECT_TRUE(ring.TryWrite(block, sizeof(block)));
+
+  // The skipped bytes count as used, so the ring is full now
+  EXPECT_FALSE(ring.TryWrite(block, sizeof(block)));
+  EXPECT_TRUE(ring.TryRead([](const void* _data, std::size_t _size) {
+    EXPECT_EQ(_size, 56);
+    EXPECT_EQ(static_cast<const U8*>(_data)[0], 7);
+  }));
+  EXPECT_TRUE(ring.Empty());
+}
+
+TEST(DataStructuresTests, SPSCRingStress)
+{
+  // One producer writes records of varying sizes filled with their sequence
+  // number, one consumer checks they arrive whole and in order. Meant to be
+  // run under ThreadSanitizer too.
+  constexpr U32 records = 200000;
+  psl::SPSCRing ring(1024);
+
+  std::thread producer([&ring]() {
+    U32 sequence = 0;
+    while(sequence < records){
+      std::size_t size = sizeof(U32) * (1 + sequence % 13);
+      U32* record = static_cast<U32*>(ring.BeginWrite(size));
+      if(!record){
+        std::this_thread::yield();
+        continue;
+      }
+      for(std::size_t i = 0; i < size / sizeof(U32); ++i)
+        record[i] = sequence;
+      ring.CommitWrite();
+      ++sequence;
+    }
+  });
+
+  B8 failed = false;
+  U32 expected = 0;
+  while(expected < records){
+    B8 read = ring.TryRead([&](const void* _data, std::size_t _size) {
+      const U32* record = static_cast<const U32*>(_data);
+      if(_size != sizeof(U32) * (1 + expected % 13))
+        failed = true;
+      for(std::size_t i = 0; i < _size / sizeof(U32); ++i)
+        if(record[i] != expected)
+          failed = true;
+      ++expected;
+    });
+    if(!read)
+      std::this_thread::yield();
+  }
+
+  producer.join();
+  EXPECT_FALSE(failed);
+  EXPECT_TRUE(ring.Empty());
+}
+
+namespace
+{
+/// Node of the Treiber stack the reclamation tests run on
+struct EpochTestNode
+{
+  U64 m_value;
+  EpochTestNode* m_next;
+};
+
+/// Counts the nodes destroyed so far
+std::atomic<int> g_epochTestFreed{0};
+
+void FreeEpochTestNode(void* _node)
+{
+  MEMALLOC().Destroy(static_cast<EpochTestNode*>(_node));
+  g_epochTestFreed.fetch_add(1);
+}
+}
+
+TEST(DataStructuresTests, EpochReclaimerTests)
+{
+  // A node retired while another thread is pinned stays alive until that
+  // thread leaves its guard
+  std::atomic<int> stage{0};
+  std::thread reader([&stage]() {
+    EPOCH().RegisterThread();
+    {
+      EpochGuard guard;
+      stage = 1;
+      while(stage.load() != 2)
+        std::this_thread::yield();
+    }
+    stage = 3;
+    while(stage.load() != 4)
+      std::this_thread::yield();
+    EPOCH().UnregisterThread();
+  });
+  while(stage.load() != 1)
+    std::this_thread::yield();
+
+  int freedBefore = g_epochTestFreed.load();
+  EPOCH().Retire(MEMALLOC().Create<EpochTestNode>(EpochTestNode{1, nullptr}), FreeEpochTestNode);
+  for(int i = 0; i < 4; ++i)
+    EPOCH().Collect();
+  EXPECT_EQ(g_epochTestFreed.load(), freedBefore);
+
+  stage = 2;
+  while(stage.load() != 3)
+    std::this_thread::yield();
+  for(int i = 0; i < 4; ++i)
+    EPOCH().Collect();
+  EXPECT_EQ(g_epochTestFreed.load(), freedBefore + 1);
+
+  stage = 4;
+  reader.join();
+
+  // Draining frees whatever is retired, however recent
+  EPOCH().Retire(MEMALLOC().Create<EpochTestNode>(EpochTestNode{2, nullptr}), FreeEpochTestNode);
+  EXPECT_GE(EPOCH().DrainAll(), 1u);
+  EXPECT_EQ(g_epochTestFreed.load(), freedBefore + 2);
+  EXPECT_EQ(EPOCH().GetPendingCount(), 0);
+}
+
+TEST(DataStructuresTests, EpochReclaimerStress)
+{
+  // Threads push and pop on a Treiber stack, popped nodes are retired and
+  // recycled through the pool while the others may still be reading them.
+  // Meant to be run under ThreadSanitizer and AddressSanitizer too.
+  constexpr int threadCount = 4;
+  constexpr int operations = 20000;
+
+  std::atomic<EpochTestNode*> head{nullptr};
+  std::atomic<U64> pushedSum{0};
+  std::atomic<U64> poppedSum{0};
+
+  std::vector<std::thread> threads;
+  for(int t = 0; t < threadCount; ++t){
+    threads.emplace_back([&, t]() {
+      for(int i = 0; i < operations; ++i){
+        EpochGuard guard;
+        if(i % 2 == 0){
+          U64 value = U64(t) * operations + i + 1;
+          EpochTestNode* node = MEMALLOC().Create<EpochTestNode>(EpochTestNode{value, nullptr});
+          node->m_next = head.load(std::memory_order_relaxed);
+          while(!head.compare_exchange_weak(node->m_next, node, std::memory_order_release, std::memory_order_relaxed));
+          pushedSum.fetch_add(value);
+        }
+        else{
+          EpochTestNode* node = head.load(std::memory_order_acquire);
+          while(node && !head.compare_exchange_weak(node, node->m_next, std::memory_order_acquire));
+          if(node){
+            poppedSum.fetch_add(node->m_value);
+            EPOCH().Retire(node);
+          }
+        }
+      }
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+
+  // Whatever is left on the stack accounts for the rest of the sum
+  for(EpochTestNode* node = head.load(); node != nullptr;){
+    EpochTestNode* next = node->m_next;
+    poppedSum += node->m_value;
+    MEMALLOC().Destroy(node);
+    node = next;
+  }
+  EXPECT_EQ(pushedSum.load(), poppedSum.load());
+
+  // Nothing is pinned now, so a few collections free every retired node
+  for(int i = 0; i < 4; ++i)
+    EPOCH().Collect();
+  EXPECT_EQ(EPOCH().GetPendingCount(), 0);
+  EXPECT_EQ(MEMALLOC().GetAllocationCount<EpochTestNode>(), 0);
 }
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <Core/DataStructures/SmallVector.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+TEST(SmallVectorTests, InlineThenSpilled)
+{
+  SmallVector<U32, 4> vector;
+  EXPECT_TRUE(vector.Empty());
+  EXPECT_TRUE(vector.IsInline());
+  EXPECT_EQ(vector.Capacity(), 4);
+
+  // The first four stay inside the vector
+  for(U32 i = 0; i < 4; ++i)
+    vector.PushBack(i);
+  EXPECT_TRUE(vector.IsInline());
+  EXPECT_EQ(vector.Size(), 4);
+
+  // The fifth spills them all
+  vector.PushBack(4);
+  EXPECT_FALSE(vector.IsInline());
+  EXPECT_GE(vector.Capacity(), 5);
+
+  for(U32 i = 5; i < 100; ++i)
+    vector.EmplaceBack(i);
+  ASSERT_EQ(vector.Size(), 100);
+  U32 expected = 0;
+  for(U32 value : vector)
+    EXPECT_EQ(value, expected++);
+  EXPECT_EQ(vector.Front(), 0);
+  EXPECT_EQ(vector.Back(), 99);
+
+  // Erasing keeps the order
+  vector.Erase(vector.begin() + 10);
+  EXPECT_EQ(vector[10], 11);
+  vector.PopBack();
+  EXPECT_EQ(vector.Back(), 98);
+  EXPECT_EQ(vector.Size(), 98);
+
+  vector.Clear();
+  EXPECT_TRUE(vector.Empty());
+  EXPECT_FALSE(vector.IsInline());
+}
+
+TEST(SmallVectorTests, PushingOwnElement)
+{
+  // The element being copied lives in the storage the vector is leaving
+  SmallVector<std::string, 2> vector{"first", "second"};
+  EXPECT_TRUE(vector.IsInline());
+  vector.PushBack(vector[0]);
+  vector.PushBack(vector.Back());
+  ASSERT_EQ(vector.Size(), 4);
+  EXPECT_EQ(vector[2], "first");
+  EXPECT_EQ(vector[3], "first");
+}
+
+TEST(SmallVectorTests, OwnershipAndCopies)
+{
+  auto counter = std::make_shared<int>(0);
+  {
+    SmallVector<std::shared_ptr<int>, 2> inlined;
+    inlined.PushBack(counter);
+    SmallVector<std::shared_ptr<int>, 2> spilled;
+    for(int i = 0; i < 5; ++i)
+      spilled.PushBack(counter);
+    EXPECT_EQ(counter.use_count(), 7);
+
+    // Copies share nothing with the original
+    SmallVector<std::shared_ptr<int>, 2> copy(spilled);
+    EXPECT_EQ(counter.use_count(), 12);
+    copy = inlined;
+    EXPECT_EQ(counter.use_count(), 8);
+    EXPECT_EQ(copy.Size(), 1);
+
+    // Moving a spilled vector takes its block, moving an inline one moves
+    // the elements
+    SmallVector<std::shared_ptr<int>, 2> moved(std::move(spilled));
+    EXPECT_TRUE(spilled.Empty());
+    EXPECT_FALSE(moved.IsInline());
+    EXPECT_EQ(moved.Size(), 5);
+    moved = std::move(inlined);
+    EXPECT_TRUE(inlined.Empty());
+    EXPECT_TRUE(moved.IsInline());
+    EXPECT_EQ(moved.Size(), 1);
+    EXPECT_EQ(counter.use_count(), 3);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+namespace
+{
+/// Throws from its copy constructor once the countdown runs out
+struct ThrowingCopy
+{
+  static inline int s_copiesLeft = -1;
+  static inline int s_live = 0;
+
+  ThrowingCopy() { ++s_live; };
+  ThrowingCopy(const ThrowingCopy&)
+  {
+    if(s_copiesLeft == 0)
+      throw std::runtime_error("copy failed");
+    --s_copiesLeft;
+    ++s_live;
+  };
+  ~ThrowingCopy() { --s_live; };
+};
+}
+
+TEST(SmallVectorTests, CopyThrows)
+{
+  using Vector = SmallVector<ThrowingCopy, 2>;
+  {
+    Vector source;
+    for(int i = 0; i < 8; ++i)
+      source.EmplaceBack();
+
+    // The spilled block is given back, run under AddressSanitizer to see it
+    ThrowingCopy::s_copiesLeft = 5;
+    EXPECT_THROW(Vector copy(source), std::runtime_error);
+    EXPECT_EQ(ThrowingCopy::s_live, 8);
+
+    // The target of a failed assignment is left empty
+    Vector target;
+    target.EmplaceBack();
+    ThrowingCopy::s_copiesLeft = 5;
+    EXPECT_THROW(target = source, std::runtime_error);
+    EXPECT_TRUE(target.Empty());
+    EXPECT_TRUE(target.IsInline());
+    EXPECT_EQ(ThrowingCopy::s_live, 8);
+
+    ThrowingCopy::s_copiesLeft = -1;
+    target = source;
+    EXPECT_EQ(target.Size(), 8);
+  }
+  EXPECT_EQ(ThrowingCopy::s_live, 0);
+}
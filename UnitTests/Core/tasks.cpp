@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <Core/Threads/TaskManager.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace psge;
+
+namespace
+{
+/// The task manager is a singleton, every test shares its workers
+TaskManager& GetTaskManager()
+{
+  TaskManager& manager = TaskManager::GetInstance();
+  manager.Initialize(4);
+  return manager;
+}
+}
+
+TEST(TaskManagerTests, RegisteredGraph)
+{
+  TaskManager& manager = GetTaskManager();
+
+  // Registered tasks stay with the singleton, so they only touch state they
+  // share ownership of
+  struct Order
+  {
+    std::atomic<U32> m_clock{0};
+    std::atomic<U32> m_root{0}, m_left{0}, m_right{0}, m_join{0};
+    std::atomic<U32> m_runs{0};
+    std::atomic<B8>  m_wrongOrder{false};
+  };
+  auto order = std::make_shared<Order>();
+
+  // A diamond: root, then left and right, then join
+  auto root  = std::make_shared<Task>([order](){ order->m_root = ++order->m_clock; order->m_runs++; });
+  auto left  = std::make_shared<Task>([order](){ order->m_left = ++order->m_clock; order->m_runs++; });
+  auto right = std::make_shared<Task>([order](){ order->m_right = ++order->m_clock; order->m_runs++; });
+  auto join  = std::make_shared<Task>([order](){
+    order->m_join = ++order->m_clock;
+    order->m_runs++;
+    if(order->m_left == 0 || order->m_right == 0)
+      order->m_wrongOrder = true;
+  });
+  left->AddDependency(root);
+  right->AddDependency(root);
+  join->AddDependency(left);
+  join->AddDependency(right);
+
+  manager.RegisterTask(root);
+  manager.RegisterTask(left);
+  manager.RegisterTask(right);
+  manager.RegisterTask(join);
+
+  constexpr U32 frames = 50;
+  for(U32 frame = 0; frame < frames; ++frame){
+    order->m_left = 0;
+    order->m_right = 0;
+    manager.Update(0.016f);
+    manager.Wait();
+
+    EXPECT_TRUE(root->IsComplete());
+    EXPECT_TRUE(join->IsComplete());
+    EXPECT_LT(order->m_root, order->m_left);
+    EXPECT_LT(order->m_root, order->m_right);
+    EXPECT_LT(order->m_left, order->m_join);
+    EXPECT_LT(order->m_right, order->m_join);
+  }
+  EXPECT_FALSE(order->m_wrongOrder);
+  EXPECT_EQ(order->m_runs, 4 * frames);
+}
+
+TEST(TaskManagerTests, SubmitFromManyThreads)
+{
+  TaskManager& manager = GetTaskManager();
+
+  // More tasks than the injection queue holds, from threads outside the pool
+  constexpr U32 submitters = 4;
+  constexpr U32 perSubmitter = 4 * TASK_INJECTION_CAPACITY;
+  std::vector<std::atomic<U32>> runs(submitters * perSubmitter);
+
+  std::vector<std::thread> threads;
+  for(U32 submitter = 0; submitter < submitters; ++submitter){
+    threads.emplace_back([&, submitter](){
+      for(U32 i = 0; i < perSubmitter; ++i){
+        U32 index = submitter * perSubmitter + i;
+        manager.Submit(std::make_shared<Task>([&runs, index](){ runs[index]++; }));
+      }
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+  manager.Wait();
+
+  U32 wrong = 0;
+  for(const std::atomic<U32>& count : runs)
+    wrong += count != 1;
+  EXPECT_EQ(wrong, 0);
+
+  // Let go of the finished tasks
+  manager.Update(0.016f);
+  manager.Wait();
+}
+
+TEST(TaskManagerTests, SubmittedFanOut)
+{
+  TaskManager& manager = GetTaskManager();
+
+  // The dependents are made ready on a worker, so they go to its deque and
+  // the other workers have to steal them
+  constexpr U32 dependents = 5000;
+  std::atomic<B8> rootDone{false};
+  std::atomic<U32> runs{0};
+  std::atomic<U32> tooEarly{0};
+
+  auto root = std::make_shared<Task>([&](){ rootDone = true; });
+  for(U32 i = 0; i < dependents; ++i){
+    auto dependent = std::make_shared<Task>([&](){
+      if(!rootDone)
+        tooEarly++;
+      runs++;
+    });
+    dependent->AddDependency(root);
+  }
+
+  // Only the root can be submitted
+  auto dependent = std::make_shared<Task>([](){});
+  dependent->AddDependency(root);
+  manager.Submit(dependent);
+
+  manager.Submit(root);
+  manager.Wait();
+
+  EXPECT_EQ(runs, dependents);
+  EXPECT_EQ(tooEarly, 0);
+  EXPECT_TRUE(dependent->IsComplete());
+
+  manager.Update(0.016f);
+  manager.Wait();
+}
+
+TEST(TaskManagerTests, FanOutFromTask)
+{
+  TaskManager& manager = GetTaskManager();
+
+  // Let the workers fall asleep, they then have to be woken by the tasks a
+  // worker pushes to its own deque
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  constexpr U32 children = 2000;
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<U32> runs{0};
+
+  manager.Submit(std::make_shared<Task>([&](){
+    for(U32 i = 0; i < children; ++i){
+      manager.Submit(std::make_shared<Task>([&](){
+        // Long enough for the others to steal
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+        while(std::chrono::steady_clock::now() < until){}
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          threads.insert(std::this_thread::get_id());
+        }
+        runs++;
+      }));
+    }
+
+    // Would wait for itself
+    manager.Wait();
+  }));
+  manager.Wait();
+
+  EXPECT_EQ(runs, children);
+  EXPECT_GT(threads.size(), 1u);
+
+  manager.Update(0.016f);
+  manager.Wait();
+}
+
+TEST(TaskManagerTests, TasksSubmitWhileDispatched)
+{
+  TaskManager& manager = GetTaskManager();
+
+  // More roots than the injection queue holds, so Update() runs some of them
+  // itself, and those submit more tasks
+  struct Counts
+  {
+    std::atomic<U32> m_roots{0};
+    std::atomic<U32> m_submitted{0};
+  };
+  auto counts = std::make_shared<Counts>();
+
+  constexpr U32 roots = 2 * TASK_INJECTION_CAPACITY;
+  for(U32 i = 0; i < roots; ++i){
+    manager.RegisterTask(std::make_shared<Task>([counts, &manager](){
+      counts->m_roots++;
+      manager.Submit(std::make_shared<Task>([counts](){ counts->m_submitted++; }));
+    }));
+  }
+
+  manager.Update(0.016f);
+  manager.Wait();
+  EXPECT_EQ(counts->m_roots, roots);
+  EXPECT_EQ(counts->m_submitted, roots);
+}